@@ -0,0 +1,298 @@
+/* Microbenchmarks of the hot paths
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <cstring>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "common/BlockSum.h"
+#include "common/Ctx.h"
+#include "common/FlatMap.h"
+#include "common/RuntimeException.h"
+#include "common/Timer.h"
+#include "common/types.h"
+#include "common/typeXid.h"
+
+namespace OpenLogReplicator {
+    static void report(Ctx& ctx, const std::string& test, const std::string& variant, uint64_t bytes, uint64_t ops, time_t timeUs) {
+        if (timeUs == 0)
+            timeUs = 1;
+        std::string throughput;
+        if (bytes > 0)
+            throughput = std::to_string(bytes / timeUs) + " MB/s, ";
+        ctx.info(0, test + " " + variant + ": " + std::to_string(timeUs / 1000) + " ms, " + throughput +
+                 std::to_string(ops * 1000 / timeUs) + " kops/s");
+    }
+
+    static void benchChecksum(Ctx& ctx, uint64_t blockSize, uint64_t rounds) {
+        const uint64_t blocks = 32 * 1024 * 1024 / blockSize;
+        std::vector<uint64_t> data(blocks * blockSize / sizeof(uint64_t));
+        auto* buffer = reinterpret_cast<uint8_t*>(data.data());
+
+        uint64_t state = 1;
+        for (uint64_t& word : data) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            word = state;
+        }
+        // Store the checksum of every block, so that all blocks verify correctly
+        for (uint64_t numBlock = 0; numBlock < blocks; ++numBlock) {
+            uint8_t* block = buffer + numBlock * blockSize;
+            block[14] = 0;
+            block[15] = 0;
+            uint64_t sum = BlockSum::fold(BlockSum::sumXorScalar(block, blockSize));
+            ctx.write16(block + 14, static_cast<uint16_t>(sum));
+        }
+
+        std::vector<std::pair<const char*, BlockSum::verifyType>> kernels;
+        kernels.emplace_back("scalar", BlockSum::verifyScalar);
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            kernels.emplace_back("avx2", BlockSum::verifyAvx2);
+        if (__builtin_cpu_supports("avx512f"))
+            kernels.emplace_back("avx512", BlockSum::verifyAvx512);
+#endif
+#if defined(__aarch64__)
+        kernels.emplace_back("neon", BlockSum::verifyNeon);
+#endif
+
+        ctx.info(0, "checksum: block size: " + std::to_string(blockSize) + ", blocks: " + std::to_string(blocks) + ", rounds: " +
+                 std::to_string(rounds) + ", selected: " + BlockSum::name);
+        // Every kernel must stop at the first damaged block, also inside and at the end of a group of blocks verified together
+        const uint64_t damaged[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 15, 16, 17, blocks - 2, blocks - 1};
+        for (auto& kernel: kernels) {
+            uint64_t verified = kernel.second(buffer, blockSize, blocks);
+            if (verified != blocks)
+                throw RuntimeException(10072, "checksum: " + std::string(kernel.first) + " kernel returned " + std::to_string(verified) +
+                                       " valid blocks, expected: " + std::to_string(blocks));
+
+            for (uint64_t numBlock : damaged) {
+                buffer[numBlock * blockSize + 100] ^= 0x01;
+                verified = kernel.second(buffer, blockSize, blocks);
+                buffer[numBlock * blockSize + 100] ^= 0x01;
+                if (verified != numBlock)
+                    throw RuntimeException(10072, "checksum: " + std::string(kernel.first) + " kernel returned " + std::to_string(verified) +
+                                           " valid blocks, expected: " + std::to_string(numBlock));
+            }
+        }
+
+        for (auto& kernel: kernels) {
+            time_t start = Timer::getTime();
+            uint64_t verified = 0;
+            for (uint64_t round = 0; round < rounds; ++round)
+                verified += kernel.second(buffer, blockSize, blocks);
+            report(ctx, "checksum", kernel.first, verified * blockSize, verified, Timer::getTime() - start);
+        }
+    }
+
+    // Operation mix of transaction lookups: 70% hits, 20% misses, 10% commit of an open transaction and start of a new one
+    template <typename Container, typename Key, bool IsMap>
+    static uint64_t lookupMix(Ctx& ctx, const std::string& variant, uint64_t open, uint64_t operations) {
+        std::mt19937_64 random(1);
+        Container container;
+        std::vector<Key> keys;
+        uint64_t sqn = 0;
+        auto nextKey = [&sqn]() -> Key {
+            ++sqn;
+            typeXid xid(static_cast<typeUsn>(1 + sqn % 1000), static_cast<typeSlt>((sqn / 1000) % 48), static_cast<typeSqn>(sqn));
+            if constexpr (std::is_same<Key, typeXid>::value)
+                return xid;
+            else
+                return xid.getData() >> 32 | (static_cast<uint64_t>(sqn % 4) << 32);
+        };
+        auto insertKey = [&container](const Key& key, uint64_t value) {
+            if constexpr (IsMap)
+                container[key] = value;
+            else
+                container.insert(key);
+        };
+
+        for (uint64_t i = 0; i < open; ++i) {
+            keys.push_back(nextKey());
+            insertKey(keys.back(), i);
+        }
+
+        time_t start = Timer::getTime();
+        uint64_t found = 0;
+        for (uint64_t i = 0; i < operations; ++i) {
+            uint64_t op = random() % 10;
+            uint64_t pos = random() % keys.size();
+            if (op < 7) {
+                found += container.count(keys[pos]);
+            } else if (op < 9) {
+                // Transaction from a different container id, never open
+                Key key = keys[pos];
+                if constexpr (std::is_same<Key, typeXid>::value)
+                    key = typeXid(key.getData() ^ 0x8000000000000000ULL);
+                else
+                    key ^= 0x8000000000000000ULL;
+                found += container.count(key);
+            } else {
+                container.erase(keys[pos]);
+                keys[pos] = nextKey();
+                insertKey(keys[pos], i);
+            }
+        }
+        report(ctx, "flatmap", variant, 0, operations, Timer::getTime() - start);
+        return found + container.size();
+    }
+
+    static void benchFlatMap(Ctx& ctx, uint64_t open, uint64_t operations) {
+        ctx.info(0, "flatmap: open transactions: " + std::to_string(open) + ", operations: " + std::to_string(operations));
+
+        uint64_t result1 = lookupMix<FlatMap<typeXidMap, uint64_t>, typeXidMap, true>(ctx, "FlatMap<typeXidMap>", open, operations);
+        uint64_t result2 = lookupMix<std::unordered_map<typeXidMap, uint64_t>, typeXidMap, true>(ctx, "std::unordered_map<typeXidMap>",
+                                                                                                   open, operations);
+        uint64_t result3 = lookupMix<FlatSet<typeXid>, typeXid, false>(ctx, "FlatSet<typeXid>", open, operations);
+        uint64_t result4 = lookupMix<std::set<typeXid>, typeXid, false>(ctx, "std::set<typeXid>", open, operations);
+
+        if (result1 != result2 || result3 != result4)
+            throw RuntimeException(10075, "flatmap: results differ: " + std::to_string(result1) + "/" + std::to_string(result2) + "/" +
+                                   std::to_string(result3) + "/" + std::to_string(result4));
+    }
+
+    // Accessors called through function pointers, as they were called before they were inlined
+    struct EndianFunctions {
+        uint16_t (*read16)(const uint8_t* buf);
+        uint32_t (*read32)(const uint8_t* buf);
+        uint64_t (*read56)(const uint8_t* buf);
+        uint64_t (*read64)(const uint8_t* buf);
+        typeScn (*readScn)(const uint8_t* buf);
+        void (*write16)(uint8_t* buf, uint16_t val);
+        void (*write32)(uint8_t* buf, uint32_t val);
+        void (*write56)(uint8_t* buf, uint64_t val);
+        void (*write64)(uint8_t* buf, uint64_t val);
+    };
+
+    static uint64_t endianInline(Ctx& ctx, const Ctx& accessCtx, const std::string& variant, uint8_t* buffer, uint64_t size, uint64_t rounds) {
+        time_t start = Timer::getTime();
+        uint64_t sum = 0;
+        for (uint64_t round = 0; round < rounds; ++round) {
+            for (uint8_t* pos = buffer; pos + 32 <= buffer + size; pos += 32)
+                sum += accessCtx.read16(pos) + accessCtx.read32(pos + 2) + accessCtx.read56(pos + 6) + accessCtx.read64(pos + 16) +
+                        accessCtx.readScn(pos + 24);
+            for (uint8_t* pos = buffer; pos + 32 <= buffer + size; pos += 32) {
+                accessCtx.write16(pos, static_cast<uint16_t>(sum));
+                accessCtx.write32(pos + 2, static_cast<uint32_t>(sum));
+                accessCtx.write56(pos + 6, sum);
+                accessCtx.write64(pos + 16, sum);
+                ++sum;
+            }
+        }
+        report(ctx, "endian", variant, rounds * size * 2, rounds * size / 32 * 9, Timer::getTime() - start);
+        return sum;
+    }
+
+    static uint64_t endianPointer(Ctx& ctx, const EndianFunctions& functions, const std::string& variant, uint8_t* buffer, uint64_t size,
+                                  uint64_t rounds) {
+        time_t start = Timer::getTime();
+        uint64_t sum = 0;
+        for (uint64_t round = 0; round < rounds; ++round) {
+            for (uint8_t* pos = buffer; pos + 32 <= buffer + size; pos += 32)
+                sum += functions.read16(pos) + functions.read32(pos + 2) + functions.read56(pos + 6) + functions.read64(pos + 16) +
+                        functions.readScn(pos + 24);
+            for (uint8_t* pos = buffer; pos + 32 <= buffer + size; pos += 32) {
+                functions.write16(pos, static_cast<uint16_t>(sum));
+                functions.write32(pos + 2, static_cast<uint32_t>(sum));
+                functions.write56(pos + 6, sum);
+                functions.write64(pos + 16, sum);
+                ++sum;
+            }
+        }
+        report(ctx, "endian", variant, rounds * size * 2, rounds * size / 32 * 9, Timer::getTime() - start);
+        return sum;
+    }
+
+    static void benchEndian(Ctx& ctx, uint64_t rounds) {
+        // Fits in the cache, so that the cost of the access is measured and not the memory bandwidth
+        const uint64_t size = 1024 * 1024;
+        std::vector<uint8_t> buffer(size);
+        Ctx ctxBig;
+        ctxBig.setBigEndian();
+
+        static const EndianFunctions functionsLittle = {Ctx::read16Little, Ctx::read32Little, Ctx::read56Little, Ctx::read64Little,
+                                                        Ctx::readScnLittle, Ctx::write16Little, Ctx::write32Little, Ctx::write56Little,
+                                                        Ctx::write64Little};
+        static const EndianFunctions functionsBig = {Ctx::read16Big, Ctx::read32Big, Ctx::read56Big, Ctx::read64Big, Ctx::readScnBig,
+                                                     Ctx::write16Big, Ctx::write32Big, Ctx::write56Big, Ctx::write64Big};
+        // Read through volatile pointers, so that the compiler can't resolve the calls at compile time
+        const EndianFunctions* volatile little = &functionsLittle;
+        const EndianFunctions* volatile big = &functionsBig;
+
+        ctx.info(0, "endian: buffer: " + std::to_string(size / 1024 / 1024) + " MB, rounds: " + std::to_string(rounds));
+        uint64_t result[4];
+        memset(buffer.data(), 0, size);
+        result[0] = endianInline(ctx, ctx, "inline little", buffer.data(), size, rounds);
+        memset(buffer.data(), 0, size);
+        result[1] = endianPointer(ctx, *little, "pointer little", buffer.data(), size, rounds);
+        memset(buffer.data(), 0, size);
+        result[2] = endianInline(ctx, ctxBig, "inline big", buffer.data(), size, rounds);
+        memset(buffer.data(), 0, size);
+        result[3] = endianPointer(ctx, *big, "pointer big", buffer.data(), size, rounds);
+
+        if (result[0] != result[1] || result[2] != result[3])
+            throw RuntimeException(10077, "endian: results differ: " + std::to_string(result[0]) + "/" + std::to_string(result[1]) + "/" +
+                                   std::to_string(result[2]) + "/" + std::to_string(result[3]));
+    }
+}
+
+int main(int argc, char** argv) {
+    OpenLogReplicator::Ctx ctx;
+    ctx.welcome("OpenLogReplicator v." + std::to_string(OpenLogReplicator_VERSION_MAJOR) + "." +
+                std::to_string(OpenLogReplicator_VERSION_MINOR) + "." + std::to_string(OpenLogReplicator_VERSION_PATCH) +
+                " MicroBench (C) 2018-2023 by Adam Leszczynski (aleszczynski@bersler.com), see LICENSE file for licensing information");
+
+    if (argc < 2) {
+        ctx.info(0, "use: MicroBench checksum [<block size> [<rounds>]]");
+        ctx.info(0, "     MicroBench flatmap [<open transactions> [<operations>]]");
+        ctx.info(0, "     MicroBench endian [<rounds>]");
+        return 0;
+    }
+
+    int ret = 1;
+    try {
+        std::string test(argv[1]);
+        if (test == "checksum") {
+            uint64_t blockSize = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 512;
+            uint64_t rounds = (argc > 3) ? strtoull(argv[3], nullptr, 10) : 100;
+            if (blockSize != 512 && blockSize != 1024 && blockSize != 4096)
+                throw OpenLogReplicator::RuntimeException(10073, "checksum: invalid block size: " + std::to_string(blockSize));
+            OpenLogReplicator::benchChecksum(ctx, blockSize, rounds);
+        } else if (test == "flatmap") {
+            uint64_t open = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 100000;
+            uint64_t operations = (argc > 3) ? strtoull(argv[3], nullptr, 10) : 10000000;
+            if (open == 0)
+                throw OpenLogReplicator::RuntimeException(10076, "flatmap: invalid number of open transactions: 0");
+            OpenLogReplicator::benchFlatMap(ctx, open, operations);
+        } else if (test == "endian") {
+            uint64_t rounds = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 1000;
+            OpenLogReplicator::benchEndian(ctx, rounds);
+        } else
+            throw OpenLogReplicator::RuntimeException(10074, "unknown test: " + test);
+        ret = 0;
+    } catch (OpenLogReplicator::RuntimeException& ex) {
+        ctx.error(ex.code, ex.msg);
+    } catch (std::bad_alloc& ex) {
+        ctx.error(10018, "memory allocation failed: " + std::string(ex.what()));
+    }
+
+    return ret;
+}
@@ -30,6 +30,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include "common/Ctx.h"
 #include "common/types.h"
 #include "common/ConfigurationException.h"
+#include "common/PerfStats.h"
 #include "common/RuntimeException.h"
 #include "common/SysObj.h"
 #include "common/SysUser.h"
@@ -42,6 +43,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include "replicator/Replicator.h"
 #include "replicator/ReplicatorBatch.h"
 #include "state/StateDisk.h"
+#include "writer/WriterDiscard.h"
 #include "writer/WriterFile.h"
 #include "OpenLogReplicator.h"
 
@@ -91,6 +93,10 @@ namespace OpenLogReplicator {
         ctx->stopSoft();
         ctx->mainFinish();
 
+        // All threads are finished, the counters are complete
+        if (ctx->perfStats != nullptr)
+            ctx->perfStats->writeReport(ctx);
+
         for (Writer* writer : writers)
             delete writer;
         writers.clear();
@@ -200,6 +206,11 @@ namespace OpenLogReplicator {
                                              ", expected: one of {0 .. 131071}");
         }
 
+        if (document.HasMember("perf-report")) {
+            const char* perfReport = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, document, "perf-report");
+            ctx->perfStats = new PerfStats(perfReport);
+        }
+
         // Iterate through sources
         const rapidjson::Value& sourceArrayJson = Ctx::getJsonFieldA(fileName, document, "source");
         if (sourceArrayJson.Size() != 1) {
@@ -213,10 +224,19 @@ namespace OpenLogReplicator {
             const char* alias = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, sourceJson, "alias");
             ctx->info(0, "adding source: " + std::string(alias));
 
+            if (sourceJson.HasMember("memory-chunk-size-mb")) {
+                uint64_t memoryChunkSizeMb = Ctx::getJsonFieldU64(fileName, sourceJson, "memory-chunk-size-mb");
+                if (memoryChunkSizeMb == 0 || memoryChunkSizeMb > MEMORY_CHUNK_SIZE_MB_MAX || (memoryChunkSizeMb & (memoryChunkSizeMb - 1)) != 0)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'memory-chunk-size-mb' value: " + std::to_string(memoryChunkSizeMb) +
+                                                 ", expected: one of {1, 2, 4, 8, 16}");
+                ctx->memoryChunkSizeMb = memoryChunkSizeMb;
+                ctx->memoryChunkSize = memoryChunkSizeMb * 1024 * 1024;
+            }
+
             uint64_t memoryMinMb = 32;
             if (sourceJson.HasMember("memory-min-mb")) {
                 memoryMinMb = Ctx::getJsonFieldU64(fileName, sourceJson, "memory-min-mb");
-                memoryMinMb = (memoryMinMb / MEMORY_CHUNK_SIZE_MB) * MEMORY_CHUNK_SIZE_MB;
+                memoryMinMb = (memoryMinMb / ctx->memoryChunkSizeMb) * ctx->memoryChunkSizeMb;
                 if (memoryMinMb < MEMORY_CHUNK_MIN_MB)
                     throw ConfigurationException(30001, "bad JSON, invalid 'memory-min-mb' value: " + std::to_string(memoryMinMb) +
                                                  ", expected: at least " + std::to_string(MEMORY_CHUNK_MIN_MB));
@@ -225,25 +245,61 @@ namespace OpenLogReplicator {
             uint64_t memoryMaxMb = 1024;
             if (sourceJson.HasMember("memory-max-mb")) {
                 memoryMaxMb = Ctx::getJsonFieldU64(fileName, sourceJson, "memory-max-mb");
-                memoryMaxMb = (memoryMaxMb / MEMORY_CHUNK_SIZE_MB) * MEMORY_CHUNK_SIZE_MB;
+                memoryMaxMb = (memoryMaxMb / ctx->memoryChunkSizeMb) * ctx->memoryChunkSizeMb;
                 if (memoryMaxMb < memoryMinMb)
                     throw ConfigurationException(30001, "bad JSON, invalid 'memory-max-mb' value: " + std::to_string(memoryMaxMb) +
                                                  ", expected: at least like 'memory-min-mb' value (" + std::to_string(memoryMinMb) + ")");
             }
 
-            uint64_t readBufferMax = memoryMaxMb / 4 / MEMORY_CHUNK_SIZE_MB;
-            if (readBufferMax > 32 / MEMORY_CHUNK_SIZE_MB)
-                readBufferMax = 32 / MEMORY_CHUNK_SIZE_MB;
+            if (sourceJson.HasMember("memory-huge-pages")) {
+                const char* memoryHugePages = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, sourceJson, "memory-huge-pages");
+
+                if (strcmp(memoryHugePages, "none") == 0)
+                    ctx->memoryHugePages = MEMORY_HUGE_PAGES_NONE;
+                else if (strcmp(memoryHugePages, "thp") == 0 || strcmp(memoryHugePages, "hugetlb") == 0 ||
+                         strcmp(memoryHugePages, "hugetlb-1g") == 0) {
+#if __linux__
+                    if (strcmp(memoryHugePages, "thp") == 0)
+                        ctx->memoryHugePages = MEMORY_HUGE_PAGES_THP;
+                    else if (strcmp(memoryHugePages, "hugetlb") == 0)
+                        ctx->memoryHugePages = MEMORY_HUGE_PAGES_HUGETLB;
+                    else
+                        ctx->memoryHugePages = MEMORY_HUGE_PAGES_HUGETLB_1G;
+#else
+                    throw ConfigurationException(30001, "bad JSON, invalid 'memory-huge-pages' value: " + std::string(memoryHugePages) +
+                                                 ", expected: 'none' since huge pages are available only on Linux");
+#endif
+                } else
+                    throw ConfigurationException(30001, "bad JSON, invalid 'memory-huge-pages' value: " + std::string(memoryHugePages) +
+                                                 ", expected: one of {'none', 'thp', 'hugetlb', 'hugetlb-1g'}");
+            }
+
+            if (sourceJson.HasMember("memory-numa")) {
+                uint64_t memoryNuma = Ctx::getJsonFieldU64(fileName, sourceJson, "memory-numa");
+                if (memoryNuma > 1)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'memory-numa' value: " + std::to_string(memoryNuma) +
+                                                 ", expected: one of {0, 1}");
+#if !__linux__
+                if (memoryNuma == 1)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'memory-numa' value: " + std::to_string(memoryNuma) +
+                                                 ", expected: 0 since NUMA binding is available only on Linux");
+#endif
+                ctx->memoryNuma = (memoryNuma == 1);
+            }
+
+            uint64_t readBufferMax = memoryMaxMb / 4 / ctx->memoryChunkSizeMb;
+            if (readBufferMax > 32 / ctx->memoryChunkSizeMb)
+                readBufferMax = 32 / ctx->memoryChunkSizeMb;
 
             if (sourceJson.HasMember("read-buffer-max-mb")) {
-                readBufferMax = Ctx::getJsonFieldU64(fileName, sourceJson, "read-buffer-max-mb") / MEMORY_CHUNK_SIZE_MB;
-                if (readBufferMax * MEMORY_CHUNK_SIZE_MB > memoryMaxMb)
+                readBufferMax = Ctx::getJsonFieldU64(fileName, sourceJson, "read-buffer-max-mb") / ctx->memoryChunkSizeMb;
+                if (readBufferMax * ctx->memoryChunkSizeMb > memoryMaxMb)
                     throw ConfigurationException(30001, "bad JSON, invalid 'read-buffer-max-mb' value: " +
-                                                 std::to_string(readBufferMax * MEMORY_CHUNK_SIZE_MB) +
+                                                 std::to_string(readBufferMax * ctx->memoryChunkSizeMb) +
                                                  ", expected: not greater than 'memory-max-mb' value (" + std::to_string(memoryMaxMb) + ")");
                 if (readBufferMax <= 1)
                     throw ConfigurationException(30001, "bad JSON, invalid 'read-buffer-max-mb' value: " + std::to_string(readBufferMax) +
-                                                 ", expected: at least: " + std::to_string(MEMORY_CHUNK_SIZE_MB * 2));
+                                                 ", expected: at least: " + std::to_string(ctx->memoryChunkSizeMb * 2));
             }
 
             const char* name = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, sourceJson, "name");
@@ -363,6 +419,26 @@ namespace OpenLogReplicator {
                 ctx->transactionSizeMax = transactionMaxMb * 1024 * 1024;
             }
 
+            if (sourceJson.HasMember("transaction-spill-mb")) {
+                ctx->transactionSpillMb = Ctx::getJsonFieldU64(fileName, sourceJson, "transaction-spill-mb");
+                if (ctx->transactionSpillMb >= memoryMaxMb)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'transaction-spill-mb' value: " +
+                                                 std::to_string(ctx->transactionSpillMb) + ", expected: smaller than 'memory-max-mb' (" +
+                                                 std::to_string(memoryMaxMb) + ")");
+
+                ctx->transactionSpillPath = statePath;
+                if (sourceJson.HasMember("transaction-spill-path"))
+                    ctx->transactionSpillPath = Ctx::getJsonFieldS(fileName, MAX_PATH_LENGTH, sourceJson, "transaction-spill-path");
+            }
+
+            if (sourceJson.HasMember("commit-queue-mb")) {
+                ctx->commitQueueMb = Ctx::getJsonFieldU64(fileName, sourceJson, "commit-queue-mb");
+                if (ctx->commitQueueMb >= memoryMaxMb)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'commit-queue-mb' value: " +
+                                                 std::to_string(ctx->commitQueueMb) + ", expected: smaller than 'memory-max-mb' (" +
+                                                 std::to_string(memoryMaxMb) + ")");
+            }
+
             // MEMORY MANAGER
             ctx->initialize(memoryMinMb, memoryMaxMb, readBufferMax);
 
@@ -530,6 +606,25 @@ namespace OpenLogReplicator {
             if (sourceJson.HasMember("redo-read-sleep-us"))
                 ctx->redoReadSleepUs = Ctx::getJsonFieldU64(fileName, sourceJson, "redo-read-sleep-us");
 
+            if (sourceJson.HasMember("redo-read-tail")) {
+                const char* redoReadTail = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, sourceJson, "redo-read-tail");
+
+                if (strcmp(redoReadTail, "sleep") == 0)
+                    ctx->redoReadTail = REDO_READ_TAIL_SLEEP;
+                else if (strcmp(redoReadTail, "adaptive") == 0)
+                    ctx->redoReadTail = REDO_READ_TAIL_ADAPTIVE;
+                else
+                    throw ConfigurationException(30001, "bad JSON, invalid 'redo-read-tail' value: " + std::string(redoReadTail) +
+                                                 ", expected: one of {'sleep', 'adaptive'}");
+            }
+
+            if (sourceJson.HasMember("redo-read-spin-us")) {
+                ctx->redoReadSpinUs = Ctx::getJsonFieldU64(fileName, sourceJson, "redo-read-spin-us");
+                if (ctx->redoReadSpinUs > 1000000)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'redo-read-spin-us' value: " +
+                                                 std::to_string(ctx->redoReadSpinUs) + ", expected: one of {0 .. 1000000}");
+            }
+
             if (sourceJson.HasMember("arch-read-sleep-us"))
                 ctx->archReadSleepUs = Ctx::getJsonFieldU64(fileName, sourceJson, "arch-read-sleep-us");
 
@@ -540,6 +635,48 @@ namespace OpenLogReplicator {
                                                  std::to_string(ctx->archReadTries) + ", expected: one of: {1, 1000000000}");
             }
 
+            if (sourceJson.HasMember("arch-discovery")) {
+                const char* archDiscovery = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, sourceJson, "arch-discovery");
+
+                if (strcmp(archDiscovery, "scan") == 0)
+                    ctx->archDiscovery = ARCH_DISCOVERY_SCAN;
+                else if (strcmp(archDiscovery, "inotify") == 0) {
+#if __linux__
+                    ctx->archDiscovery = ARCH_DISCOVERY_INOTIFY;
+#else
+                    throw ConfigurationException(30001, "bad JSON, invalid 'arch-discovery' value: " + std::string(archDiscovery) +
+                                                 ", expected: not 'inotify' since it is available only on Linux");
+#endif
+                } else
+                    throw ConfigurationException(30001, "bad JSON, invalid 'arch-discovery' value: " + std::string(archDiscovery) +
+                                                 ", expected: one of {'scan', 'inotify'}");
+            }
+
+            if (sourceJson.HasMember("arch-prefetch")) {
+                ctx->archPrefetch = Ctx::getJsonFieldU64(fileName, sourceJson, "arch-prefetch");
+                if (ctx->archPrefetch > readBufferMax / 2)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'arch-prefetch' value: " + std::to_string(ctx->archPrefetch) +
+                                                 ", expected: one of {0 .. " + std::to_string(readBufferMax / 2) +
+                                                 "}, limited by 'read-buffer-max-mb' value");
+            }
+
+            if (sourceJson.HasMember("arch-catchup-threads")) {
+                ctx->archCatchupThreads = Ctx::getJsonFieldU64(fileName, sourceJson, "arch-catchup-threads");
+                if (ctx->archCatchupThreads > readBufferMax / 2 - ctx->archPrefetch)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'arch-catchup-threads' value: " +
+                                                 std::to_string(ctx->archCatchupThreads) + ", expected: one of {0 .. " +
+                                                 std::to_string(readBufferMax / 2 - ctx->archPrefetch) +
+                                                 "}, limited by 'read-buffer-max-mb' and 'arch-prefetch' values");
+            }
+
+            if (sourceJson.HasMember("parser-pipeline")) {
+                uint64_t parserPipeline = Ctx::getJsonFieldU64(fileName, sourceJson, "parser-pipeline");
+                if (parserPipeline > 1)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'parser-pipeline' value: " + std::to_string(parserPipeline) +
+                                                 ", expected: one of {0, 1}");
+                ctx->parserPipeline = (parserPipeline == 1);
+            }
+
             if (sourceJson.HasMember("redo-verify-delay-us"))
                 ctx->redoVerifyDelayUs = Ctx::getJsonFieldU64(fileName, sourceJson, "redo-verify-delay-us");
 
@@ -549,6 +686,64 @@ namespace OpenLogReplicator {
             if (readerJson.HasMember("redo-copy-path"))
                 ctx->redoCopyPath = Ctx::getJsonFieldS(fileName, MAX_PATH_LENGTH, readerJson, "redo-copy-path");
 
+            if (readerJson.HasMember("redo-copy-buffer-mb")) {
+                uint64_t redoCopyBufferMb = Ctx::getJsonFieldU64(fileName, readerJson, "redo-copy-buffer-mb");
+                if (redoCopyBufferMb < 1 || redoCopyBufferMb > 1024)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'redo-copy-buffer-mb' value: " +
+                                                 std::to_string(redoCopyBufferMb) + ", expected: one of {1 .. 1024}");
+                ctx->redoCopyBufferSize = redoCopyBufferMb * 1024 * 1024;
+            }
+
+            if (readerJson.HasMember("redo-copy-compression")) {
+                const char* redoCopyCompression = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, readerJson, "redo-copy-compression");
+
+                if (strcmp(redoCopyCompression, "none") == 0)
+                    ctx->redoCopyCompression = REDO_COPY_COMPRESSION_NONE;
+                else if (strcmp(redoCopyCompression, "zstd") == 0) {
+#ifdef LINK_LIBRARY_ZSTD
+                    ctx->redoCopyCompression = REDO_COPY_COMPRESSION_ZSTD;
+#else
+                    throw ConfigurationException(30001, "bad JSON, invalid 'redo-copy-compression' value: " + std::string(redoCopyCompression) +
+                                                 ", expected: not 'zstd' since the code is not compiled");
+#endif /* LINK_LIBRARY_ZSTD */
+                } else if (strcmp(redoCopyCompression, "lz4") == 0) {
+#ifdef LINK_LIBRARY_LZ4
+                    ctx->redoCopyCompression = REDO_COPY_COMPRESSION_LZ4;
+#else
+                    throw ConfigurationException(30001, "bad JSON, invalid 'redo-copy-compression' value: " + std::string(redoCopyCompression) +
+                                                 ", expected: not 'lz4' since the code is not compiled");
+#endif /* LINK_LIBRARY_LZ4 */
+                } else
+                    throw ConfigurationException(30001, "bad JSON, invalid 'redo-copy-compression' value: " + std::string(redoCopyCompression) +
+                                                 ", expected: one of {'none', 'zstd', 'lz4'}");
+            }
+
+            if (readerJson.HasMember("read-engine")) {
+                const char* readEngine = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, readerJson, "read-engine");
+
+                if (strcmp(readEngine, "pread") == 0)
+                    ctx->readEngine = READ_ENGINE_PREAD;
+                else if (strcmp(readEngine, "io-uring") == 0) {
+#ifdef LINK_LIBRARY_LIBURING
+                    ctx->readEngine = READ_ENGINE_IO_URING;
+#else
+                    throw ConfigurationException(30001, "bad JSON, invalid 'read-engine' value: " + std::string(readEngine) +
+                                                 ", expected: not 'io-uring' since the code is not compiled");
+#endif /* LINK_LIBRARY_LIBURING */
+                } else if (strcmp(readEngine, "mmap") == 0)
+                    ctx->readEngine = READ_ENGINE_MMAP;
+                else
+                    throw ConfigurationException(30001, "bad JSON, invalid 'read-engine' value: " + std::string(readEngine) +
+                                                 ", expected: one of {'pread', 'io-uring', 'mmap'}");
+            }
+
+            if (readerJson.HasMember("read-queue-depth")) {
+                ctx->readQueueDepth = Ctx::getJsonFieldU64(fileName, readerJson, "read-queue-depth");
+                if (ctx->readQueueDepth < 1 || ctx->readQueueDepth > 256)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'read-queue-depth' value: " +
+                                                 std::to_string(ctx->readQueueDepth) + ", expected: one of {1 .. 256}");
+            }
+
             if (strcmp(readerType, "online") == 0) {
 #ifdef LINK_LIBRARY_OCI
                 const char* user = Ctx::getJsonFieldS(fileName, JSON_USERNAME_LENGTH, readerJson, "user");
@@ -805,9 +1000,12 @@ namespace OpenLogReplicator {
                 throw ConfigurationException(30001, "bad JSON, invalid 'type' value: " + std::string(writerType) +
                                              ", expected: not 'network' since the code is not compiled");
 #endif /* LINK_LIBRARY_PROTOBUF */
+            } else if (strcmp(writerType, "discard") == 0) {
+                writer = new WriterDiscard(ctx, std::string(alias) + "-writer", replicator2->database,
+                                           replicator2->builder, replicator2->metadata);
             } else
                 throw ConfigurationException(30001, "bad JSON, invalid 'type' value: " + std::string(writerType) +
-                                             ", expected: one of {'file', 'kafka', 'zeromq', 'network'}");
+                                             ", expected: one of {'file', 'kafka', 'zeromq', 'network', 'discard'}");
 
             writers.push_back(writer);
             writer->initialize();
@@ -0,0 +1,55 @@
+/* Main program of the synthetic redo log generator
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include "common/ConfigurationException.h"
+#include "common/Ctx.h"
+#include "common/DataException.h"
+#include "common/RuntimeException.h"
+#include "common/types.h"
+#include "generator/Generator.h"
+
+int main(int argc, char** argv) {
+    OpenLogReplicator::Ctx ctx;
+    ctx.welcome("OpenLogReplicator v." + std::to_string(OpenLogReplicator_VERSION_MAJOR) + "." +
+                std::to_string(OpenLogReplicator_VERSION_MINOR) + "." + std::to_string(OpenLogReplicator_VERSION_PATCH) +
+                " RedoGenerator (C) 2018-2023 by Adam Leszczynski (aleszczynski@bersler.com), see LICENSE file for licensing information");
+
+    if (argc != 2) {
+        ctx.info(0, "use: RedoGenerator <config file>");
+        return 0;
+    }
+
+    int ret = 1;
+    OpenLogReplicator::Generator generator(&ctx, argv[1]);
+    try {
+        generator.loadConfig();
+        generator.run();
+        ret = 0;
+    } catch (OpenLogReplicator::ConfigurationException& ex) {
+        ctx.error(ex.code, ex.msg);
+    } catch (OpenLogReplicator::DataException& ex) {
+        ctx.error(ex.code, ex.msg);
+    } catch (OpenLogReplicator::RuntimeException& ex) {
+        ctx.error(ex.code, ex.msg);
+    } catch (std::bad_alloc& ex) {
+        ctx.error(10018, "memory allocation failed: " + std::string(ex.what()));
+    }
+
+    return ret;
+}
@@ -395,7 +395,7 @@ namespace OpenLogReplicator {
         nextBuffer->data = reinterpret_cast<uint8_t*>(nextBuffer) + sizeof(struct BuilderQueue);
 
         // Message could potentially fit in one buffer
-        if (copy && msg != nullptr && sizeof(struct BuilderMsg) + messageLength < OUTPUT_BUFFER_DATA_SIZE) {
+        if (copy && msg != nullptr && sizeof(struct BuilderMsg) + messageLength < outputBufferDataSize()) {
             memcpy(reinterpret_cast<void*>(nextBuffer->data), msg, sizeof(struct BuilderMsg) + messageLength);
             msg = reinterpret_cast<BuilderMsg*>(nextBuffer->data);
             msg->data = nextBuffer->data + sizeof(struct BuilderMsg);
@@ -434,6 +434,7 @@ namespace OpenLogReplicator {
 
     // 0x05010B0B
     void Builder::processInsertMultiple(LobCtx* lobCtx, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2, bool system, bool schema, bool dump) {
+        PerfScope perfScope(ctx->perfStats, PERF_STAGE_BUILDER);
         uint64_t pos = 0;
         uint64_t fieldPos = 0;
         uint64_t fieldPosStart;
@@ -503,6 +504,7 @@ namespace OpenLogReplicator {
 
     // 0x05010B0C
     void Builder::processDeleteMultiple(LobCtx* lobCtx, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2, bool system, bool schema, bool dump) {
+        PerfScope perfScope(ctx->perfStats, PERF_STAGE_BUILDER);
         uint64_t pos = 0;
         uint64_t fieldPos = 0;
         uint64_t fieldPosStart;
@@ -573,6 +575,7 @@ namespace OpenLogReplicator {
 
     void Builder::processDml(LobCtx* lobCtx, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2, uint64_t type, bool system, bool schema,
                              bool dump) {
+        PerfScope perfScope(ctx->perfStats, PERF_STAGE_BUILDER);
         uint8_t fb;
         typeObj obj;
         typeDataObj dataObj;
@@ -1269,6 +1272,7 @@ namespace OpenLogReplicator {
 
     // 0x18010000
     void Builder::processDdlHeader(RedoLogRecord* redoLogRecord1) {
+        PerfScope perfScope(ctx->perfStats, PERF_STAGE_BUILDER);
         uint64_t fieldPos = 0;
         uint64_t sqlLength;
         typeField fieldNum = 0;
@@ -29,6 +29,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include "../common/LobCtx.h"
 #include "../common/LobData.h"
 #include "../common/LobKey.h"
+#include "../common/PerfStats.h"
 #include "../common/RedoLogRecord.h"
 #include "../common/RedoLogException.h"
 #include "../common/types.h"
@@ -41,7 +42,6 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #ifndef BUILDER_H_
 #define BUILDER_H_
 
-#define OUTPUT_BUFFER_DATA_SIZE                 (MEMORY_CHUNK_SIZE - sizeof(struct BuilderQueue))
 #define OUTPUT_BUFFER_ALLOCATED                 0x0001
 #define OUTPUT_BUFFER_CONFIRMED                 0x0002
 #define VALUE_BUFFER_MIN                        1048576
@@ -207,7 +207,7 @@ namespace OpenLogReplicator {
         void builderShift(uint64_t bytes, bool copy) {
             lastBuilderQueue->length += bytes;
 
-            if (lastBuilderQueue->length >= OUTPUT_BUFFER_DATA_SIZE)
+            if (lastBuilderQueue->length >= outputBufferDataSize())
                 builderRotate(copy);
         };
 
@@ -218,7 +218,7 @@ namespace OpenLogReplicator {
         void builderBegin(typeObj obj) {
             messageLength = 0;
 
-            if (lastBuilderQueue->length + sizeof(struct BuilderMsg) >= OUTPUT_BUFFER_DATA_SIZE)
+            if (lastBuilderQueue->length + sizeof(struct BuilderMsg) >= outputBufferDataSize())
                 builderRotate(true);
 
             msg = reinterpret_cast<BuilderMsg*>(lastBuilderQueue->data + lastBuilderQueue->length);
@@ -241,6 +241,8 @@ namespace OpenLogReplicator {
             builderShift((8 - (messageLength & 7)) & 7, false);
             unconfirmedLength += messageLength;
             msg->length = messageLength;
+            if (ctx->perfStats != nullptr)
+                ctx->perfStats->add(PERF_STAGE_BUILDER, messageLength, 1);
 
             if (force || flushBuffer == 0 || unconfirmedLength > flushBuffer) {
                 {
@@ -259,7 +261,7 @@ namespace OpenLogReplicator {
         };
 
         void builderAppend(const char* str, uint64_t length) {
-            if (lastBuilderQueue->length + length < OUTPUT_BUFFER_DATA_SIZE) {
+            if (lastBuilderQueue->length + length < outputBufferDataSize()) {
                 memcpy(reinterpret_cast<void*>(lastBuilderQueue->data + lastBuilderQueue->length),
                        reinterpret_cast<const void*>(str), length);
                 lastBuilderQueue->length += length;
@@ -280,7 +282,7 @@ namespace OpenLogReplicator {
 
         void builderAppend(const std::string& str) {
             uint64_t length = str.length();
-            if (lastBuilderQueue->length + length < OUTPUT_BUFFER_DATA_SIZE) {
+            if (lastBuilderQueue->length + length < outputBufferDataSize()) {
                 memcpy(lastBuilderQueue->data + lastBuilderQueue->length,
                        reinterpret_cast<const void*>(str.c_str()), length);
                 lastBuilderQueue->length += length;
@@ -1103,6 +1105,9 @@ namespace OpenLogReplicator {
         virtual ~Builder();
 
         [[nodiscard]] uint64_t builderSize() const;
+        [[nodiscard]] uint64_t outputBufferDataSize() const {
+            return ctx->memoryChunkSize - sizeof(struct BuilderQueue);
+        };
         [[nodiscard]] uint64_t getMaxMessageMb() const;
         void setMaxMessageMb(uint64_t maxMessageMb);
         void processBegin(typeScn scn, typeTime time_, typeSeq sequence, typeXid xid);
@@ -475,6 +475,7 @@ namespace OpenLogReplicator {
     }
 
     void BuilderJson::processCommit() {
+        PerfScope perfScope(ctx->perfStats, PERF_STAGE_BUILDER);
         // Skip empty transaction
         if (newTran) {
             newTran = false;
@@ -666,6 +667,7 @@ namespace OpenLogReplicator {
     }
 
     void BuilderJson::processCheckpoint(typeScn scn, typeTime time_, typeSeq sequence, uint64_t offset, bool redo) {
+        PerfScope perfScope(ctx->perfStats, PERF_STAGE_BUILDER);
         if (!FLAG(REDO_FLAGS_SHOW_CHECKPOINT))
             return;
 
@@ -509,6 +509,7 @@ namespace OpenLogReplicator {
     }
 
     void BuilderProtobuf::processCommit() {
+        PerfScope perfScope(ctx->perfStats, PERF_STAGE_BUILDER);
         // Skip empty transaction
         if (newTran) {
             newTran = false;
@@ -544,6 +545,7 @@ namespace OpenLogReplicator {
 
     void BuilderProtobuf::processCheckpoint(typeScn scn __attribute__((unused)), typeTime time_ __attribute__((unused)), typeSeq sequence, uint64_t offset,
                                             bool redo) {
+        PerfScope perfScope(ctx->perfStats, PERF_STAGE_BUILDER);
         if (!FLAG(REDO_FLAGS_SHOW_CHECKPOINT))
             return;
 
@@ -0,0 +1,278 @@
+/* Block checksum calculation
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "BlockSum.h"
+
+namespace OpenLogReplicator {
+    const char* BlockSum::name = "scalar";
+    BlockSum::kernelType BlockSum::sumXor = BlockSum::select();
+    BlockSum::verifyType BlockSum::verifyBlocks = BlockSum::selectVerify();
+
+    uint64_t BlockSum::sumXorScalar(const uint8_t* buffer, uint64_t size) {
+        uint64_t sum = 0;
+
+        for (uint64_t i = 0; i < size / 8; ++i, buffer += 8)
+            sum ^= *(reinterpret_cast<const uint64_t*>(buffer));
+
+        return sum;
+    }
+
+    // The stored checksum is part of the block, so a valid block folds to zero
+    uint64_t BlockSum::verifyScalar(const uint8_t* buffer, uint64_t blockSize, uint64_t blocks) {
+        uint64_t numBlock = 0;
+
+        for (; numBlock < blocks; ++numBlock, buffer += blockSize) {
+            if (fold(sumXorScalar(buffer, blockSize)) != 0)
+                break;
+        }
+
+        return numBlock;
+    }
+
+#if defined(__x86_64__)
+    __attribute__((target("avx2")))
+    uint64_t BlockSum::sumXorAvx2(const uint8_t* buffer, uint64_t size) {
+        __m256i sum0 = _mm256_setzero_si256();
+        __m256i sum1 = _mm256_setzero_si256();
+        uint64_t i = 0;
+
+        for (; i + 64 <= size; i += 64) {
+            sum0 = _mm256_xor_si256(sum0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + i)));
+            sum1 = _mm256_xor_si256(sum1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + i + 32)));
+        }
+        sum0 = _mm256_xor_si256(sum0, sum1);
+        __m128i sum2 = _mm_xor_si128(_mm256_castsi256_si128(sum0), _mm256_extracti128_si256(sum0, 1));
+        uint64_t sum = static_cast<uint64_t>(_mm_cvtsi128_si64(sum2)) ^ static_cast<uint64_t>(_mm_extract_epi64(sum2, 1));
+
+        return sum ^ sumXorScalar(buffer + i, size - i);
+    }
+
+    // Four blocks are summed in parallel, then their sums are transposed, so that lane n holds the sum of block n, and all four
+    // checksums are folded and compared in one vector. The block size is a multiple of 32 bytes.
+    __attribute__((target("avx2")))
+    uint64_t BlockSum::verifyAvx2(const uint8_t* buffer, uint64_t blockSize, uint64_t blocks) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i mask = _mm256_set1_epi64x(0xFFFF);
+        uint64_t numBlock = 0;
+
+        for (; numBlock + 4 <= blocks; numBlock += 4) {
+            const uint8_t* block = buffer + numBlock * blockSize;
+            __m256i sum0 = zero;
+            __m256i sum1 = zero;
+            __m256i sum2 = zero;
+            __m256i sum3 = zero;
+
+            for (uint64_t i = 0; i < blockSize; i += 32) {
+                sum0 = _mm256_xor_si256(sum0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i)));
+                sum1 = _mm256_xor_si256(sum1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + blockSize + i)));
+                sum2 = _mm256_xor_si256(sum2, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + blockSize * 2 + i)));
+                sum3 = _mm256_xor_si256(sum3, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + blockSize * 3 + i)));
+            }
+
+            __m256i sum01 = _mm256_xor_si256(_mm256_unpacklo_epi64(sum0, sum1), _mm256_unpackhi_epi64(sum0, sum1));
+            __m256i sum23 = _mm256_xor_si256(_mm256_unpacklo_epi64(sum2, sum3), _mm256_unpackhi_epi64(sum2, sum3));
+            __m256i sum = _mm256_xor_si256(_mm256_permute2x128_si256(sum01, sum23, 0x20), _mm256_permute2x128_si256(sum01, sum23, 0x31));
+            sum = _mm256_xor_si256(sum, _mm256_srli_epi64(sum, 32));
+            sum = _mm256_xor_si256(sum, _mm256_srli_epi64(sum, 16));
+            sum = _mm256_and_si256(sum, mask);
+
+            auto valid = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(sum, zero))));
+            if (valid != 0x0F)
+                return numBlock + static_cast<uint64_t>(__builtin_ctz(~valid));
+        }
+
+        for (; numBlock < blocks; ++numBlock) {
+            if (fold(sumXorAvx2(buffer + numBlock * blockSize, blockSize)) != 0)
+                break;
+        }
+
+        return numBlock;
+    }
+
+    __attribute__((target("avx512f")))
+    uint64_t BlockSum::sumXorAvx512(const uint8_t* buffer, uint64_t size) {
+        __m512i sum0 = _mm512_setzero_si512();
+        __m512i sum1 = _mm512_setzero_si512();
+        uint64_t i = 0;
+
+        for (; i + 128 <= size; i += 128) {
+            sum0 = _mm512_xor_si512(sum0, _mm512_loadu_si512(buffer + i));
+            sum1 = _mm512_xor_si512(sum1, _mm512_loadu_si512(buffer + i + 64));
+        }
+        sum0 = _mm512_xor_si512(sum0, sum1);
+        uint64_t lanes[8];
+        _mm512_storeu_si512(lanes, sum0);
+        uint64_t sum = lanes[0] ^ lanes[1] ^ lanes[2] ^ lanes[3] ^ lanes[4] ^ lanes[5] ^ lanes[6] ^ lanes[7];
+
+        return sum ^ sumXorScalar(buffer + i, size - i);
+    }
+
+    // Eight blocks are summed in parallel, the checksums are folded and compared like in verifyAvx2, four at a time. The block size
+    // is a multiple of 64 bytes.
+    __attribute__((target("avx512f")))
+    uint64_t BlockSum::verifyAvx512(const uint8_t* buffer, uint64_t blockSize, uint64_t blocks) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i mask = _mm256_set1_epi64x(0xFFFF);
+        uint64_t numBlock = 0;
+
+        for (; numBlock + 8 <= blocks; numBlock += 8) {
+            const uint8_t* block = buffer + numBlock * blockSize;
+            __m512i sums[8];
+            for (auto& sum : sums)
+                sum = _mm512_setzero_si512();
+
+            for (uint64_t i = 0; i < blockSize; i += 64) {
+                for (uint64_t j = 0; j < 8; ++j)
+                    sums[j] = _mm512_xor_si512(sums[j], _mm512_loadu_si512(block + blockSize * j + i));
+            }
+
+            // Masked forms of the extracts don't leave undefined lanes, which gcc reports as uninitialized
+            __m256i halves[8];
+            for (uint64_t j = 0; j < 8; ++j)
+                halves[j] = _mm256_xor_si256(_mm512_maskz_extracti64x4_epi64(0xFF, sums[j], 0),
+                                             _mm512_maskz_extracti64x4_epi64(0xFF, sums[j], 1));
+
+            uint32_t valid = 0;
+            for (uint64_t j = 0; j < 8; j += 4) {
+                __m256i sum01 = _mm256_xor_si256(_mm256_unpacklo_epi64(halves[j], halves[j + 1]),
+                                                 _mm256_unpackhi_epi64(halves[j], halves[j + 1]));
+                __m256i sum23 = _mm256_xor_si256(_mm256_unpacklo_epi64(halves[j + 2], halves[j + 3]),
+                                                 _mm256_unpackhi_epi64(halves[j + 2], halves[j + 3]));
+                __m256i sum = _mm256_xor_si256(_mm256_permute2x128_si256(sum01, sum23, 0x20),
+                                               _mm256_permute2x128_si256(sum01, sum23, 0x31));
+                sum = _mm256_xor_si256(sum, _mm256_srli_epi64(sum, 32));
+                sum = _mm256_xor_si256(sum, _mm256_srli_epi64(sum, 16));
+                sum = _mm256_and_si256(sum, mask);
+                valid |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(sum, zero)))) << j;
+            }
+
+            if (valid != 0xFF)
+                return numBlock + static_cast<uint64_t>(__builtin_ctz(~valid));
+        }
+
+        for (; numBlock < blocks; ++numBlock) {
+            if (fold(sumXorAvx512(buffer + numBlock * blockSize, blockSize)) != 0)
+                break;
+        }
+
+        return numBlock;
+    }
+#endif
+
+#if defined(__aarch64__)
+    uint64_t BlockSum::sumXorNeon(const uint8_t* buffer, uint64_t size) {
+        uint64x2_t sum0 = vdupq_n_u64(0);
+        uint64x2_t sum1 = vdupq_n_u64(0);
+        uint64_t i = 0;
+
+        for (; i + 32 <= size; i += 32) {
+            sum0 = veorq_u64(sum0, vld1q_u64(reinterpret_cast<const uint64_t*>(buffer + i)));
+            sum1 = veorq_u64(sum1, vld1q_u64(reinterpret_cast<const uint64_t*>(buffer + i + 16)));
+        }
+        sum0 = veorq_u64(sum0, sum1);
+        uint64_t sum = vgetq_lane_u64(sum0, 0) ^ vgetq_lane_u64(sum0, 1);
+
+        return sum ^ sumXorScalar(buffer + i, size - i);
+    }
+
+    // Two blocks are summed in parallel and their checksums are compared in one vector. The block size is a multiple of 16 bytes.
+    uint64_t BlockSum::verifyNeon(const uint8_t* buffer, uint64_t blockSize, uint64_t blocks) {
+        const uint64x2_t mask = vdupq_n_u64(0xFFFF);
+        uint64_t numBlock = 0;
+
+        for (; numBlock + 2 <= blocks; numBlock += 2) {
+            const uint8_t* block = buffer + numBlock * blockSize;
+            uint64x2_t sum0 = vdupq_n_u64(0);
+            uint64x2_t sum1 = vdupq_n_u64(0);
+
+            for (uint64_t i = 0; i < blockSize; i += 16) {
+                sum0 = veorq_u64(sum0, vld1q_u64(reinterpret_cast<const uint64_t*>(block + i)));
+                sum1 = veorq_u64(sum1, vld1q_u64(reinterpret_cast<const uint64_t*>(block + blockSize + i)));
+            }
+
+            uint64x2_t sum = veorq_u64(vzip1q_u64(sum0, sum1), vzip2q_u64(sum0, sum1));
+            sum = veorq_u64(sum, vshrq_n_u64(sum, 32));
+            sum = veorq_u64(sum, vshrq_n_u64(sum, 16));
+            sum = vandq_u64(sum, mask);
+
+            if (vgetq_lane_u64(sum, 0) != 0)
+                return numBlock;
+            if (vgetq_lane_u64(sum, 1) != 0)
+                return numBlock + 1;
+        }
+
+        if (numBlock < blocks && fold(sumXorNeon(buffer + numBlock * blockSize, blockSize)) == 0)
+            ++numBlock;
+
+        return numBlock;
+    }
+#endif
+
+    BlockSum::kernelType BlockSum::select() {
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            name = "avx512";
+            return sumXorAvx512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            name = "avx2";
+            return sumXorAvx2;
+        }
+#endif
+#if defined(__aarch64__)
+        name = "neon";
+        return sumXorNeon;
+#endif
+        name = "scalar";
+        return sumXorScalar;
+    }
+
+    BlockSum::verifyType BlockSum::selectVerify() {
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return verifyAvx512;
+        if (__builtin_cpu_supports("avx2"))
+            return verifyAvx2;
+#endif
+#if defined(__aarch64__)
+        return verifyNeon;
+#endif
+        return verifyScalar;
+    }
+
+    uint64_t BlockSum::fold(uint64_t sum) {
+        sum ^= (sum >> 32);
+        sum ^= (sum >> 16);
+        return sum & 0xFFFF;
+    }
+
+    // Returns the number of leading blocks with a valid checksum
+    uint64_t BlockSum::verify(const uint8_t* buffer, uint64_t blockSize, uint64_t blocks) {
+        return verifyBlocks(buffer, blockSize, blocks);
+    }
+}
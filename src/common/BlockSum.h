@@ -0,0 +1,54 @@
+/* Header for BlockSum class
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <cstdint>
+
+#ifndef BLOCK_SUM_H_
+#define BLOCK_SUM_H_
+
+namespace OpenLogReplicator {
+    class BlockSum {
+    public:
+        typedef uint64_t (*kernelType)(const uint8_t* buffer, uint64_t size);
+        typedef uint64_t (*verifyType)(const uint8_t* buffer, uint64_t blockSize, uint64_t blocks);
+
+        static kernelType sumXor;
+        static verifyType verifyBlocks;
+        static const char* name;
+
+        static uint64_t sumXorScalar(const uint8_t* buffer, uint64_t size);
+        static uint64_t verifyScalar(const uint8_t* buffer, uint64_t blockSize, uint64_t blocks);
+#if defined(__x86_64__)
+        static uint64_t sumXorAvx2(const uint8_t* buffer, uint64_t size);
+        static uint64_t verifyAvx2(const uint8_t* buffer, uint64_t blockSize, uint64_t blocks);
+        static uint64_t sumXorAvx512(const uint8_t* buffer, uint64_t size);
+        static uint64_t verifyAvx512(const uint8_t* buffer, uint64_t blockSize, uint64_t blocks);
+#endif
+#if defined(__aarch64__)
+        static uint64_t sumXorNeon(const uint8_t* buffer, uint64_t size);
+        static uint64_t verifyNeon(const uint8_t* buffer, uint64_t blockSize, uint64_t blocks);
+#endif
+        static kernelType select();
+        static verifyType selectVerify();
+        static uint64_t fold(uint64_t sum);
+        static uint64_t verify(const uint8_t* buffer, uint64_t blockSize, uint64_t blocks);
+    };
+}
+
+#endif
@@ -19,16 +19,25 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 
 #define GLOBALS 1
 
+#include <cerrno>
 #include <cstdlib>
 #include <csignal>
+#include <cstring>
 #include <execinfo.h>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <string>
+#include <sys/mman.h>
 #include <unistd.h>
+#if __linux__
+#include <linux/mman.h>
+#include <sys/syscall.h>
+#endif
 
 #include "Ctx.h"
 #include "DataException.h"
+#include "PerfStats.h"
 #include "RuntimeException.h"
 #include "Thread.h"
 #include "typeIntX.h"
@@ -73,55 +82,76 @@ namespace OpenLogReplicator {
             memoryChunksMax(0),
             memoryChunksHWM(0),
             memoryChunksReusable(0),
+            memoryChunksHuge(0),
+            memoryChunksRemote(0),
+            memoryHugePagesFallback(false),
             version12(false),
             version(0),
             dumpRedoLog(0),
             dumpRawData(0),
+            memoryChunkSizeMb(1),
+            memoryChunkSize(1024 * 1024),
+            memoryHugePages(MEMORY_HUGE_PAGES_NONE),
+            memoryNuma(false),
             readBufferMax(0),
             buffersFree(0),
             bufferSizeMax(0),
             buffersMaxUsed(0),
-            suppLogSize(0),
             checkpointIntervalS(600),
             checkpointIntervalMb(500),
             checkpointKeep(100),
             schemaForceInterval(20),
             redoReadSleepUs(50000),
+            redoReadTail(REDO_READ_TAIL_SLEEP),
+            redoReadSpinUs(100),
             redoVerifyDelayUs(0),
             archReadSleepUs(10000000),
             archReadTries(10),
             refreshIntervalUs(10000000),
+            readEngine(READ_ENGINE_PREAD),
+            readQueueDepth(8),
+            archPrefetch(0),
+            archCatchupThreads(0),
+            archDiscovery(ARCH_DISCOVERY_SCAN),
+            parserPipeline(false),
+            commitQueueMb(0),
+            perfStats(nullptr),
             pollIntervalUs(100000),
             queueSize(65536),
             dumpPath("."),
+            redoCopyCompression(REDO_COPY_COMPRESSION_NONE),
+            redoCopyBufferSize(16 * 1024 * 1024),
             stopLogSwitches(0),
             stopCheckpoints(0),
             stopTransactions(0),
             transactionSizeMax(0),
+            transactionSpillMb(0),
             logLevel(3),
             trace(0),
             flags(0),
             disableChecks(0),
             hardShutdown(false),
             softShutdown(false),
-            replicatorFinished(false),
-            read16(read16Little),
-            read32(read32Little),
-            read56(read56Little),
-            read64(read64Little),
-            readScn(readScnLittle),
-            readScnR(readScnRLittle),
-            write16(write16Little),
-            write32(write32Little),
-            write56(write56Little),
-            write64(write64Little),
-            writeScn(writeScnLittle) {
+            replicatorFinished(false) {
         mainThread = pthread_self();
     }
 
     Ctx::~Ctx() {
         lobIdToXidMap.clear();
 
+        if (perfStats != nullptr) {
+            delete perfStats;
+            perfStats = nullptr;
+        }
+
+        if (memoryPooled()) {
+            // Chunks are carved from regions, release whole regions
+            for (auto& regionIt: memoryRegions)
+                munmap(regionIt.second.data, regionIt.second.size);
+            memoryRegions.clear();
+            memoryChunksAllocated = 0;
+        }
+
         while (memoryChunksAllocated > 0) {
             --memoryChunksAllocated;
             free(memoryChunks[memoryChunksAllocated]);
@@ -136,236 +166,12 @@ namespace OpenLogReplicator {
 
     void Ctx::setBigEndian() {
         bigEndian = true;
-        read16 = read16Big;
-        read32 = read32Big;
-        read56 = read56Big;
-        read64 = read64Big;
-        readScn = readScnBig;
-        readScnR = readScnRBig;
-        write16 = write16Big;
-        write32 = write32Big;
-        write56 = write56Big;
-        write64 = write64Big;
-        writeScn = writeScnBig;
     }
 
     bool Ctx::isBigEndian() const {
         return bigEndian;
     }
 
-    uint16_t Ctx::read16Little(const uint8_t* buf) {
-        return static_cast<uint16_t>(buf[0]) | (static_cast<uint16_t>(buf[1]) << 8);
-    }
-
-    uint16_t Ctx::read16Big(const uint8_t* buf) {
-        return (static_cast<uint16_t>(buf[0]) << 8) | static_cast<uint16_t>(buf[1]);
-    }
-
-    uint32_t Ctx::read24Big(const uint8_t* buf) {
-        return (static_cast<uint32_t>(buf[0]) << 16) |
-               (static_cast<uint32_t>(buf[1]) << 8) | static_cast<uint32_t>(buf[2]);
-    }
-
-    uint32_t Ctx::read32Little(const uint8_t* buf) {
-        return static_cast<uint32_t>(buf[0]) | (static_cast<uint32_t>(buf[1]) << 8) |
-               (static_cast<uint32_t>(buf[2]) << 16) | (static_cast<uint32_t>(buf[3]) << 24);
-    }
-
-    uint32_t Ctx::read32Big(const uint8_t* buf) {
-        return (static_cast<uint32_t>(buf[0]) << 24) | (static_cast<uint32_t>(buf[1]) << 16) |
-               (static_cast<uint32_t>(buf[2]) << 8) | static_cast<uint32_t>(buf[3]);
-    }
-
-    uint64_t Ctx::read56Little(const uint8_t* buf) {
-        return static_cast<uint64_t>(buf[0]) | (static_cast<uint64_t>(buf[1]) << 8) |
-               (static_cast<uint64_t>(buf[2]) << 16) | (static_cast<uint64_t>(buf[3]) << 24) |
-               (static_cast<uint64_t>(buf[4]) << 32) | (static_cast<uint64_t>(buf[5]) << 40) |
-               (static_cast<uint64_t>(buf[6]) << 48);
-    }
-
-    uint64_t Ctx::read56Big(const uint8_t* buf) {
-        return (static_cast<uint64_t>(buf[0]) << 24) | (static_cast<uint64_t>(buf[1]) << 16) |
-                (static_cast<uint64_t>(buf[2]) << 8) | (static_cast<uint64_t>(buf[3])) |
-                (static_cast<uint64_t>(buf[4]) << 40) | (static_cast<uint64_t>(buf[5]) << 32) |
-                (static_cast<uint64_t>(buf[6]) << 48);
-    }
-
-    uint64_t Ctx::read64Little(const uint8_t* buf) {
-        return static_cast<uint64_t>(buf[0]) | (static_cast<uint64_t>(buf[1]) << 8) |
-               (static_cast<uint64_t>(buf[2]) << 16) | (static_cast<uint64_t>(buf[3]) << 24) |
-               (static_cast<uint64_t>(buf[4]) << 32) | (static_cast<uint64_t>(buf[5]) << 40) |
-               (static_cast<uint64_t>(buf[6]) << 48) | (static_cast<uint64_t>(buf[7]) << 56);
-    }
-
-    uint64_t Ctx::read64Big(const uint8_t* buf) {
-        return (static_cast<uint64_t>(buf[0]) << 56) | (static_cast<uint64_t>(buf[1]) << 48) |
-               (static_cast<uint64_t>(buf[2]) << 40) | (static_cast<uint64_t>(buf[3]) << 32) |
-               (static_cast<uint64_t>(buf[4]) << 24) | (static_cast<uint64_t>(buf[5]) << 16) |
-               (static_cast<uint64_t>(buf[6]) << 8) | static_cast<uint64_t>(buf[7]);
-    }
-
-    typeScn Ctx::readScnLittle(const uint8_t* buf) {
-        if (buf[0] == 0xFF && buf[1] == 0xFF && buf[2] == 0xFF && buf[3] == 0xFF && buf[4] == 0xFF && buf[5] == 0xFF)
-            return ZERO_SCN;
-        if ((buf[5] & 0x80) == 0x80)
-            return static_cast<uint64_t>(buf[0]) | (static_cast<uint64_t>(buf[1]) << 8) |
-                   (static_cast<uint64_t>(buf[2]) << 16) | (static_cast<uint64_t>(buf[3]) << 24) |
-                   (static_cast<uint64_t>(buf[6]) << 32) | (static_cast<uint64_t>(buf[7]) << 40) |
-                   (static_cast<uint64_t>(buf[4]) << 48) | (static_cast<uint64_t>(buf[5] & 0x7F) << 56);
-        else
-            return static_cast<uint64_t>(buf[0]) | (static_cast<uint64_t>(buf[1]) << 8) |
-                   (static_cast<uint64_t>(buf[2]) << 16) | (static_cast<uint64_t>(buf[3]) << 24) |
-                   (static_cast<uint64_t>(buf[4]) << 32) | (static_cast<uint64_t>(buf[5]) << 40);
-    }
-
-    typeScn Ctx::readScnBig(const uint8_t* buf) {
-        if (buf[0] == 0xFF && buf[1] == 0xFF && buf[2] == 0xFF && buf[3] == 0xFF && buf[4] == 0xFF && buf[5] == 0xFF)
-            return ZERO_SCN;
-        if ((buf[4] & 0x80) == 0x80)
-            return static_cast<uint64_t>(buf[3]) | (static_cast<uint64_t>(buf[2]) << 8) |
-                   (static_cast<uint64_t>(buf[1]) << 16) | (static_cast<uint64_t>(buf[0]) << 24) |
-                   (static_cast<uint64_t>(buf[7]) << 32) | (static_cast<uint64_t>(buf[6]) << 40) |
-                   (static_cast<uint64_t>(buf[5]) << 48) | (static_cast<uint64_t>(buf[4] & 0x7F) << 56);
-        else
-            return static_cast<uint64_t>(buf[3]) | (static_cast<uint64_t>(buf[2]) << 8) |
-                   (static_cast<uint64_t>(buf[1]) << 16) | (static_cast<uint64_t>(buf[0]) << 24) |
-                   (static_cast<uint64_t>(buf[5]) << 32) | (static_cast<uint64_t>(buf[4]) << 40);
-    }
-
-    typeScn Ctx::readScnRLittle(const uint8_t* buf) {
-        if (buf[0] == 0xFF && buf[1] == 0xFF && buf[2] == 0xFF && buf[3] == 0xFF && buf[4] == 0xFF && buf[5] == 0xFF)
-            return ZERO_SCN;
-        if ((buf[1] & 0x80) == 0x80)
-            return static_cast<uint64_t>(buf[2]) | (static_cast<uint64_t>(buf[3]) << 8) |
-                   (static_cast<uint64_t>(buf[4]) << 16) | (static_cast<uint64_t>(buf[5]) << 24) |
-                   // (static_cast<uint64_t>(buf[6]) << 32) | (static_cast<uint64_t>(buf[7]) << 40) |
-                   (static_cast<uint64_t>(buf[0]) << 48) | (static_cast<uint64_t>(buf[1] & 0x7F) << 56);
-        else
-            return static_cast<uint64_t>(buf[2]) | (static_cast<uint64_t>(buf[3]) << 8) |
-                   (static_cast<uint64_t>(buf[4]) << 16) | (static_cast<uint64_t>(buf[5]) << 24) |
-                   (static_cast<uint64_t>(buf[0]) << 32) | (static_cast<uint64_t>(buf[1]) << 40);
-    }
-
-    typeScn Ctx::readScnRBig(const uint8_t* buf) {
-        if (buf[0] == 0xFF && buf[1] == 0xFF && buf[2] == 0xFF && buf[3] == 0xFF && buf[4] == 0xFF && buf[5] == 0xFF)
-            return ZERO_SCN;
-        if ((buf[0] & 0x80) == 0x80)
-            return static_cast<uint64_t>(buf[5]) | (static_cast<uint64_t>(buf[4]) << 8) |
-                   (static_cast<uint64_t>(buf[3]) << 16) | (static_cast<uint64_t>(buf[2]) << 24) |
-                   // (static_cast<uint64_t>(buf[7]) << 32) | (static_cast<uint64_t>(buf[6]) << 40) |
-                   (static_cast<uint64_t>(buf[1]) << 48) | (static_cast<uint64_t>(buf[0] & 0x7F) << 56);
-        else
-            return static_cast<uint64_t>(buf[5]) | (static_cast<uint64_t>(buf[4]) << 8) |
-                   (static_cast<uint64_t>(buf[3]) << 16) | (static_cast<uint64_t>(buf[2]) << 24) |
-                   (static_cast<uint64_t>(buf[1]) << 32) | (static_cast<uint64_t>(buf[0]) << 40);
-    }
-
-    void Ctx::write16Little(uint8_t* buf, uint16_t val) {
-        buf[0] = val & 0xFF;
-        buf[1] = (val >> 8) & 0xFF;
-    }
-
-    void Ctx::write16Big(uint8_t* buf, uint16_t val) {
-        buf[0] = (val >> 8) & 0xFF;
-        buf[1] = val & 0xFF;
-    }
-
-    void Ctx::write32Little(uint8_t* buf, uint32_t val) {
-        buf[0] = val & 0xFF;
-        buf[1] = (val >> 8) & 0xFF;
-        buf[2] = (val >> 16) & 0xFF;
-        buf[3] = (val >> 24) & 0xFF;
-    }
-
-    void Ctx::write32Big(uint8_t* buf, uint32_t val) {
-        buf[0] = (val >> 24) & 0xFF;
-        buf[1] = (val >> 16) & 0xFF;
-        buf[2] = (val >> 8) & 0xFF;
-        buf[3] = val & 0xFF;
-    }
-
-    void Ctx::write56Little(uint8_t* buf, uint64_t val) {
-        buf[0] = val & 0xFF;
-        buf[1] = (val >> 8) & 0xFF;
-        buf[2] = (val >> 16) & 0xFF;
-        buf[3] = (val >> 24) & 0xFF;
-        buf[4] = (val >> 32) & 0xFF;
-        buf[5] = (val >> 40) & 0xFF;
-        buf[6] = (val >> 48) & 0xFF;
-    }
-
-    void Ctx::write56Big(uint8_t* buf, uint64_t val) {
-        buf[0] = (val >> 24) & 0xFF;
-        buf[1] = (val >> 16) & 0xFF;
-        buf[2] = (val >> 8) & 0xFF;
-        buf[3] = val & 0xFF;
-        buf[4] = (val >> 40) & 0xFF;
-        buf[5] = (val >> 32) & 0xFF;
-        buf[6] = (val >> 48) & 0xFF;
-    }
-
-    void Ctx::write64Little(uint8_t* buf, uint64_t val) {
-        buf[0] = val & 0xFF;
-        buf[1] = (val >> 8) & 0xFF;
-        buf[2] = (val >> 16) & 0xFF;
-        buf[3] = (val >> 24) & 0xFF;
-        buf[4] = (val >> 32) & 0xFF;
-        buf[5] = (val >> 40) & 0xFF;
-        buf[6] = (val >> 48) & 0xFF;
-        buf[7] = (val >> 56) & 0xFF;
-    }
-
-    void Ctx::write64Big(uint8_t* buf, uint64_t val) {
-        buf[0] = (val >> 56) & 0xFF;
-        buf[1] = (val >> 48) & 0xFF;
-        buf[2] = (val >> 40) & 0xFF;
-        buf[3] = (val >> 32) & 0xFF;
-        buf[4] = (val >> 24) & 0xFF;
-        buf[5] = (val >> 16) & 0xFF;
-        buf[6] = (val >> 8) & 0xFF;
-        buf[7] = val & 0xFF;
-    }
-
-    void Ctx::writeScnLittle(uint8_t* buf, typeScn val) {
-        if (val < 0x800000000000) {
-            buf[0] = val & 0xFF;
-            buf[1] = (val >> 8) & 0xFF;
-            buf[2] = (val >> 16) & 0xFF;
-            buf[3] = (val >> 24) & 0xFF;
-            buf[4] = (val >> 32) & 0xFF;
-            buf[5] = (val >> 40) & 0xFF;
-        } else {
-            buf[0] = val & 0xFF;
-            buf[1] = (val >> 8) & 0xFF;
-            buf[2] = (val >> 16) & 0xFF;
-            buf[3] = (val >> 24) & 0xFF;
-            buf[4] = (val >> 48) & 0xFF;
-            buf[5] = ((val >> 56) & 0x7F) | 0x80;
-            buf[6] = (val >> 32) & 0xFF;
-            buf[7] = (val >> 40) & 0xFF;
-        }
-    }
-
-    void Ctx::writeScnBig(uint8_t* buf, typeScn val) {
-        if (val < 0x800000000000) {
-            buf[0] = (val >> 24) & 0xFF;
-            buf[1] = (val >> 16) & 0xFF;
-            buf[2] = (val >> 8) & 0xFF;
-            buf[3] = val & 0xFF;
-            buf[4] = (val >> 40) & 0xFF;
-            buf[5] = (val >> 32) & 0xFF;
-        } else {
-            buf[0] = (val >> 24) & 0xFF;
-            buf[1] = (val >> 16) & 0xFF;
-            buf[2] = (val >> 8) & 0xFF;
-            buf[3] = val & 0xFF;
-            buf[4] = ((val >> 56) & 0x7F) | 0x80;
-            buf[5] = (val >> 48) & 0xFF;
-            buf[6] = (val >> 40) & 0xFF;
-            buf[7] = (val >> 32) & 0xFF;
-        }
-    }
-
     const rapidjson::Value& Ctx::getJsonFieldA(const std::string& fileName, const rapidjson::Value& value, const char* field) {
         if (!value.HasMember(field))
             throw DataException(20003, "file: " + fileName + " - parse error, field " + field + " not found");
@@ -561,17 +367,20 @@ namespace OpenLogReplicator {
     void Ctx::initialize(uint64_t newMemoryMinMb, uint64_t newMemoryMaxMb, uint64_t newReadBufferMax) {
         memoryMinMb = newMemoryMinMb;
         memoryMaxMb = newMemoryMaxMb;
-        memoryChunksMin = (memoryMinMb / MEMORY_CHUNK_SIZE_MB);
-        memoryChunksMax = memoryMaxMb / MEMORY_CHUNK_SIZE_MB;
+        memoryChunksMin = (memoryMinMb / memoryChunkSizeMb);
+        memoryChunksMax = memoryMaxMb / memoryChunkSizeMb;
         readBufferMax = newReadBufferMax;
         buffersFree = newReadBufferMax;
-        bufferSizeMax = readBufferMax * MEMORY_CHUNK_SIZE;
-
-        memoryChunks = new uint8_t*[memoryMaxMb / MEMORY_CHUNK_SIZE_MB];
-        for (uint64_t i = 0; i < memoryChunksMin; ++i) {
-            memoryChunks[i] = reinterpret_cast<uint8_t*>(aligned_alloc(MEMORY_ALIGNMENT, MEMORY_CHUNK_SIZE));
+        bufferSizeMax = readBufferMax * memoryChunkSize;
+
+        memoryChunks = new uint8_t*[memoryMaxMb / memoryChunkSizeMb];
+        // Regions are not bound to any NUMA node until the first chunk is taken by a thread
+        while (memoryPooled() && memoryChunksAllocated < memoryChunksMin)
+            memoryAllocateRegion("memory chunks#2", -1);
+        for (uint64_t i = memoryChunksAllocated; i < memoryChunksMin; ++i) {
+            memoryChunks[i] = reinterpret_cast<uint8_t*>(aligned_alloc(MEMORY_ALIGNMENT, memoryChunkSize));
             if (memoryChunks[i] == nullptr)
-                throw RuntimeException(10016, "couldn't allocate " + std::to_string(MEMORY_CHUNK_SIZE_MB) +
+                throw RuntimeException(10016, "couldn't allocate " + std::to_string(memoryChunkSize) +
                                        " bytes memory for: memory chunks#2");
             ++memoryChunksAllocated;
             ++memoryChunksFree;
@@ -585,18 +394,180 @@ namespace OpenLogReplicator {
     }
 
     uint64_t Ctx::getMaxUsedMemory() const {
-        return memoryChunksHWM * MEMORY_CHUNK_SIZE_MB;
+        return memoryChunksHWM * memoryChunkSizeMb;
     }
 
     uint64_t Ctx::getFreeMemory() {
-        return memoryChunksFree * MEMORY_CHUNK_SIZE_MB;
+        return memoryChunksFree * memoryChunkSizeMb;
     }
 
     uint64_t Ctx::getAllocatedMemory() const {
-        return memoryChunksAllocated * MEMORY_CHUNK_SIZE_MB;
+        return memoryChunksAllocated * memoryChunkSizeMb;
+    }
+
+    uint64_t Ctx::getHugePagesMemory() const {
+        return memoryChunksHuge * memoryChunkSizeMb;
+    }
+
+    uint64_t Ctx::getRemoteNodeChunks() const {
+        return memoryChunksRemote;
+    }
+
+    uint64_t Ctx::getThpMemory() {
+        // Transparent huge pages actually backing the process memory, not only the memory chunks
+        uint64_t thpKb = 0;
+#if __linux__
+        std::ifstream smaps("/proc/self/smaps_rollup");
+        std::string line;
+        while (smaps.good() && std::getline(smaps, line)) {
+            if (line.compare(0, 14, "AnonHugePages:") == 0) {
+                thpKb = strtoull(line.c_str() + 14, nullptr, 10);
+                break;
+            }
+        }
+#endif
+        return thpKb / 1024;
+    }
+
+    bool Ctx::memoryPooled() const {
+        return memoryHugePages != MEMORY_HUGE_PAGES_NONE || memoryNuma;
+    }
+
+    int64_t Ctx::memoryNode() {
+#if __linux__
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+            return static_cast<int64_t>(node);
+#endif
+        return -1;
+    }
+
+    MemoryRegion* Ctx::memoryRegion(const uint8_t* chunk) {
+        auto regionIt = memoryRegions.upper_bound(const_cast<uint8_t*>(chunk));
+        if (regionIt == memoryRegions.begin())
+            return nullptr;
+        --regionIt;
+        if (chunk >= regionIt->second.data + regionIt->second.size)
+            return nullptr;
+        return &regionIt->second;
+    }
+
+    void Ctx::memoryBind(MemoryRegion& region, int64_t node) {
+        region.node = node;
+#if __linux__
+        if (node < 0 || node >= 64)
+            return;
+
+        // MPOL_PREFERRED: pages are taken from the node, other nodes are used only when it is exhausted
+        uint64_t nodeMask = 1ULL << node;
+        if (syscall(SYS_mbind, region.data, region.size, 1, &nodeMask, sizeof(nodeMask) * 8 + 1, 0) != 0) {
+            if (trace & TRACE_THREADS)
+                logTrace(TRACE_THREADS, "mbind to node " + std::to_string(node) + " returned: " + strerror(errno));
+        }
+#endif
+    }
+
+    void Ctx::memoryAllocateRegion(const char* module, int64_t node) {
+        MemoryRegion region{nullptr, memoryChunkSize, -1, false};
+        if (memoryHugePages == MEMORY_HUGE_PAGES_HUGETLB_1G)
+            region.size = MEMORY_HUGE_PAGE_SIZE_1G;
+        else if (memoryHugePages != MEMORY_HUGE_PAGES_NONE && memoryChunkSize < MEMORY_HUGE_PAGE_SIZE)
+            region.size = MEMORY_HUGE_PAGE_SIZE;
+
+        uint64_t chunks = region.size / memoryChunkSize;
+        if (memoryChunksAllocated + chunks > memoryChunksMax)
+            chunks = (memoryChunksAllocated < memoryChunksMax) ? memoryChunksMax - memoryChunksAllocated : 1;
+
+        // A clamped region smaller than 1 GB is taken from 2 MB pages, so that no more than memory-max-mb is reserved
+        if (memoryHugePages == MEMORY_HUGE_PAGES_HUGETLB_1G && chunks * memoryChunkSize < region.size)
+            region.size = ((chunks * memoryChunkSize + MEMORY_HUGE_PAGE_SIZE - 1) / MEMORY_HUGE_PAGE_SIZE) * MEMORY_HUGE_PAGE_SIZE;
+
+        void* data = MAP_FAILED;
+#if __linux__
+        if (memoryHugePages == MEMORY_HUGE_PAGES_HUGETLB || memoryHugePages == MEMORY_HUGE_PAGES_HUGETLB_1G) {
+            int hugeFlag = (memoryHugePages == MEMORY_HUGE_PAGES_HUGETLB_1G && region.size % MEMORY_HUGE_PAGE_SIZE_1G == 0) ?
+                           MAP_HUGE_1GB : MAP_HUGE_2MB;
+            data = mmap(nullptr, region.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | hugeFlag, -1, 0);
+            if (data != MAP_FAILED) {
+                region.huge = true;
+            } else {
+                if (!memoryHugePagesFallback) {
+                    memoryHugePagesFallback = true;
+                    warning(60039, "huge pages not available for: " + std::string(module) + " - mmap returned: " + strerror(errno) +
+                            ", falling back to regular pages");
+                }
+                region.size = chunks * memoryChunkSize;
+            }
+        } else if (memoryHugePages == MEMORY_HUGE_PAGES_THP) {
+            // Over-allocate to align the region to the huge page size
+            auto raw = reinterpret_cast<uint8_t*>(mmap(nullptr, region.size + MEMORY_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (raw != MAP_FAILED) {
+                auto aligned = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(raw) + MEMORY_HUGE_PAGE_SIZE - 1) &
+                                                          ~static_cast<uintptr_t>(MEMORY_HUGE_PAGE_SIZE - 1));
+                if (aligned > raw)
+                    munmap(raw, aligned - raw);
+                if (raw + MEMORY_HUGE_PAGE_SIZE > aligned)
+                    munmap(aligned + region.size, raw + MEMORY_HUGE_PAGE_SIZE - aligned);
+                data = aligned;
+                if (madvise(data, region.size, MADV_HUGEPAGE) == 0)
+                    region.huge = true;
+                else if (!memoryHugePagesFallback) {
+                    memoryHugePagesFallback = true;
+                    warning(60039, "huge pages not available for: " + std::string(module) + " - madvise returned: " + strerror(errno) +
+                            ", falling back to regular pages");
+                }
+            }
+        }
+#endif
+        if (data == MAP_FAILED)
+            data = mmap(nullptr, region.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED)
+            throw RuntimeException(10016, "couldn't allocate " + std::to_string(region.size) + " bytes memory for: " + module);
+
+        region.data = reinterpret_cast<uint8_t*>(data);
+        // The region is not touched yet, so binding moves no pages
+        if (memoryNuma && node >= 0)
+            memoryBind(region, node);
+        memoryRegions.insert_or_assign(region.data, region);
+
+        for (uint64_t i = 0; i < chunks; ++i) {
+            memoryChunks[memoryChunksFree] = region.data + i * memoryChunkSize;
+            ++memoryChunksFree;
+            ++memoryChunksAllocated;
+        }
+        if (region.huge)
+            memoryChunksHuge += chunks;
+    }
+
+    void Ctx::memoryPick(int64_t node) {
+        if (node < 0 || memoryChunksFree == 0)
+            return;
+
+        // Move a free chunk bound to the node of the calling thread to the top of the stack
+        uint64_t last = memoryChunksFree - 1;
+        uint64_t scan = (memoryChunksFree < MEMORY_NUMA_SCAN) ? static_cast<uint64_t>(memoryChunksFree) : MEMORY_NUMA_SCAN;
+        for (uint64_t i = 0; i < scan; ++i) {
+            MemoryRegion* region = memoryRegion(memoryChunks[last - i]);
+            if (region == nullptr)
+                continue;
+            if (region->node == -1)
+                memoryBind(*region, node);
+            if (region->node == node) {
+                std::swap(memoryChunks[last - i], memoryChunks[last]);
+                return;
+            }
+        }
+
+        if (memoryChunksAllocated < memoryChunksMax)
+            memoryAllocateRegion("memory chunks#3", node);
+        else
+            ++memoryChunksRemote;
     }
 
     uint8_t* Ctx::getMemoryChunk(const char* module, bool reusable) {
+        int64_t node = memoryNuma ? memoryNode() : -1;
         std::unique_lock<std::mutex> lck(memoryMtx);
 
         if (memoryChunksFree == 0) {
@@ -611,20 +582,24 @@ namespace OpenLogReplicator {
                 }
             }
 
-            if (memoryChunksFree == 0) {
-                memoryChunks[0] = reinterpret_cast<uint8_t*>(aligned_alloc(MEMORY_ALIGNMENT, MEMORY_CHUNK_SIZE));
+            if (memoryChunksFree == 0 && memoryPooled()) {
+                memoryAllocateRegion(module, node);
+            } else if (memoryChunksFree == 0) {
+                memoryChunks[0] = reinterpret_cast<uint8_t*>(aligned_alloc(MEMORY_ALIGNMENT, memoryChunkSize));
                 if (memoryChunks[0] == nullptr) {
-                    throw RuntimeException(10016, "couldn't allocate " + std::to_string(MEMORY_CHUNK_SIZE_MB) +
+                    throw RuntimeException(10016, "couldn't allocate " + std::to_string(memoryChunkSize) +
                                            " bytes memory for: " + module);
                 }
                 ++memoryChunksFree;
                 ++memoryChunksAllocated;
             }
-
-            if (memoryChunksAllocated > memoryChunksHWM)
-                memoryChunksHWM = static_cast<uint64_t>(memoryChunksAllocated);
+        } else if (node >= 0) {
+            memoryPick(node);
         }
 
+        if (memoryChunksAllocated > memoryChunksHWM)
+            memoryChunksHWM = static_cast<uint64_t>(memoryChunksAllocated);
+
         --memoryChunksFree;
         if (reusable)
             ++memoryChunksReusable;
@@ -637,8 +612,8 @@ namespace OpenLogReplicator {
         if (memoryChunksFree == memoryChunksAllocated)
             throw RuntimeException(50001, "trying to free unknown memory block for: " + std::string(module));
 
-        // Keep memoryChunksMin reserved
-        if (memoryChunksFree >= memoryChunksMin) {
+        // Keep memoryChunksMin reserved, chunks carved from regions are never released
+        if (memoryChunksFree >= memoryChunksMin && !memoryPooled()) {
             free(chunk);
             --memoryChunksAllocated;
         } else {
@@ -823,11 +798,16 @@ namespace OpenLogReplicator {
         ++buffersFree;
     }
 
-    void Ctx::allocateBuffer() {
+    bool Ctx::allocateBuffer() {
         std::unique_lock<std::mutex> lck(memoryMtx);
+        // Many readers might compete for the last buffer
+        if (buffersFree == 0)
+            return false;
+
         --buffersFree;
         if (readBufferMax - buffersFree > buffersMaxUsed)
             buffersMaxUsed = readBufferMax - buffersFree;
+        return true;
     }
 
     void Ctx::signalDump() {
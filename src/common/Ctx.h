@@ -20,6 +20,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include <atomic>
 #include <condition_variable>
 #include <fstream>
+#include <map>
 #include <mutex>
 #include <rapidjson/document.h>
 #include <rapidjson/error/en.h>
@@ -38,10 +39,17 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #define REDO_VERSION_18_0       0x12000000
 #define REDO_VERSION_19_0       0x13000000
 
-#define MEMORY_CHUNK_SIZE_MB                    1
-#define MEMORY_CHUNK_SIZE                       (MEMORY_CHUNK_SIZE_MB*1024*1024)
+#define MEMORY_CHUNK_SIZE_MB_MAX                16
 #define MEMORY_CHUNK_MIN_MB                     16
 
+#define MEMORY_HUGE_PAGES_NONE                  0
+#define MEMORY_HUGE_PAGES_THP                   1
+#define MEMORY_HUGE_PAGES_HUGETLB               2
+#define MEMORY_HUGE_PAGES_HUGETLB_1G            3
+#define MEMORY_HUGE_PAGE_SIZE                   (2ULL*1024*1024)
+#define MEMORY_HUGE_PAGE_SIZE_1G                (1024ULL*1024*1024)
+#define MEMORY_NUMA_SCAN                        32
+
 #define OLR_LOCALES_TIMESTAMP                   0
 #define OLR_LOCALES_MOCK                        1
 
@@ -93,13 +101,35 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #define DISABLE_CHECKS_BLOCK_SUM                0x00000004
 #define DISABLE_CHECKS(x)                       ((ctx->disableChecks&(x))!=0)
 
+#define READ_ENGINE_PREAD                       0
+#define READ_ENGINE_IO_URING                    1
+#define READ_ENGINE_MMAP                        2
+
+#define REDO_READ_TAIL_SLEEP                    0
+#define REDO_READ_TAIL_ADAPTIVE                 1
+
+#define ARCH_DISCOVERY_SCAN                     0
+#define ARCH_DISCOVERY_INOTIFY                  1
+
+#define REDO_COPY_COMPRESSION_NONE              0
+#define REDO_COPY_COMPRESSION_ZSTD              1
+#define REDO_COPY_COMPRESSION_LZ4               2
+
 #ifndef GLOBALS
 extern uint64_t OLR_LOCALES;
 #endif
 
 namespace OpenLogReplicator {
+    class PerfStats;
     class Thread;
 
+    struct MemoryRegion {
+        uint8_t* data;
+        uint64_t size;
+        int64_t node;
+        bool huge;
+    };
+
     class Ctx {
     protected:
         bool bigEndian;
@@ -113,6 +143,10 @@ namespace OpenLogReplicator {
         std::atomic<uint64_t> memoryChunksMax;
         std::atomic<uint64_t> memoryChunksHWM;
         std::atomic<uint64_t> memoryChunksReusable;
+        std::atomic<uint64_t> memoryChunksHuge;
+        std::atomic<uint64_t> memoryChunksRemote;
+        std::map<uint8_t*, MemoryRegion> memoryRegions;
+        bool memoryHugePagesFallback;
 
         std::condition_variable condMainLoop;
         std::condition_variable condOutOfMemory;
@@ -121,6 +155,13 @@ namespace OpenLogReplicator {
         std::set<Thread*> threads;
         pthread_t mainThread;
 
+        [[nodiscard]] bool memoryPooled() const;
+        [[nodiscard]] static int64_t memoryNode();
+        [[nodiscard]] MemoryRegion* memoryRegion(const uint8_t* chunk);
+        void memoryBind(MemoryRegion& region, int64_t node);
+        void memoryAllocateRegion(const char* module, int64_t node);
+        void memoryPick(int64_t node);
+
     public:
         static const char map10[11];
         static const char map16[17];
@@ -137,12 +178,16 @@ namespace OpenLogReplicator {
         void setBigEndian();
         [[nodiscard]] bool isBigEndian() const;
 
+        // Memory
+        uint64_t memoryChunkSizeMb;
+        uint64_t memoryChunkSize;
+        uint64_t memoryHugePages;
+        bool memoryNuma;
         // Disk read buffers
         std::atomic<uint64_t> readBufferMax;
         std::atomic<uint64_t> buffersFree;
         std::atomic<uint64_t> bufferSizeMax;
         std::atomic<uint64_t> buffersMaxUsed;
-        std::atomic<uint64_t> suppLogSize;
         // Checkpoint
         uint64_t checkpointIntervalS;
         uint64_t checkpointIntervalMb;
@@ -150,20 +195,36 @@ namespace OpenLogReplicator {
         uint64_t schemaForceInterval;
         // Reader
         uint64_t redoReadSleepUs;
+        uint64_t redoReadTail;
+        uint64_t redoReadSpinUs;
         uint64_t redoVerifyDelayUs;
         uint64_t archReadSleepUs;
         uint64_t archReadTries;
         uint64_t refreshIntervalUs;
+        uint64_t readEngine;
+        uint64_t readQueueDepth;
+        uint64_t archPrefetch;
+        uint64_t archCatchupThreads;
+        uint64_t archDiscovery;
+        // Parser
+        bool parserPipeline;
+        uint64_t commitQueueMb;
+        // Performance report, set only when requested
+        PerfStats* perfStats;
         // Writer
         uint64_t pollIntervalUs;
         uint64_t queueSize;
         // Transaction buffer
         std::string dumpPath;
         std::string redoCopyPath;
+        uint64_t redoCopyCompression;
+        uint64_t redoCopyBufferSize;
         uint64_t stopLogSwitches;
         uint64_t stopCheckpoints;
         uint64_t stopTransactions;
         uint64_t transactionSizeMax;
+        uint64_t transactionSpillMb;
+        std::string transactionSpillPath;
         std::atomic<uint64_t> logLevel;
         std::atomic<uint64_t> trace;
         std::atomic<uint64_t> flags;
@@ -176,17 +237,65 @@ namespace OpenLogReplicator {
         Ctx();
         virtual ~Ctx();
 
-        uint16_t (*read16)(const uint8_t* buf);
-        uint32_t (*read32)(const uint8_t* buf);
-        uint64_t (*read56)(const uint8_t* buf);
-        uint64_t (*read64)(const uint8_t* buf);
-        typeScn (*readScn)(const uint8_t* buf);
-        typeScn (*readScnR)(const uint8_t* buf);
-        void (*write16)(uint8_t* buf, uint16_t val);
-        void (*write32)(uint8_t* buf, uint32_t val);
-        void (*write56)(uint8_t* buf, uint64_t val);
-        void (*write64)(uint8_t* buf, uint64_t val);
-        void (*writeScn)(uint8_t* buf, typeScn val);
+        // Inline, so that the compiler can optimize the field access in the parser instead of an indirect call
+        [[nodiscard]] uint16_t read16(const uint8_t* buf) const {
+            return bigEndian ? read16Big(buf) : read16Little(buf);
+        }
+
+        [[nodiscard]] uint32_t read32(const uint8_t* buf) const {
+            return bigEndian ? read32Big(buf) : read32Little(buf);
+        }
+
+        [[nodiscard]] uint64_t read56(const uint8_t* buf) const {
+            return bigEndian ? read56Big(buf) : read56Little(buf);
+        }
+
+        [[nodiscard]] uint64_t read64(const uint8_t* buf) const {
+            return bigEndian ? read64Big(buf) : read64Little(buf);
+        }
+
+        [[nodiscard]] typeScn readScn(const uint8_t* buf) const {
+            return bigEndian ? readScnBig(buf) : readScnLittle(buf);
+        }
+
+        [[nodiscard]] typeScn readScnR(const uint8_t* buf) const {
+            return bigEndian ? readScnRBig(buf) : readScnRLittle(buf);
+        }
+
+        void write16(uint8_t* buf, uint16_t val) const {
+            if (bigEndian)
+                write16Big(buf, val);
+            else
+                write16Little(buf, val);
+        }
+
+        void write32(uint8_t* buf, uint32_t val) const {
+            if (bigEndian)
+                write32Big(buf, val);
+            else
+                write32Little(buf, val);
+        }
+
+        void write56(uint8_t* buf, uint64_t val) const {
+            if (bigEndian)
+                write56Big(buf, val);
+            else
+                write56Little(buf, val);
+        }
+
+        void write64(uint8_t* buf, uint64_t val) const {
+            if (bigEndian)
+                write64Big(buf, val);
+            else
+                write64Little(buf, val);
+        }
+
+        void writeScn(uint8_t* buf, typeScn val) const {
+            if (bigEndian)
+                writeScnBig(buf, val);
+            else
+                writeScnLittle(buf, val);
+        }
 
         static uint16_t read16Little(const uint8_t* buf);
         static uint16_t read16Big(const uint8_t* buf);
@@ -239,6 +348,9 @@ namespace OpenLogReplicator {
         [[nodiscard]] uint64_t getMaxUsedMemory() const;
         [[nodiscard]] uint64_t getAllocatedMemory() const;
         [[nodiscard]] uint64_t getFreeMemory();
+        [[nodiscard]] uint64_t getHugePagesMemory() const;
+        [[nodiscard]] uint64_t getRemoteNodeChunks() const;
+        [[nodiscard]] static uint64_t getThpMemory();
         [[nodiscard]] uint8_t* getMemoryChunk(const char* module, bool reusable);
         void freeMemoryChunk(const char* module, uint8_t* chunk, bool reusable);
         void stopHard();
@@ -254,7 +366,7 @@ namespace OpenLogReplicator {
         static std::ostringstream& writeEscapeValue(std::ostringstream& ss, const std::string& str);
         static bool checkNameCase(const char* name);
         void releaseBuffer();
-        void allocateBuffer();
+        [[nodiscard]] bool allocateBuffer();
         void signalDump();
 
         void welcome(const std::string& message);
@@ -265,6 +377,219 @@ namespace OpenLogReplicator {
         void debug(int code, const std::string& message);
         void logTrace(int mask, const std::string& message);
     };
+
+    inline uint16_t Ctx::read16Little(const uint8_t* buf) {
+        return static_cast<uint16_t>(buf[0]) | (static_cast<uint16_t>(buf[1]) << 8);
+    }
+
+    inline uint16_t Ctx::read16Big(const uint8_t* buf) {
+        return (static_cast<uint16_t>(buf[0]) << 8) | static_cast<uint16_t>(buf[1]);
+    }
+
+    inline uint32_t Ctx::read24Big(const uint8_t* buf) {
+        return (static_cast<uint32_t>(buf[0]) << 16) |
+               (static_cast<uint32_t>(buf[1]) << 8) | static_cast<uint32_t>(buf[2]);
+    }
+
+    inline uint32_t Ctx::read32Little(const uint8_t* buf) {
+        return static_cast<uint32_t>(buf[0]) | (static_cast<uint32_t>(buf[1]) << 8) |
+               (static_cast<uint32_t>(buf[2]) << 16) | (static_cast<uint32_t>(buf[3]) << 24);
+    }
+
+    inline uint32_t Ctx::read32Big(const uint8_t* buf) {
+        return (static_cast<uint32_t>(buf[0]) << 24) | (static_cast<uint32_t>(buf[1]) << 16) |
+               (static_cast<uint32_t>(buf[2]) << 8) | static_cast<uint32_t>(buf[3]);
+    }
+
+    inline uint64_t Ctx::read56Little(const uint8_t* buf) {
+        return static_cast<uint64_t>(buf[0]) | (static_cast<uint64_t>(buf[1]) << 8) |
+               (static_cast<uint64_t>(buf[2]) << 16) | (static_cast<uint64_t>(buf[3]) << 24) |
+               (static_cast<uint64_t>(buf[4]) << 32) | (static_cast<uint64_t>(buf[5]) << 40) |
+               (static_cast<uint64_t>(buf[6]) << 48);
+    }
+
+    inline uint64_t Ctx::read56Big(const uint8_t* buf) {
+        return (static_cast<uint64_t>(buf[0]) << 24) | (static_cast<uint64_t>(buf[1]) << 16) |
+                (static_cast<uint64_t>(buf[2]) << 8) | (static_cast<uint64_t>(buf[3])) |
+                (static_cast<uint64_t>(buf[4]) << 40) | (static_cast<uint64_t>(buf[5]) << 32) |
+                (static_cast<uint64_t>(buf[6]) << 48);
+    }
+
+    inline uint64_t Ctx::read64Little(const uint8_t* buf) {
+        return static_cast<uint64_t>(buf[0]) | (static_cast<uint64_t>(buf[1]) << 8) |
+               (static_cast<uint64_t>(buf[2]) << 16) | (static_cast<uint64_t>(buf[3]) << 24) |
+               (static_cast<uint64_t>(buf[4]) << 32) | (static_cast<uint64_t>(buf[5]) << 40) |
+               (static_cast<uint64_t>(buf[6]) << 48) | (static_cast<uint64_t>(buf[7]) << 56);
+    }
+
+    inline uint64_t Ctx::read64Big(const uint8_t* buf) {
+        return (static_cast<uint64_t>(buf[0]) << 56) | (static_cast<uint64_t>(buf[1]) << 48) |
+               (static_cast<uint64_t>(buf[2]) << 40) | (static_cast<uint64_t>(buf[3]) << 32) |
+               (static_cast<uint64_t>(buf[4]) << 24) | (static_cast<uint64_t>(buf[5]) << 16) |
+               (static_cast<uint64_t>(buf[6]) << 8) | static_cast<uint64_t>(buf[7]);
+    }
+
+    inline typeScn Ctx::readScnLittle(const uint8_t* buf) {
+        if (buf[0] == 0xFF && buf[1] == 0xFF && buf[2] == 0xFF && buf[3] == 0xFF && buf[4] == 0xFF && buf[5] == 0xFF)
+            return ZERO_SCN;
+        if ((buf[5] & 0x80) == 0x80)
+            return static_cast<uint64_t>(buf[0]) | (static_cast<uint64_t>(buf[1]) << 8) |
+                   (static_cast<uint64_t>(buf[2]) << 16) | (static_cast<uint64_t>(buf[3]) << 24) |
+                   (static_cast<uint64_t>(buf[6]) << 32) | (static_cast<uint64_t>(buf[7]) << 40) |
+                   (static_cast<uint64_t>(buf[4]) << 48) | (static_cast<uint64_t>(buf[5] & 0x7F) << 56);
+        else
+            return static_cast<uint64_t>(buf[0]) | (static_cast<uint64_t>(buf[1]) << 8) |
+                   (static_cast<uint64_t>(buf[2]) << 16) | (static_cast<uint64_t>(buf[3]) << 24) |
+                   (static_cast<uint64_t>(buf[4]) << 32) | (static_cast<uint64_t>(buf[5]) << 40);
+    }
+
+    inline typeScn Ctx::readScnBig(const uint8_t* buf) {
+        if (buf[0] == 0xFF && buf[1] == 0xFF && buf[2] == 0xFF && buf[3] == 0xFF && buf[4] == 0xFF && buf[5] == 0xFF)
+            return ZERO_SCN;
+        if ((buf[4] & 0x80) == 0x80)
+            return static_cast<uint64_t>(buf[3]) | (static_cast<uint64_t>(buf[2]) << 8) |
+                   (static_cast<uint64_t>(buf[1]) << 16) | (static_cast<uint64_t>(buf[0]) << 24) |
+                   (static_cast<uint64_t>(buf[7]) << 32) | (static_cast<uint64_t>(buf[6]) << 40) |
+                   (static_cast<uint64_t>(buf[5]) << 48) | (static_cast<uint64_t>(buf[4] & 0x7F) << 56);
+        else
+            return static_cast<uint64_t>(buf[3]) | (static_cast<uint64_t>(buf[2]) << 8) |
+                   (static_cast<uint64_t>(buf[1]) << 16) | (static_cast<uint64_t>(buf[0]) << 24) |
+                   (static_cast<uint64_t>(buf[5]) << 32) | (static_cast<uint64_t>(buf[4]) << 40);
+    }
+
+    inline typeScn Ctx::readScnRLittle(const uint8_t* buf) {
+        if (buf[0] == 0xFF && buf[1] == 0xFF && buf[2] == 0xFF && buf[3] == 0xFF && buf[4] == 0xFF && buf[5] == 0xFF)
+            return ZERO_SCN;
+        if ((buf[1] & 0x80) == 0x80)
+            return static_cast<uint64_t>(buf[2]) | (static_cast<uint64_t>(buf[3]) << 8) |
+                   (static_cast<uint64_t>(buf[4]) << 16) | (static_cast<uint64_t>(buf[5]) << 24) |
+                   // (static_cast<uint64_t>(buf[6]) << 32) | (static_cast<uint64_t>(buf[7]) << 40) |
+                   (static_cast<uint64_t>(buf[0]) << 48) | (static_cast<uint64_t>(buf[1] & 0x7F) << 56);
+        else
+            return static_cast<uint64_t>(buf[2]) | (static_cast<uint64_t>(buf[3]) << 8) |
+                   (static_cast<uint64_t>(buf[4]) << 16) | (static_cast<uint64_t>(buf[5]) << 24) |
+                   (static_cast<uint64_t>(buf[0]) << 32) | (static_cast<uint64_t>(buf[1]) << 40);
+    }
+
+    inline typeScn Ctx::readScnRBig(const uint8_t* buf) {
+        if (buf[0] == 0xFF && buf[1] == 0xFF && buf[2] == 0xFF && buf[3] == 0xFF && buf[4] == 0xFF && buf[5] == 0xFF)
+            return ZERO_SCN;
+        if ((buf[0] & 0x80) == 0x80)
+            return static_cast<uint64_t>(buf[5]) | (static_cast<uint64_t>(buf[4]) << 8) |
+                   (static_cast<uint64_t>(buf[3]) << 16) | (static_cast<uint64_t>(buf[2]) << 24) |
+                   // (static_cast<uint64_t>(buf[7]) << 32) | (static_cast<uint64_t>(buf[6]) << 40) |
+                   (static_cast<uint64_t>(buf[1]) << 48) | (static_cast<uint64_t>(buf[0] & 0x7F) << 56);
+        else
+            return static_cast<uint64_t>(buf[5]) | (static_cast<uint64_t>(buf[4]) << 8) |
+                   (static_cast<uint64_t>(buf[3]) << 16) | (static_cast<uint64_t>(buf[2]) << 24) |
+                   (static_cast<uint64_t>(buf[1]) << 32) | (static_cast<uint64_t>(buf[0]) << 40);
+    }
+
+    inline void Ctx::write16Little(uint8_t* buf, uint16_t val) {
+        buf[0] = val & 0xFF;
+        buf[1] = (val >> 8) & 0xFF;
+    }
+
+    inline void Ctx::write16Big(uint8_t* buf, uint16_t val) {
+        buf[0] = (val >> 8) & 0xFF;
+        buf[1] = val & 0xFF;
+    }
+
+    inline void Ctx::write32Little(uint8_t* buf, uint32_t val) {
+        buf[0] = val & 0xFF;
+        buf[1] = (val >> 8) & 0xFF;
+        buf[2] = (val >> 16) & 0xFF;
+        buf[3] = (val >> 24) & 0xFF;
+    }
+
+    inline void Ctx::write32Big(uint8_t* buf, uint32_t val) {
+        buf[0] = (val >> 24) & 0xFF;
+        buf[1] = (val >> 16) & 0xFF;
+        buf[2] = (val >> 8) & 0xFF;
+        buf[3] = val & 0xFF;
+    }
+
+    inline void Ctx::write56Little(uint8_t* buf, uint64_t val) {
+        buf[0] = val & 0xFF;
+        buf[1] = (val >> 8) & 0xFF;
+        buf[2] = (val >> 16) & 0xFF;
+        buf[3] = (val >> 24) & 0xFF;
+        buf[4] = (val >> 32) & 0xFF;
+        buf[5] = (val >> 40) & 0xFF;
+        buf[6] = (val >> 48) & 0xFF;
+    }
+
+    inline void Ctx::write56Big(uint8_t* buf, uint64_t val) {
+        buf[0] = (val >> 24) & 0xFF;
+        buf[1] = (val >> 16) & 0xFF;
+        buf[2] = (val >> 8) & 0xFF;
+        buf[3] = val & 0xFF;
+        buf[4] = (val >> 40) & 0xFF;
+        buf[5] = (val >> 32) & 0xFF;
+        buf[6] = (val >> 48) & 0xFF;
+    }
+
+    inline void Ctx::write64Little(uint8_t* buf, uint64_t val) {
+        buf[0] = val & 0xFF;
+        buf[1] = (val >> 8) & 0xFF;
+        buf[2] = (val >> 16) & 0xFF;
+        buf[3] = (val >> 24) & 0xFF;
+        buf[4] = (val >> 32) & 0xFF;
+        buf[5] = (val >> 40) & 0xFF;
+        buf[6] = (val >> 48) & 0xFF;
+        buf[7] = (val >> 56) & 0xFF;
+    }
+
+    inline void Ctx::write64Big(uint8_t* buf, uint64_t val) {
+        buf[0] = (val >> 56) & 0xFF;
+        buf[1] = (val >> 48) & 0xFF;
+        buf[2] = (val >> 40) & 0xFF;
+        buf[3] = (val >> 32) & 0xFF;
+        buf[4] = (val >> 24) & 0xFF;
+        buf[5] = (val >> 16) & 0xFF;
+        buf[6] = (val >> 8) & 0xFF;
+        buf[7] = val & 0xFF;
+    }
+
+    inline void Ctx::writeScnLittle(uint8_t* buf, typeScn val) {
+        if (val < 0x800000000000) {
+            buf[0] = val & 0xFF;
+            buf[1] = (val >> 8) & 0xFF;
+            buf[2] = (val >> 16) & 0xFF;
+            buf[3] = (val >> 24) & 0xFF;
+            buf[4] = (val >> 32) & 0xFF;
+            buf[5] = (val >> 40) & 0xFF;
+        } else {
+            buf[0] = val & 0xFF;
+            buf[1] = (val >> 8) & 0xFF;
+            buf[2] = (val >> 16) & 0xFF;
+            buf[3] = (val >> 24) & 0xFF;
+            buf[4] = (val >> 48) & 0xFF;
+            buf[5] = ((val >> 56) & 0x7F) | 0x80;
+            buf[6] = (val >> 32) & 0xFF;
+            buf[7] = (val >> 40) & 0xFF;
+        }
+    }
+
+    inline void Ctx::writeScnBig(uint8_t* buf, typeScn val) {
+        if (val < 0x800000000000) {
+            buf[0] = (val >> 24) & 0xFF;
+            buf[1] = (val >> 16) & 0xFF;
+            buf[2] = (val >> 8) & 0xFF;
+            buf[3] = val & 0xFF;
+            buf[4] = (val >> 40) & 0xFF;
+            buf[5] = (val >> 32) & 0xFF;
+        } else {
+            buf[0] = (val >> 24) & 0xFF;
+            buf[1] = (val >> 16) & 0xFF;
+            buf[2] = (val >> 8) & 0xFF;
+            buf[3] = val & 0xFF;
+            buf[4] = ((val >> 56) & 0x7F) | 0x80;
+            buf[5] = (val >> 48) & 0xFF;
+            buf[6] = (val >> 40) & 0xFF;
+            buf[7] = (val >> 32) & 0xFF;
+        }
+    }
 }
 
 #endif
@@ -0,0 +1,250 @@
+/* Definition of open addressing hash map and set
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+#include "typeXid.h"
+
+#ifndef FLAT_MAP_H_
+#define FLAT_MAP_H_
+
+#define FLAT_MAP_MIN_CAPACITY                   16
+
+namespace OpenLogReplicator {
+    // Finalizer of MurmurHash3, sequential object ids and transaction slots are spread over the whole table
+    inline uint64_t flatHash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDULL;
+        key ^= key >> 33;
+        key *= 0xC4CEB9FE1A85EC53ULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+    inline uint64_t flatHash(typeXid xid) {
+        return flatHash(xid.getData());
+    }
+
+    // Hash table with linear probing and backward shift deletion, elements are stored in one array without tombstones.
+    // Used for lookups done for every redo record. Iterators are invalidated by insert and erase.
+    template <typename Key, typename Value, bool IsMap>
+    class FlatTable {
+    public:
+        typedef typename std::conditional<IsMap, std::pair<Key, Value>, Key>::type Element;
+
+    protected:
+        struct Slot {
+            Element element;
+            bool used = false;
+        };
+
+        std::vector<Slot> slots;
+        uint64_t elements;
+        uint64_t mask;
+
+        static const Key& slotKey(const Slot& slot) {
+            if constexpr (IsMap)
+                return slot.element.first;
+            else
+                return slot.element;
+        }
+
+        [[nodiscard]] uint64_t findPos(const Key& key) const {
+            if (elements == 0)
+                return slots.size();
+
+            for (uint64_t pos = flatHash(key) & mask; slots[pos].used; pos = (pos + 1) & mask) {
+                if (slotKey(slots[pos]) == key)
+                    return pos;
+            }
+            return slots.size();
+        }
+
+        uint64_t insertPos(const Key& key, bool& inserted) {
+            // Load factor is kept at most 1/2, lookups of missing keys stay short
+            if ((elements + 1) * 2 > slots.size())
+                rehash(slots.size() * 2);
+
+            uint64_t pos = flatHash(key) & mask;
+            for (; slots[pos].used; pos = (pos + 1) & mask) {
+                if (slotKey(slots[pos]) == key) {
+                    inserted = false;
+                    return pos;
+                }
+            }
+
+            slots[pos].used = true;
+            if constexpr (IsMap)
+                slots[pos].element = Element(key, Value());
+            else
+                slots[pos].element = key;
+            ++elements;
+            inserted = true;
+            return pos;
+        }
+
+        void rehash(uint64_t capacity) {
+            if (capacity < FLAT_MAP_MIN_CAPACITY)
+                capacity = FLAT_MAP_MIN_CAPACITY;
+
+            std::vector<Slot> oldSlots(capacity);
+            oldSlots.swap(slots);
+            mask = capacity - 1;
+
+            for (Slot& slot : oldSlots) {
+                if (!slot.used)
+                    continue;
+
+                uint64_t pos = flatHash(slotKey(slot)) & mask;
+                while (slots[pos].used)
+                    pos = (pos + 1) & mask;
+                slots[pos] = std::move(slot);
+            }
+        }
+
+        void erasePos(uint64_t pos) {
+            // Following elements of the cluster are moved back, so that no lookup chain is broken
+            uint64_t next = (pos + 1) & mask;
+            while (slots[next].used) {
+                uint64_t home = flatHash(slotKey(slots[next])) & mask;
+                if (((next - home) & mask) >= ((next - pos) & mask)) {
+                    slots[pos] = std::move(slots[next]);
+                    pos = next;
+                }
+                next = (next + 1) & mask;
+            }
+            slots[pos].used = false;
+            --elements;
+        }
+
+    public:
+        class iterator {
+            FlatTable* table;
+            uint64_t pos;
+
+            void skip() {
+                while (pos < table->slots.size() && !table->slots[pos].used)
+                    ++pos;
+            }
+
+        public:
+            iterator(FlatTable* newTable, uint64_t newPos) :
+                    table(newTable),
+                    pos(newPos) {
+                skip();
+            }
+
+            Element& operator*() const {
+                return table->slots[pos].element;
+            }
+
+            Element* operator->() const {
+                return &table->slots[pos].element;
+            }
+
+            iterator& operator++() {
+                ++pos;
+                skip();
+                return *this;
+            }
+
+            bool operator==(const iterator& other) const {
+                return pos == other.pos;
+            }
+
+            bool operator!=(const iterator& other) const {
+                return pos != other.pos;
+            }
+
+            friend class FlatTable;
+        };
+
+        FlatTable() :
+                slots(FLAT_MAP_MIN_CAPACITY),
+                elements(0),
+                mask(FLAT_MAP_MIN_CAPACITY - 1) {
+        }
+
+        iterator begin() {
+            return iterator(this, 0);
+        }
+
+        iterator end() {
+            return iterator(this, slots.size());
+        }
+
+        iterator find(const Key& key) {
+            return iterator(this, findPos(key));
+        }
+
+        [[nodiscard]] uint64_t count(const Key& key) const {
+            return findPos(key) != slots.size() ? 1 : 0;
+        }
+
+        [[nodiscard]] uint64_t size() const {
+            return elements;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return elements == 0;
+        }
+
+        void erase(iterator it) {
+            erasePos(it.pos);
+        }
+
+        uint64_t erase(const Key& key) {
+            uint64_t pos = findPos(key);
+            if (pos == slots.size())
+                return 0;
+            erasePos(pos);
+            return 1;
+        }
+
+        void clear() {
+            for (Slot& slot : slots)
+                slot.used = false;
+            elements = 0;
+        }
+    };
+
+    template <typename Key, typename Value>
+    class FlatMap : public FlatTable<Key, Value, true> {
+    public:
+        Value& operator[](const Key& key) {
+            bool inserted;
+            return this->slots[this->insertPos(key, inserted)].element.second;
+        }
+    };
+
+    template <typename Key>
+    class FlatSet : public FlatTable<Key, bool, false> {
+    public:
+        bool insert(const Key& key) {
+            bool inserted;
+            this->insertPos(key, inserted);
+            return inserted;
+        }
+    };
+}
+
+#endif
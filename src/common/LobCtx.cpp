@@ -29,6 +29,7 @@ namespace OpenLogReplicator {
 
     void LobCtx::checkOrphanedLobs(Ctx* ctx, const typeLobId& lobId, typeXid xid, uint64_t offset) {
         LobKey lobKey(lobId, 0);
+        std::unique_lock<std::mutex> lck(*orphanedLobsMtx);
         for (auto orphanedLobsIt = orphanedLobs->upper_bound(lobKey);
              orphanedLobsIt != orphanedLobs->end() && orphanedLobsIt->first.lobId == lobId; ) {
 
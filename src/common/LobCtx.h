@@ -18,6 +18,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 <http://www.gnu.org/licenses/>.  */
 
 #include <map>
+#include <mutex>
 #include <unordered_map>
 
 #include "LobData.h"
@@ -37,7 +38,9 @@ namespace OpenLogReplicator {
         virtual ~LobCtx();
 
         std::unordered_map<typeLobId, LobData*> lobs;
+        // Shared by all transactions, the parser adds orphaned pages while the commit worker matches them
         std::map<LobKey, uint8_t*>* orphanedLobs;
+        std::mutex* orphanedLobsMtx;
         std::map<typeDba, uint8_t*> listMap;
 
         void checkOrphanedLobs(Ctx* ctx, const typeLobId& lobId, typeXid xid, uint64_t offset);
@@ -0,0 +1,87 @@
+/* Counters of the replication stages for the performance report
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "Ctx.h"
+#include "PerfStats.h"
+
+namespace OpenLogReplicator {
+    thread_local PerfScope* PerfScope::current = nullptr;
+
+    const char* PerfStats::stageNames[PERF_STAGES] = {"read", "lwn", "decode", "transaction", "builder", "writer"};
+
+    PerfStats::PerfStats(const std::string& newFileName) :
+            startTime(std::chrono::steady_clock::now()),
+            outputHash(0),
+            outputMessages(0),
+            fileName(newFileName) {
+    }
+
+    void PerfStats::writeReport(Ctx* ctx) const {
+        uint64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(2);
+        ss << R"({"version":")" << CONFIG_SCHEMA_VERSION << R"(","elapsed-us":)" << elapsedUs <<
+                R"(,"memory-chunk-mb":)" << ctx->memoryChunkSizeMb <<
+                R"(,"memory-chunks-hwm":)" << ctx->getMaxUsedMemory() / ctx->memoryChunkSizeMb <<
+                R"(,"output-messages":)" << outputMessages <<
+                R"(,"output-hash":")" << std::hex << std::setw(16) << std::setfill('0') << outputHash << std::dec << R"(","stages":[)";
+
+        for (uint64_t stage = 0; stage < PERF_STAGES; ++stage) {
+            uint64_t bytes = stages[stage].bytes;
+            uint64_t records = stages[stage].records;
+            uint64_t timeNs = stages[stage].timeNs;
+            double mbPerSec = 0;
+            double recordsPerSec = 0;
+            if (timeNs > 0) {
+                mbPerSec = static_cast<double>(bytes) * 1000000000.0 / 1024 / 1024 / static_cast<double>(timeNs);
+                recordsPerSec = static_cast<double>(records) * 1000000000.0 / static_cast<double>(timeNs);
+            }
+
+            if (stage > 0)
+                ss << ",";
+            ss << R"({"stage":")" << stageNames[stage] << R"(","bytes":)" << bytes << R"(,"records":)" << records <<
+                    R"(,"time-us":)" << timeNs / 1000 << R"(,"mb-per-s":)" << mbPerSec << R"(,"records-per-s":)" << recordsPerSec << "}";
+
+            ctx->info(0, "performance " + std::string(stageNames[stage]) + ": " + std::to_string(bytes) + " bytes, " +
+                      std::to_string(records) + " records, " + std::to_string(timeNs / 1000) + " us, " + std::to_string(mbPerSec) +
+                      " MB/s, " + std::to_string(recordsPerSec) + " records/s");
+        }
+        ss << "]}" << std::endl;
+
+        std::ofstream outputStream;
+        outputStream.open(fileName.c_str(), std::ios::out | std::ios::trunc);
+        if (!outputStream.is_open()) {
+            ctx->error(10006, "file: " + fileName + " - open for write returned: " + strerror(errno));
+            return;
+        }
+
+        outputStream << ss.str();
+        if (outputStream.bad() || outputStream.fail())
+            ctx->error(10007, "file: " + fileName + " - 0 bytes written instead of " +
+                       std::to_string(ss.str().length()) + ", code returned: " + strerror(errno));
+        outputStream.close();
+    }
+}
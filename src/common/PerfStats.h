@@ -0,0 +1,134 @@
+/* Header for PerfStats class
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "types.h"
+
+#ifndef PERF_STATS_H_
+#define PERF_STATS_H_
+
+#define PERF_STAGE_READ                         0
+#define PERF_STAGE_LWN                          1
+#define PERF_STAGE_DECODE                       2
+#define PERF_STAGE_TRANSACTION                  3
+#define PERF_STAGE_BUILDER                      4
+#define PERF_STAGE_WRITER                       5
+#define PERF_STAGES                             6
+
+#define PERF_HASH_INIT                          0xCBF29CE484222325ULL
+
+namespace OpenLogReplicator {
+    class Ctx;
+
+    struct PerfStage {
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> records{0};
+        std::atomic<uint64_t> timeNs{0};
+    };
+
+    // Counters of the replication stages, allocated only when the performance report is requested
+    class PerfStats final {
+    protected:
+        std::chrono::steady_clock::time_point startTime;
+        PerfStage stages[PERF_STAGES];
+        std::atomic<uint64_t> outputHash;
+        std::atomic<uint64_t> outputMessages;
+
+    public:
+        static const char* stageNames[PERF_STAGES];
+        const std::string fileName;
+
+        explicit PerfStats(const std::string& newFileName);
+
+        void add(uint64_t stage, uint64_t bytes, uint64_t records) {
+            stages[stage].bytes.fetch_add(bytes, std::memory_order_relaxed);
+            stages[stage].records.fetch_add(records, std::memory_order_relaxed);
+        }
+
+        void addTime(uint64_t stage, uint64_t timeNs) {
+            stages[stage].timeNs.fetch_add(timeNs, std::memory_order_relaxed);
+        }
+
+        // Hashes of all writers are summed, the result does not depend on the order of the targets and writers with identical
+        // output don't cancel each other like with xor
+        void addOutput(uint64_t hash, uint64_t messages) {
+            outputHash.fetch_add(hash, std::memory_order_relaxed);
+            outputMessages.fetch_add(messages, std::memory_order_relaxed);
+        }
+
+        // FNV-1a, the hash of the output is compared between runs to verify that the optimized code produces the same messages
+        [[nodiscard]] static uint64_t hash(uint64_t value, const uint8_t* data, uint64_t length) {
+            for (uint64_t i = 0; i < length; ++i) {
+                value ^= data[i];
+                value *= 0x100000001B3ULL;
+            }
+            return value;
+        }
+
+        void writeReport(Ctx* ctx) const;
+    };
+
+    // Time of the scope is charged to the stage, time of nested scopes of the same thread is subtracted, so that every stage
+    // reports only its own work
+    class PerfScope final {
+    protected:
+        static thread_local PerfScope* current;
+        PerfStats* perfStats;
+        uint64_t stage;
+        PerfScope* parent;
+        uint64_t childNs;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        PerfScope(PerfStats* newPerfStats, uint64_t newStage) :
+                perfStats(newPerfStats),
+                stage(newStage),
+                parent(nullptr),
+                childNs(0) {
+            if (perfStats == nullptr)
+                return;
+
+            parent = current;
+            current = this;
+            start = std::chrono::steady_clock::now();
+        }
+
+        ~PerfScope() {
+            stop();
+        }
+
+        // Ends the scope before the end of the block, for example before waiting for more work
+        void stop() {
+            if (perfStats == nullptr)
+                return;
+
+            uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            perfStats->addTime(stage, elapsed > childNs ? elapsed - childNs : 0);
+            if (parent != nullptr)
+                parent->childNs += elapsed;
+            current = parent;
+            perfStats = nullptr;
+        }
+    };
+}
+
+#endif
@@ -115,6 +115,8 @@ namespace OpenLogReplicator {
         uint64_t suppLogRowData;
         uint64_t suppLogNumsDelta;
         uint64_t suppLogLenDelta;
+        // Size of the supplemental log fields, summed by the parser which decoded the record
+        uint64_t suppLogSize;
         bool compressed;
 
         static bool nextFieldOpt(Ctx* ctx, RedoLogRecord* redoLogRecord, typeField& fieldNum, uint64_t& fieldPos, uint16_t& fieldLength, uint32_t code) {
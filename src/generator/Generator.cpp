@@ -0,0 +1,810 @@
+/* Writes archived redo log files with synthetic DML
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/ConfigurationException.h"
+#include "../common/Ctx.h"
+#include "../common/DataException.h"
+#include "../common/RuntimeException.h"
+#include "../common/types.h"
+#include "../parser/OpCode.h"
+#include "Generator.h"
+
+// 2023-01-01 00:00:00 UTC, timestamps of generated LWNs are fixed, so that the output is reproducible
+#define GENERATOR_BASE_TIME                     1672531200
+
+namespace OpenLogReplicator {
+    Generator::Generator(Ctx* newCtx, const std::string& newFileName) :
+            ctx(newCtx),
+            fileName(newFileName),
+            compatVsn(REDO_VERSION_19_0),
+            blockSize(512),
+            logBlocks(0),
+            lwnRecords(64),
+            lwnRuns(1),
+            transactions(1000),
+            transactionSize(10),
+            interleave(1),
+            weights{100, 0, 0},
+            updateColumns(0),
+            random(1),
+            fileDes(-1),
+            sequence(1),
+            block(0),
+            scn(1000000),
+            firstScn(0),
+            startScn(0),
+            timestamp(0),
+            sqn(0),
+            vectorHeaderSize(32),
+            statRecords(0),
+            statBytes(0),
+            statOps{0, 0, 0} {
+    }
+
+    Generator::~Generator() {
+        if (fileDes != -1) {
+            close(fileDes);
+            fileDes = -1;
+        }
+
+        for (GeneratorTable* table : tables)
+            delete table;
+        tables.clear();
+    }
+
+    void Generator::loadConfig() {
+        struct stat fileStat;
+        int fid = open(fileName.c_str(), O_RDONLY);
+        if (fid == -1)
+            throw RuntimeException(10001, "file: " + fileName + " - open returned: " + strerror(errno));
+
+        if (stat(fileName.c_str(), &fileStat) != 0) {
+            close(fid);
+            throw RuntimeException(10003, "file: " + fileName + " - stat returned: " + strerror(errno));
+        }
+
+        if (fileStat.st_size > CONFIG_FILE_MAX_SIZE || fileStat.st_size <= 0) {
+            close(fid);
+            throw ConfigurationException(10004, "file: " + fileName + " - wrong size: " + std::to_string(fileStat.st_size));
+        }
+
+        auto fileSize = static_cast<size_t>(fileStat.st_size);
+        std::vector<char> configFileBuffer(fileSize + 1);
+        ssize_t bytesRead = read(fid, configFileBuffer.data(), fileSize);
+        close(fid);
+        if (bytesRead == -1)
+            throw RuntimeException(10005, "file: " + fileName + " - read returned: " + strerror(errno));
+        if (bytesRead != static_cast<ssize_t>(fileSize))
+            throw RuntimeException(10005, "file: " + fileName + " - " + std::to_string(bytesRead) + " bytes read instead of " +
+                                   std::to_string(fileSize));
+        configFileBuffer[fileSize] = 0;
+
+        rapidjson::Document document;
+        if (document.Parse(configFileBuffer.data()).HasParseError())
+            throw DataException(20001, "file: " + fileName + " offset: " +
+                                std::to_string(document.GetErrorOffset()) + " - parse error: " + GetParseError_En(document.GetParseError()));
+
+        const char* version = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, document, "version");
+        if (strcmp(version, CONFIG_SCHEMA_VERSION) != 0)
+            throw ConfigurationException(30001, "bad JSON, invalid 'version' value: " + std::string(version) + ", expected: " +
+                                         CONFIG_SCHEMA_VERSION);
+
+        outputPath = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, document, "output-path");
+
+        if (document.HasMember("db-version")) {
+            std::string dbVersion = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, document, "db-version");
+            if (dbVersion == "11.2")
+                compatVsn = 0x0B200400;
+            else if (dbVersion == "12.1")
+                compatVsn = 0x0C100200;
+            else if (dbVersion == "12.2")
+                compatVsn = 0x0C200100;
+            else if (dbVersion == "18")
+                compatVsn = REDO_VERSION_18_0;
+            else if (dbVersion == "19")
+                compatVsn = REDO_VERSION_19_0;
+            else if (dbVersion == "21")
+                compatVsn = 0x15000000;
+            else
+                throw ConfigurationException(30001, "bad JSON, invalid 'db-version' value: " + dbVersion +
+                                             ", expected: one of {11.2, 12.1, 12.2, 18, 19, 21}");
+        }
+        if (compatVsn < REDO_VERSION_12_1)
+            vectorHeaderSize = 24;
+
+        if (document.HasMember("block-size")) {
+            blockSize = Ctx::getJsonFieldU64(fileName, document, "block-size");
+            if (blockSize != 512 && blockSize != 1024 && blockSize != 4096)
+                throw ConfigurationException(30001, "bad JSON, invalid 'block-size' value: " + std::to_string(blockSize) +
+                                             ", expected: one of {512, 1024, 4096}");
+        }
+
+        uint64_t logSizeMb = 64;
+        if (document.HasMember("log-size-mb")) {
+            logSizeMb = Ctx::getJsonFieldU64(fileName, document, "log-size-mb");
+            if (logSizeMb < 1 || logSizeMb > 4096)
+                throw ConfigurationException(30001, "bad JSON, invalid 'log-size-mb' value: " + std::to_string(logSizeMb) +
+                                             ", expected: one of {1 .. 4096}");
+        }
+        logBlocks = logSizeMb * 1024 * 1024 / blockSize;
+
+        if (document.HasMember("sequence")) {
+            sequence = Ctx::getJsonFieldU32(fileName, document, "sequence");
+            if (sequence == 0)
+                throw ConfigurationException(30001, "bad JSON, invalid 'sequence' value: " + std::to_string(sequence) +
+                                             ", expected: value > 0");
+        }
+
+        if (document.HasMember("scn")) {
+            scn = Ctx::getJsonFieldU64(fileName, document, "scn");
+            if (scn == 0 || scn >= 0x800000000000)
+                throw ConfigurationException(30001, "bad JSON, invalid 'scn' value: " + std::to_string(scn) +
+                                             ", expected: one of {1 .. 140737488355327}");
+        }
+
+        if (document.HasMember("seed"))
+            random.seed(Ctx::getJsonFieldU64(fileName, document, "seed"));
+
+        if (document.HasMember("lwn-records")) {
+            lwnRecords = Ctx::getJsonFieldU64(fileName, document, "lwn-records");
+            if (lwnRecords < 1 || lwnRecords > 65535)
+                throw ConfigurationException(30001, "bad JSON, invalid 'lwn-records' value: " + std::to_string(lwnRecords) +
+                                             ", expected: one of {1 .. 65535}");
+        }
+
+        if (document.HasMember("lwn-runs")) {
+            lwnRuns = Ctx::getJsonFieldU64(fileName, document, "lwn-runs");
+            if (lwnRuns < 1 || lwnRuns > lwnRecords)
+                throw ConfigurationException(30001, "bad JSON, invalid 'lwn-runs' value: " + std::to_string(lwnRuns) +
+                                             ", expected: one of {1 .. " + std::to_string(lwnRecords) + "}");
+        }
+
+        const rapidjson::Value& tablesJson = Ctx::getJsonFieldA(fileName, document, "tables");
+        if (tablesJson.Size() == 0)
+            throw ConfigurationException(30001, "bad JSON, invalid 'tables' value: empty list, expected: at least one table");
+
+        uint64_t minColumns = 255;
+        for (rapidjson::SizeType i = 0; i < tablesJson.Size(); ++i) {
+            const rapidjson::Value& tableJson = Ctx::getJsonFieldO(fileName, tablesJson, "tables", i);
+
+            auto table = new GeneratorTable;
+            tables.push_back(table);
+            table->owner = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, tableJson, "owner");
+            table->name = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, tableJson, "table");
+            table->obj = Ctx::getJsonFieldU32(fileName, tableJson, "obj");
+            if (tableJson.HasMember("data-obj"))
+                table->dataObj = Ctx::getJsonFieldU32(fileName, tableJson, "data-obj");
+            else
+                table->dataObj = table->obj;
+            if (table->dataObj == 0)
+                throw ConfigurationException(30001, "bad JSON, invalid 'data-obj' value: 0, expected: value > 0");
+            table->nextId = 1;
+            // Every table is placed in a separate region of the data file
+            table->nextBdba = (GENERATOR_AFN_DATA << 22) | ((i + 1) << 16);
+            table->nextSlot = 0;
+
+            const rapidjson::Value& columnsJson = Ctx::getJsonFieldA(fileName, tableJson, "columns");
+            if (columnsJson.Size() < 1 || columnsJson.Size() > 255)
+                throw ConfigurationException(30001, "bad JSON, invalid 'columns' value: " + std::to_string(columnsJson.Size()) +
+                                             " columns, expected: one of {1 .. 255}");
+
+            for (rapidjson::SizeType j = 0; j < columnsJson.Size(); ++j) {
+                const rapidjson::Value& columnJson = Ctx::getJsonFieldO(fileName, columnsJson, "columns", j);
+                GeneratorColumn column{0, 0};
+
+                std::string type = Ctx::getJsonFieldS(fileName, JSON_PARAMETER_LENGTH, columnJson, "type");
+                if (type == "number")
+                    column.type = GENERATOR_COLUMN_NUMBER;
+                else if (type == "varchar2")
+                    column.type = GENERATOR_COLUMN_VARCHAR2;
+                else if (type == "raw")
+                    column.type = GENERATOR_COLUMN_RAW;
+                else
+                    throw ConfigurationException(30001, "bad JSON, invalid 'type' value: " + type +
+                                                 ", expected: one of {number, varchar2, raw}");
+
+                if (column.type != GENERATOR_COLUMN_NUMBER) {
+                    column.length = 20;
+                    if (columnJson.HasMember("length")) {
+                        column.length = Ctx::getJsonFieldU64(fileName, columnJson, "length");
+                        if (column.length < 1 || column.length > 2000)
+                            throw ConfigurationException(30001, "bad JSON, invalid 'length' value: " + std::to_string(column.length) +
+                                                         ", expected: one of {1 .. 2000}");
+                    }
+                }
+                table->columns.push_back(column);
+            }
+
+            if (table->columns.size() < minColumns)
+                minColumns = table->columns.size();
+        }
+
+        updateColumns = minColumns;
+        if (document.HasMember("workload")) {
+            const rapidjson::Value& workloadJson = Ctx::getJsonFieldO(fileName, document, "workload");
+
+            if (workloadJson.HasMember("transactions"))
+                transactions = Ctx::getJsonFieldU64(fileName, workloadJson, "transactions");
+
+            if (workloadJson.HasMember("transaction-size")) {
+                transactionSize = Ctx::getJsonFieldU64(fileName, workloadJson, "transaction-size");
+                if (transactionSize < 1)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'transaction-size' value: " + std::to_string(transactionSize) +
+                                                 ", expected: value > 0");
+            }
+
+            if (workloadJson.HasMember("interleave")) {
+                interleave = Ctx::getJsonFieldU64(fileName, workloadJson, "interleave");
+                if (interleave < 1 || interleave > GENERATOR_USN_MAX * GENERATOR_SLT_MAX)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'interleave' value: " + std::to_string(interleave) +
+                                                 ", expected: one of {1 .. " + std::to_string(GENERATOR_USN_MAX * GENERATOR_SLT_MAX) + "}");
+            }
+
+            if (workloadJson.HasMember("insert"))
+                weights[GENERATOR_OP_INSERT] = Ctx::getJsonFieldU64(fileName, workloadJson, "insert");
+            if (workloadJson.HasMember("update"))
+                weights[GENERATOR_OP_UPDATE] = Ctx::getJsonFieldU64(fileName, workloadJson, "update");
+            if (workloadJson.HasMember("delete"))
+                weights[GENERATOR_OP_DELETE] = Ctx::getJsonFieldU64(fileName, workloadJson, "delete");
+            if (weights[GENERATOR_OP_INSERT] + weights[GENERATOR_OP_UPDATE] + weights[GENERATOR_OP_DELETE] == 0)
+                throw ConfigurationException(30001, "bad JSON, invalid 'insert', 'update' and 'delete' values: all are 0, "
+                                             "expected: at least one value > 0");
+
+            if (workloadJson.HasMember("update-columns")) {
+                updateColumns = Ctx::getJsonFieldU64(fileName, workloadJson, "update-columns");
+                if (updateColumns < 1 || updateColumns > minColumns)
+                    throw ConfigurationException(30001, "bad JSON, invalid 'update-columns' value: " + std::to_string(updateColumns) +
+                                                 ", expected: one of {1 .. " + std::to_string(minColumns) + "}");
+            }
+        }
+    }
+
+    uint64_t Generator::nextRandom(uint64_t range) {
+        // Raw engine output is used instead of distributions, their results are implementation specific
+        return random() % range;
+    }
+
+    uint64_t Generator::mix(uint64_t value) {
+        value += 0x9E3779B97F4A7C15ULL;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    }
+
+    uint32_t Generator::encodeTime(time_t time) {
+        struct tm epochTime = {};
+        gmtime_r(&time, &epochTime);
+
+        return ((((((static_cast<uint32_t>(epochTime.tm_year) + 1900 - 1988) * 12 + epochTime.tm_mon) * 31 + epochTime.tm_mday - 1) * 24 +
+                epochTime.tm_hour) * 60 + epochTime.tm_min) * 60 + epochTime.tm_sec);
+    }
+
+    void Generator::encodeNumber(std::vector<uint8_t>& value, uint64_t number) {
+        if (number == 0) {
+            value.push_back(0x80);
+            return;
+        }
+
+        // Base 100 digits, the least significant first
+        uint8_t digits[10];
+        uint64_t length = 0;
+        while (number > 0) {
+            digits[length++] = number % 100;
+            number /= 100;
+        }
+
+        value.push_back(0xC0 + length);
+        uint64_t last = 0;
+        while (digits[last] == 0)
+            ++last;
+        for (uint64_t i = length; i > last; --i)
+            value.push_back(digits[i - 1] + 1);
+    }
+
+    void Generator::columnValue(std::vector<uint8_t>& value, const GeneratorTable* table, const GeneratorRow& row, uint64_t col) const {
+        value.clear();
+        const GeneratorColumn& column = table->columns[col];
+        uint64_t seed = mix(row.id * 0x100000 + row.version * 0x100 + col);
+
+        switch (column.type) {
+            case GENERATOR_COLUMN_NUMBER:
+                // First column keeps the row id, all other values change with every update
+                if (col == 0)
+                    encodeNumber(value, row.id);
+                else
+                    encodeNumber(value, seed % 1000000000);
+                break;
+
+            case GENERATOR_COLUMN_VARCHAR2:
+                for (uint64_t i = 0; i < column.length; ++i) {
+                    if ((i % 8) == 0 && i > 0)
+                        seed = mix(seed);
+                    value.push_back('a' + ((seed >> ((i % 8) * 8)) & 0xFF) % 26);
+                }
+                break;
+
+            case GENERATOR_COLUMN_RAW:
+                for (uint64_t i = 0; i < column.length; ++i) {
+                    if ((i % 8) == 0 && i > 0)
+                        seed = mix(seed);
+                    value.push_back((seed >> ((i % 8) * 8)) & 0xFF);
+                }
+                break;
+        }
+    }
+
+    uint64_t Generator::rowSize(const GeneratorTable* table, const GeneratorRow& row) const {
+        std::vector<uint8_t> value;
+        uint64_t size = 3;
+        for (uint64_t col = 0; col < table->columns.size(); ++col) {
+            columnValue(value, table, row, col);
+            size += value.size() + (value.size() <= 250 ? 1 : 3);
+        }
+        return size;
+    }
+
+    void Generator::appendVector(std::vector<uint8_t>& record, typeOp1 opCode, uint16_t cls, typeAfn afn, typeDba dba,
+                                 const std::vector<std::vector<uint8_t>>& fields) const {
+        uint64_t fieldListLength = 2 + fields.size() * 2;
+        uint64_t length = vectorHeaderSize + ((fieldListLength + 2) & 0xFFFC);
+        for (const std::vector<uint8_t>& field : fields)
+            length += (field.size() + 3) & 0xFFFC;
+
+        uint64_t pos = record.size();
+        record.resize(pos + length, 0);
+        uint8_t* data = record.data() + pos;
+
+        data[0] = opCode >> 8;
+        data[1] = opCode & 0xFF;
+        ctx->write16(data + 2, cls);
+        ctx->write32(data + 4, afn);
+        ctx->write32(data + 8, dba);
+        ctx->writeScn(data + 12, scn);
+        data[20] = 1;
+
+        uint8_t* fieldList = data + vectorHeaderSize;
+        ctx->write16(fieldList, fieldListLength);
+        uint64_t fieldPos = vectorHeaderSize + ((fieldListLength + 2) & 0xFFFC);
+        for (uint64_t i = 0; i < fields.size(); ++i) {
+            ctx->write16(fieldList + 2 + i * 2, fields[i].size());
+            if (!fields[i].empty())
+                memcpy(data + fieldPos, fields[i].data(), fields[i].size());
+            fieldPos += (fields[i].size() + 3) & 0xFFFC;
+        }
+    }
+
+    std::vector<uint8_t> Generator::fieldKtudb(const GeneratorTransaction& transaction) const {
+        std::vector<uint8_t> field(20, 0);
+        ctx->write16(field.data() + 8, transaction.xid.usn());
+        ctx->write16(field.data() + 10, transaction.xid.slt());
+        ctx->write32(field.data() + 12, transaction.xid.sqn());
+        return field;
+    }
+
+    std::vector<uint8_t> Generator::fieldKtub(const GeneratorTransaction& transaction, const GeneratorTable* table) const {
+        // First change of the transaction uses the longer ktubl format
+        std::vector<uint8_t> field(transaction.begin ? 28 : 24, 0);
+        ctx->write32(field.data() + 0, table->obj);
+        ctx->write32(field.data() + 4, table->dataObj);
+        field[16] = 0x0B;
+        field[17] = 0x01;
+        field[18] = transaction.xid.slt() & 0xFF;
+        field[19] = transaction.rci;
+        if (transaction.begin)
+            ctx->write16(field.data() + 20, FLG_BEGIN_TRANS);
+        return field;
+    }
+
+    std::vector<uint8_t> Generator::fieldKtbRedo() const {
+        std::vector<uint8_t> field(8, 0);
+        field[0] = KTBOP_Z;
+        return field;
+    }
+
+    std::vector<uint8_t> Generator::fieldKdo(typeDba bdba, uint8_t op, uint64_t length) const {
+        std::vector<uint8_t> field(length, 0);
+        ctx->write32(field.data() + 0, bdba);
+        field[10] = op;
+        field[12] = 1;
+        return field;
+    }
+
+    std::vector<uint8_t> Generator::fieldKdoIrp(const GeneratorTable* table, const GeneratorRow& row) const {
+        uint64_t cc = table->columns.size();
+        std::vector<uint8_t> field = fieldKdo(row.bdba, OP_IRP, std::max<uint64_t>(48, 45 + (cc + 7) / 8));
+        field[16] = FB_F | FB_L | FB_H;
+        field[18] = cc;
+        ctx->write16(field.data() + 40, rowSize(table, row));
+        ctx->write16(field.data() + 42, row.slot);
+        return field;
+    }
+
+    std::vector<uint8_t> Generator::fieldKdoDrp(const GeneratorRow& row) const {
+        std::vector<uint8_t> field = fieldKdo(row.bdba, OP_DRP, 20);
+        ctx->write16(field.data() + 16, row.slot);
+        return field;
+    }
+
+    std::vector<uint8_t> Generator::fieldKdoUrp(const GeneratorRow& row, uint64_t cc) const {
+        std::vector<uint8_t> field = fieldKdo(row.bdba, OP_URP, std::max<uint64_t>(28, 26 + (cc + 7) / 8));
+        field[16] = FB_F | FB_L | FB_H;
+        field[17] = 1;
+        ctx->write16(field.data() + 20, row.slot);
+        field[22] = cc;
+        field[23] = cc;
+        return field;
+    }
+
+    std::vector<uint8_t> Generator::fieldColNums(uint64_t cc) const {
+        std::vector<uint8_t> field(cc * 2, 0);
+        for (uint64_t i = 0; i < cc; ++i)
+            ctx->write16(field.data() + i * 2, i);
+        return field;
+    }
+
+    std::vector<uint8_t> Generator::fieldSuppLog(const GeneratorRow& row) const {
+        std::vector<uint8_t> field(28, 0);
+        field[0] = 1;
+        field[1] = FB_F | FB_L | FB_H;
+        ctx->write16(field.data() + 6, 1);
+        ctx->write16(field.data() + 8, 1);
+        ctx->write32(field.data() + 20, row.bdba);
+        ctx->write16(field.data() + 24, row.slot);
+        return field;
+    }
+
+    void Generator::generateBegin(std::vector<uint8_t>& record, const GeneratorTransaction& transaction) {
+        std::vector<uint8_t> ktudh(32, 0);
+        ctx->write16(ktudh.data() + 0, transaction.xid.slt());
+        ctx->write32(ktudh.data() + 4, transaction.xid.sqn());
+        ctx->write16(ktudh.data() + 16, 0x0012);
+
+        appendVector(record, 0x0502, 15 + 2 * transaction.xid.usn(), GENERATOR_AFN_UNDO,
+                     (GENERATOR_AFN_UNDO << 22) | transaction.xid.usn(), {ktudh});
+    }
+
+    void Generator::generateDml(std::vector<uint8_t>& record, GeneratorTransaction& transaction) {
+        GeneratorTable* table = tables[nextRandom(tables.size())];
+
+        uint64_t op = nextRandom(weights[GENERATOR_OP_INSERT] + weights[GENERATOR_OP_UPDATE] + weights[GENERATOR_OP_DELETE]);
+        if (op < weights[GENERATOR_OP_INSERT])
+            op = GENERATOR_OP_INSERT;
+        else if (op < weights[GENERATOR_OP_INSERT] + weights[GENERATOR_OP_UPDATE])
+            op = GENERATOR_OP_UPDATE;
+        else
+            op = GENERATOR_OP_DELETE;
+        // Rows must exist before they are updated or deleted
+        if (table->rows.empty())
+            op = GENERATOR_OP_INSERT;
+        ++statOps[op];
+
+        std::vector<std::vector<uint8_t>> undoFields{fieldKtudb(transaction), fieldKtub(transaction, table), fieldKtbRedo()};
+        std::vector<std::vector<uint8_t>> redoFields{fieldKtbRedo()};
+        std::vector<uint8_t> value;
+        typeOp1 redoOpCode;
+        typeDba bdba;
+
+        if (op == GENERATOR_OP_INSERT) {
+            GeneratorRow row{table->nextId++, 0, table->nextBdba, table->nextSlot++};
+            if (table->nextSlot == GENERATOR_SLOTS_IN_BLOCK) {
+                ++table->nextBdba;
+                table->nextSlot = 0;
+            }
+            table->rows.push_back(row);
+            bdba = row.bdba;
+
+            undoFields.push_back(fieldKdoDrp(row));
+            undoFields.push_back(fieldSuppLog(row));
+
+            redoOpCode = 0x0B02;
+            redoFields.push_back(fieldKdoIrp(table, row));
+            for (uint64_t col = 0; col < table->columns.size(); ++col) {
+                columnValue(value, table, row, col);
+                redoFields.push_back(value);
+            }
+        } else if (op == GENERATOR_OP_UPDATE) {
+            GeneratorRow& row = table->rows[nextRandom(table->rows.size())];
+            GeneratorRow oldRow = row;
+            ++row.version;
+            bdba = row.bdba;
+
+            undoFields.push_back(fieldKdoUrp(oldRow, updateColumns));
+            undoFields.push_back(fieldColNums(updateColumns));
+            for (uint64_t col = 0; col < updateColumns; ++col) {
+                columnValue(value, table, oldRow, col);
+                undoFields.push_back(value);
+            }
+            undoFields.push_back(fieldSuppLog(oldRow));
+
+            redoOpCode = 0x0B05;
+            redoFields.push_back(fieldKdoUrp(row, updateColumns));
+            redoFields.push_back(fieldColNums(updateColumns));
+            for (uint64_t col = 0; col < updateColumns; ++col) {
+                columnValue(value, table, row, col);
+                redoFields.push_back(value);
+            }
+        } else {
+            uint64_t pos = nextRandom(table->rows.size());
+            GeneratorRow row = table->rows[pos];
+            table->rows[pos] = table->rows.back();
+            table->rows.pop_back();
+            bdba = row.bdba;
+
+            undoFields.push_back(fieldKdoIrp(table, row));
+            for (uint64_t col = 0; col < table->columns.size(); ++col) {
+                columnValue(value, table, row, col);
+                undoFields.push_back(value);
+            }
+            undoFields.push_back(fieldSuppLog(row));
+
+            redoOpCode = 0x0B03;
+            redoFields.push_back(fieldKdoDrp(row));
+        }
+
+        appendVector(record, 0x0501, 16 + 2 * transaction.xid.usn(), GENERATOR_AFN_UNDO,
+                     (GENERATOR_AFN_UNDO << 22) | 0x400 | transaction.xid.usn(), undoFields);
+        appendVector(record, redoOpCode, 1, GENERATOR_AFN_DATA, bdba, redoFields);
+
+        transaction.begin = false;
+        ++transaction.rci;
+    }
+
+    void Generator::generateCommit(std::vector<uint8_t>& record, const GeneratorTransaction& transaction) {
+        std::vector<uint8_t> ktucm(20, 0);
+        ctx->write16(ktucm.data() + 0, transaction.xid.slt());
+        ctx->write32(ktucm.data() + 4, transaction.xid.sqn());
+
+        appendVector(record, 0x0504, 15 + 2 * transaction.xid.usn(), GENERATOR_AFN_UNDO,
+                     (GENERATOR_AFN_UNDO << 22) | transaction.xid.usn(), {ktucm});
+    }
+
+    void Generator::addRecord(std::vector<uint8_t>& record) {
+        records.push_back(std::move(record));
+        record.clear();
+        if (records.size() >= lwnRecords)
+            writeLwn();
+    }
+
+    void Generator::openLog() {
+        filePath = outputPath + "/o1_mf_1_" + std::to_string(sequence) + "_gen_.arc";
+        fileDes = open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fileDes == -1)
+            throw RuntimeException(10006, "file: " + filePath + " - open for write returned: " + strerror(errno));
+
+        // Blocks 0 and 1 are written when the file is closed
+        block = 2;
+        firstScn = scn;
+    }
+
+    void Generator::closeLog() {
+        std::vector<uint8_t> buffer(blockSize * 2, 0);
+        uint8_t* header = buffer.data();
+        header[1] = (blockSize == 4096 ? 0x82 : 0x22);
+        ctx->write32(header + 20, blockSize);
+        ctx->write32(header + 24, block);
+        header[28] = 0x7D;
+        header[29] = 0x7C;
+        header[30] = 0x7B;
+        header[31] = 0x7A;
+        writeBlock(header, 0);
+
+        header = buffer.data() + blockSize;
+        ctx->write32(header + 20, compatVsn);
+        memcpy(header + 28, "OLRGEN  ", 8);
+        ctx->write32(header + 52, 1);
+        ctx->write32(header + 156, block);
+        ctx->write32(header + 160, 1);
+        ctx->write16(header + 176, 1);
+        ctx->writeScn(header + 180, firstScn);
+        ctx->write32(header + 188, encodeTime(GENERATOR_BASE_TIME + (firstScn - startScn) / 100));
+        ctx->writeScn(header + 192, scn);
+        writeBlock(header, 1);
+
+        int64_t bytesWritten = pwrite(fileDes, buffer.data(), buffer.size(), 0);
+        if (bytesWritten != static_cast<int64_t>(buffer.size()))
+            throw RuntimeException(10007, "file: " + filePath + " - " + std::to_string(bytesWritten) + " bytes written instead of " +
+                                   std::to_string(buffer.size()) + ", code returned: " + strerror(errno));
+
+        close(fileDes);
+        fileDes = -1;
+        ctx->info(0, "written file: " + filePath + ", blocks: " + std::to_string(block) + ", scn range: " + std::to_string(firstScn) +
+                  " - " + std::to_string(scn));
+        ++sequence;
+    }
+
+    void Generator::writeLwn() {
+        if (records.empty())
+            return;
+
+        // Records are numbered by subscn in order of generation, but written in runs in reverse order: run j contains every
+        // lwnRuns-th record starting from j, so that the parser has to merge lwnRuns sorted runs
+        lwnOrder.clear();
+        for (uint64_t run = std::min(lwnRuns, records.size()); run > 0; --run) {
+            for (uint64_t i = run - 1; i < records.size(); i += lwnRuns)
+                lwnOrder.push_back(i);
+        }
+
+        // Layout of records in blocks: a record starts only if its header fits in the block, otherwise it continues after the
+        // header of the next block
+        uint64_t lwnBlocks = 1;
+        uint64_t blockOffset = 16;
+        for (uint64_t i = 0; i < records.size(); ++i) {
+            if (blockOffset + 20 >= blockSize) {
+                ++lwnBlocks;
+                blockOffset = 16;
+            }
+
+            uint64_t left = (i == 0 ? 68 : 24) + records[lwnOrder[i]].size();
+            while (left > 0) {
+                if (blockOffset == blockSize) {
+                    ++lwnBlocks;
+                    blockOffset = 16;
+                }
+                uint64_t toCopy = std::min(left, blockSize - blockOffset);
+                left -= toCopy;
+                blockOffset += toCopy;
+            }
+        }
+
+        if (lwnBlocks + 2 > logBlocks)
+            throw RuntimeException(10071, "lwn of " + std::to_string(lwnBlocks) + " blocks does not fit in redo log file of " +
+                                   std::to_string(logBlocks) + " blocks, decrease 'lwn-records' or increase 'log-size-mb'");
+
+        if (block + lwnBlocks > logBlocks) {
+            closeLog();
+            openLog();
+        }
+
+        timestamp = encodeTime(GENERATOR_BASE_TIME + (scn - startScn) / 100);
+        lwnBuffer.assign(lwnBlocks * blockSize, 0);
+        uint64_t lwnBlock = 0;
+        blockOffset = 16;
+        std::vector<uint8_t> header(68);
+
+        for (uint64_t i = 0; i < records.size(); ++i) {
+            if (blockOffset + 20 >= blockSize) {
+                ++lwnBlock;
+                blockOffset = 16;
+            }
+
+            const std::vector<uint8_t>& record = records[lwnOrder[i]];
+            uint64_t headerLength = (i == 0 ? 68 : 24);
+            uint64_t length = headerLength + record.size();
+            memset(header.data(), 0, headerLength);
+            ctx->write32(header.data() + 0, length);
+            header[4] = (i == 0 ? 0x05 : 0x01);
+            ctx->write16(header.data() + 6, scn >> 32);
+            ctx->write32(header.data() + 8, scn & 0xFFFFFFFF);
+            ctx->write16(header.data() + 12, lwnOrder[i] + 1);
+            if (i == 0) {
+                // Every LWN is a separate group of one LWN
+                ctx->write16(header.data() + 24, 1);
+                ctx->write16(header.data() + 26, 1);
+                ctx->write32(header.data() + 28, lwnBlocks);
+                ctx->write32(header.data() + 32, lwnBlocks);
+                ctx->writeScn(header.data() + 40, scn);
+                ctx->write32(header.data() + 64, timestamp);
+            }
+
+            uint64_t pos = 0;
+            while (pos < length) {
+                if (blockOffset == blockSize) {
+                    ++lwnBlock;
+                    blockOffset = 16;
+                }
+                uint64_t toCopy = std::min(length - pos, blockSize - blockOffset);
+                uint8_t* target = lwnBuffer.data() + lwnBlock * blockSize + blockOffset;
+                for (uint64_t j = 0; j < toCopy; ++j, ++pos)
+                    target[j] = (pos < headerLength ? header[pos] : record[pos - headerLength]);
+                blockOffset += toCopy;
+            }
+
+            ++statRecords;
+            statBytes += length;
+        }
+
+        for (uint64_t i = 0; i < lwnBlocks; ++i)
+            writeBlock(lwnBuffer.data() + i * blockSize, block + i);
+
+        int64_t bytesWritten = pwrite(fileDes, lwnBuffer.data(), lwnBuffer.size(), static_cast<int64_t>(block) * blockSize);
+        if (bytesWritten != static_cast<int64_t>(lwnBuffer.size()))
+            throw RuntimeException(10007, "file: " + filePath + " - " + std::to_string(bytesWritten) + " bytes written instead of " +
+                                   std::to_string(lwnBuffer.size()) + ", code returned: " + strerror(errno));
+
+        block += lwnBlocks;
+        records.clear();
+        ++scn;
+    }
+
+    void Generator::writeBlock(uint8_t* buffer, typeBlk blockNumber) const {
+        if (blockNumber > 0) {
+            buffer[0] = 0x01;
+            buffer[1] = (blockSize == 4096 ? 0x82 : 0x22);
+            ctx->write32(buffer + 4, blockNumber);
+            ctx->write32(buffer + 8, sequence);
+        }
+
+        // Same folding as in Reader::checkBlockHeader, computed with the checksum field cleared
+        buffer[14] = 0;
+        buffer[15] = 0;
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < blockSize; i += 8) {
+            uint64_t word;
+            memcpy(&word, buffer + i, sizeof(word));
+            sum ^= word;
+        }
+        sum ^= (sum >> 32);
+        sum ^= (sum >> 16);
+        ctx->write16(buffer + 14, sum & 0xFFFF);
+    }
+
+    void Generator::run() {
+        ctx->info(0, "generating " + std::to_string(transactions) + " transactions of " + std::to_string(transactionSize) +
+                  " rows to: " + outputPath);
+
+        startScn = scn;
+        openLog();
+        std::vector<uint8_t> record;
+        uint64_t started = 0;
+
+        while (started < transactions || !active.empty()) {
+            while (active.size() < interleave && started < transactions) {
+                // Slots of transactions which are still open are skipped, a slot is reused only after the commit
+                typeUsn usn;
+                typeSlt slt;
+                do {
+                    usn = 1 + (sqn % GENERATOR_USN_MAX);
+                    slt = (sqn / GENERATOR_USN_MAX) % GENERATOR_SLT_MAX;
+                    ++sqn;
+                } while (!activeSlots.insert((static_cast<uint64_t>(usn) << 16) | slt));
+                active.push_back(GeneratorTransaction{typeXid(usn, slt, sqn), transactionSize, 1, true});
+                ++started;
+            }
+
+            uint64_t pos = nextRandom(active.size());
+            GeneratorTransaction& transaction = active[pos];
+            if (transaction.rowsLeft > 0) {
+                if (transaction.begin)
+                    generateBegin(record, transaction);
+                generateDml(record, transaction);
+                --transaction.rowsLeft;
+            } else {
+                generateCommit(record, transaction);
+                activeSlots.erase((static_cast<uint64_t>(transaction.xid.usn()) << 16) | transaction.xid.slt());
+                active[pos] = active.back();
+                active.pop_back();
+            }
+            addRecord(record);
+        }
+
+        writeLwn();
+        closeLog();
+
+        ctx->info(0, "generated records: " + std::to_string(statRecords) + ", bytes: " + std::to_string(statBytes) +
+                  ", inserts: " + std::to_string(statOps[GENERATOR_OP_INSERT]) + ", updates: " + std::to_string(statOps[GENERATOR_OP_UPDATE]) +
+                  ", deletes: " + std::to_string(statOps[GENERATOR_OP_DELETE]));
+    }
+}
@@ -0,0 +1,158 @@
+/* Header for Generator class
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../common/FlatMap.h"
+#include "../common/types.h"
+#include "../common/typeXid.h"
+
+#ifndef GENERATOR_H_
+#define GENERATOR_H_
+
+#define GENERATOR_COLUMN_NUMBER                 1
+#define GENERATOR_COLUMN_VARCHAR2               2
+#define GENERATOR_COLUMN_RAW                    3
+
+#define GENERATOR_OP_INSERT                     0
+#define GENERATOR_OP_UPDATE                     1
+#define GENERATOR_OP_DELETE                     2
+
+#define GENERATOR_AFN_UNDO                      3
+#define GENERATOR_AFN_DATA                      4
+#define GENERATOR_SLOTS_IN_BLOCK                64
+#define GENERATOR_USN_MAX                       1000
+#define GENERATOR_SLT_MAX                       48
+
+namespace OpenLogReplicator {
+    class Ctx;
+
+    struct GeneratorColumn {
+        uint64_t type;
+        uint64_t length;
+    };
+
+    struct GeneratorRow {
+        uint64_t id;
+        uint64_t version;
+        typeDba bdba;
+        typeSlot slot;
+    };
+
+    struct GeneratorTable {
+        std::string owner;
+        std::string name;
+        typeObj obj;
+        typeDataObj dataObj;
+        std::vector<GeneratorColumn> columns;
+        std::vector<GeneratorRow> rows;
+        uint64_t nextId;
+        typeDba nextBdba;
+        typeSlot nextSlot;
+    };
+
+    struct GeneratorTransaction {
+        typeXid xid;
+        uint64_t rowsLeft;
+        uint8_t rci;
+        bool begin;
+    };
+
+    // Writes archived redo log files with synthetic DML, which can be replayed in batch mode
+    class Generator final {
+    protected:
+        Ctx* ctx;
+        std::string fileName;
+        std::string outputPath;
+        uint64_t compatVsn;
+        uint64_t blockSize;
+        uint64_t logBlocks;
+        uint64_t lwnRecords;
+        uint64_t lwnRuns;
+        uint64_t transactions;
+        uint64_t transactionSize;
+        uint64_t interleave;
+        uint64_t weights[3];
+        uint64_t updateColumns;
+        std::mt19937_64 random;
+        std::vector<GeneratorTable*> tables;
+        std::vector<GeneratorTransaction> active;
+        FlatSet<uint64_t> activeSlots;
+
+        // Output position
+        int fileDes;
+        std::string filePath;
+        typeSeq sequence;
+        typeBlk block;
+        typeScn scn;
+        typeScn firstScn;
+        typeScn startScn;
+        uint32_t timestamp;
+        typeSqn sqn;
+        uint64_t vectorHeaderSize;
+
+        // Records of the current LWN, header is added when the LWN is written
+        std::vector<std::vector<uint8_t>> records;
+        std::vector<uint64_t> lwnOrder;
+        std::vector<uint8_t> lwnBuffer;
+        uint64_t statRecords;
+        uint64_t statBytes;
+        uint64_t statOps[3];
+
+        [[nodiscard]] uint64_t nextRandom(uint64_t range);
+        [[nodiscard]] static uint64_t mix(uint64_t value);
+        [[nodiscard]] static uint32_t encodeTime(time_t time);
+        static void encodeNumber(std::vector<uint8_t>& value, uint64_t number);
+        void columnValue(std::vector<uint8_t>& value, const GeneratorTable* table, const GeneratorRow& row, uint64_t col) const;
+        [[nodiscard]] uint64_t rowSize(const GeneratorTable* table, const GeneratorRow& row) const;
+
+        void appendVector(std::vector<uint8_t>& record, typeOp1 opCode, uint16_t cls, typeAfn afn, typeDba dba,
+                          const std::vector<std::vector<uint8_t>>& fields) const;
+        [[nodiscard]] std::vector<uint8_t> fieldKtudb(const GeneratorTransaction& transaction) const;
+        [[nodiscard]] std::vector<uint8_t> fieldKtub(const GeneratorTransaction& transaction, const GeneratorTable* table) const;
+        [[nodiscard]] std::vector<uint8_t> fieldKtbRedo() const;
+        [[nodiscard]] std::vector<uint8_t> fieldKdo(typeDba bdba, uint8_t op, uint64_t length) const;
+        [[nodiscard]] std::vector<uint8_t> fieldKdoIrp(const GeneratorTable* table, const GeneratorRow& row) const;
+        [[nodiscard]] std::vector<uint8_t> fieldKdoDrp(const GeneratorRow& row) const;
+        [[nodiscard]] std::vector<uint8_t> fieldKdoUrp(const GeneratorRow& row, uint64_t cc) const;
+        [[nodiscard]] std::vector<uint8_t> fieldColNums(uint64_t cc) const;
+        [[nodiscard]] std::vector<uint8_t> fieldSuppLog(const GeneratorRow& row) const;
+
+        void generateBegin(std::vector<uint8_t>& record, const GeneratorTransaction& transaction);
+        void generateDml(std::vector<uint8_t>& record, GeneratorTransaction& transaction);
+        void generateCommit(std::vector<uint8_t>& record, const GeneratorTransaction& transaction);
+        void addRecord(std::vector<uint8_t>& record);
+
+        void openLog();
+        void closeLog();
+        void writeLwn();
+        void writeBlock(uint8_t* buffer, typeBlk blockNumber) const;
+
+    public:
+        Generator(Ctx* newCtx, const std::string& newFileName);
+        ~Generator();
+
+        void loadConfig();
+        void run();
+    };
+}
+
+#endif
@@ -25,6 +25,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include <unordered_map>
 #include <vector>
 
+#include "../common/FlatMap.h"
 #include "../common/SysCol.h"
 #include "../common/SysCCol.h"
 #include "../common/SysCDef.h"
@@ -85,10 +86,10 @@ namespace OpenLogReplicator {
         typeScn refScn;
         bool loaded;
 
-        std::unordered_map<typeDataObj, OracleLob*> lobPartitionMap;
+        FlatMap<typeDataObj, OracleLob*> lobPartitionMap;
         std::unordered_map<typeDataObj, OracleLob*> lobIndexMap;
         std::unordered_map<typeObj, OracleTable*> tableMap;
-        std::unordered_map<typeObj, OracleTable*> tablePartitionMap;
+        FlatMap<typeObj, OracleTable*> tablePartitionMap;
         OracleColumn* schemaColumn;
         OracleLob* schemaLob;
         OracleTable* schemaTable;
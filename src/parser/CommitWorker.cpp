@@ -0,0 +1,204 @@
+/* Thread formatting committed transactions in the order of the redo log
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <thread>
+
+#include "../builder/Builder.h"
+#include "../common/RedoLogException.h"
+#include "../common/RuntimeException.h"
+#include "../metadata/Metadata.h"
+#include "CommitWorker.h"
+#include "Transaction.h"
+
+namespace OpenLogReplicator {
+    CommitWorker::CommitWorker(Ctx* newCtx, const std::string& newAlias, Builder* newBuilder, Metadata* newMetadata,
+                               TransactionBuffer* newTransactionBuffer, uint64_t newQueueSizeMax) :
+            Thread(newCtx, newAlias),
+            builder(newBuilder),
+            metadata(newMetadata),
+            transactionBuffer(newTransactionBuffer),
+            queueSize(0),
+            queueSizeMax(newQueueSizeMax),
+            cancelled(false),
+            done(false),
+            stopped(false) {
+    }
+
+    CommitWorker::~CommitWorker() {
+        // Transactions which were not formatted are only released
+        for (CommitTask& task : queue) {
+            if (task.transaction != nullptr) {
+                task.transaction->purge(transactionBuffer);
+                delete task.transaction;
+            }
+        }
+        queue.clear();
+    }
+
+    void CommitWorker::wakeUp() {
+        std::unique_lock<std::mutex> lck(mtx);
+        condQueueFull.notify_all();
+        condQueueEmpty.notify_all();
+    }
+
+    void CommitWorker::push(const CommitTask& task, uint64_t size) {
+        std::unique_lock<std::mutex> lck(mtx);
+        // At least one task is always accepted, even if the transaction is bigger than the limit
+        while (!queue.empty() && queueSize + size > queueSizeMax && !stopped && !ctx->hardShutdown)
+            condQueueFull.wait(lck);
+
+        // The task is queued even if the worker has failed, the transaction is then released by the destructor
+        queue.push_back(task);
+        queueSize += size;
+        condQueueEmpty.notify_all();
+
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+
+    void CommitWorker::pushTransaction(Transaction* transaction) {
+        CommitTask task{};
+        task.transaction = transaction;
+        push(task, transaction->size);
+    }
+
+    void CommitWorker::pushCheckpoint(typeScn scn, typeTime timestamp, typeSeq sequence, uint64_t offset, bool redo) {
+        CommitTask task{};
+        task.transaction = nullptr;
+        task.scn = scn;
+        task.timestamp = timestamp;
+        task.sequence = sequence;
+        task.offset = offset;
+        task.redo = redo;
+        task.lwn = false;
+        push(task, 0);
+    }
+
+    void CommitWorker::pushCheckpoint(typeScn scn, typeTime timestamp, typeSeq sequence, uint64_t offset, uint64_t bytes, typeSeq minSequence,
+                                      uint64_t minOffset, typeXid minXid) {
+        CommitTask task{};
+        task.transaction = nullptr;
+        task.scn = scn;
+        task.timestamp = timestamp;
+        task.sequence = sequence;
+        task.offset = offset;
+        task.redo = false;
+        task.lwn = true;
+        task.bytes = bytes;
+        task.minSequence = minSequence;
+        task.minOffset = minOffset;
+        task.minXid = minXid;
+        push(task, 0);
+    }
+
+    void CommitWorker::drain() {
+        std::unique_lock<std::mutex> lck(mtx);
+        while (!queue.empty() && !stopped)
+            condQueueFull.wait(lck);
+
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+
+    void CommitWorker::finish() {
+        std::unique_lock<std::mutex> lck(mtx);
+        done = true;
+        condQueueEmpty.notify_all();
+    }
+
+    void CommitWorker::cancel() {
+        std::unique_lock<std::mutex> lck(mtx);
+        cancelled = true;
+        condQueueFull.notify_all();
+        condQueueEmpty.notify_all();
+    }
+
+    std::exception_ptr CommitWorker::getException() {
+        std::unique_lock<std::mutex> lck(mtx);
+        return exception;
+    }
+
+    void CommitWorker::process(CommitTask& task) {
+        if (task.transaction != nullptr) {
+            task.transaction->flush(metadata, transactionBuffer, builder);
+            task.transaction->purge(transactionBuffer);
+            delete task.transaction;
+            task.transaction = nullptr;
+            return;
+        }
+
+        builder->processCheckpoint(task.scn, task.timestamp, task.sequence, task.offset, task.redo);
+        if (task.lwn)
+            metadata->checkpoint(task.scn, task.timestamp, task.sequence, task.offset, task.bytes, task.minSequence, task.minOffset,
+                                 task.minXid);
+    }
+
+    void CommitWorker::run() {
+        if (ctx->trace & TRACE_THREADS) {
+            std::ostringstream ss;
+            ss << std::this_thread::get_id();
+            ctx->logTrace(TRACE_THREADS, "commit worker (" + ss.str() + ") start");
+        }
+
+        std::exception_ptr exceptionTmp;
+        try {
+            while (true) {
+                CommitTask* task;
+                {
+                    std::unique_lock<std::mutex> lck(mtx);
+                    while (queue.empty() && !done && !cancelled && !ctx->hardShutdown)
+                        condQueueEmpty.wait(lck);
+                    if (queue.empty() || cancelled || ctx->hardShutdown)
+                        break;
+                    // References to the elements of the deque stay valid when the parser adds tasks at the end
+                    task = &queue.front();
+                }
+
+                uint64_t size = (task->transaction != nullptr) ? task->transaction->size : 0;
+                process(*task);
+
+                {
+                    std::unique_lock<std::mutex> lck(mtx);
+                    queue.pop_front();
+                    queueSize -= size;
+                    condQueueFull.notify_all();
+                }
+            }
+        } catch (RedoLogException&) {
+            exceptionTmp = std::current_exception();
+        } catch (RuntimeException&) {
+            exceptionTmp = std::current_exception();
+        } catch (std::bad_alloc& ex) {
+            exceptionTmp = std::make_exception_ptr(RuntimeException(10018, "memory allocation failed: " + std::string(ex.what())));
+        }
+
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            exception = exceptionTmp;
+            stopped = true;
+            condQueueFull.notify_all();
+        }
+
+        if (ctx->trace & TRACE_THREADS) {
+            std::ostringstream ss;
+            ss << std::this_thread::get_id();
+            ctx->logTrace(TRACE_THREADS, "commit worker (" + ss.str() + ") stop");
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/* Header for CommitWorker class
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+
+#include "../common/Thread.h"
+#include "../common/types.h"
+#include "../common/typeTime.h"
+#include "../common/typeXid.h"
+
+#ifndef COMMIT_WORKER_H_
+#define COMMIT_WORKER_H_
+
+namespace OpenLogReplicator {
+    class Builder;
+    class Metadata;
+    class Transaction;
+    class TransactionBuffer;
+
+    // Committed transaction or checkpoint, processed in the order of the redo log
+    struct CommitTask {
+        Transaction* transaction;
+        typeScn scn;
+        typeTime timestamp;
+        typeSeq sequence;
+        uint64_t offset;
+        bool redo;
+        // Checkpoint of an LWN, the position is also stored in the metadata
+        bool lwn;
+        uint64_t bytes;
+        typeSeq minSequence;
+        uint64_t minOffset;
+        typeXid minXid;
+    };
+
+    class CommitWorker : public Thread {
+    protected:
+        Builder* builder;
+        Metadata* metadata;
+        TransactionBuffer* transactionBuffer;
+        std::mutex mtx;
+        std::condition_variable condQueueFull;
+        std::condition_variable condQueueEmpty;
+        // The first task stays in the queue until it is processed, so the queue is empty only when the worker is idle
+        std::deque<CommitTask> queue;
+        uint64_t queueSize;
+        uint64_t queueSizeMax;
+        bool cancelled;
+        bool done;
+        bool stopped;
+        std::exception_ptr exception;
+
+        void push(const CommitTask& task, uint64_t size);
+        void process(CommitTask& task);
+        void run() override;
+
+    public:
+        CommitWorker(Ctx* newCtx, const std::string& newAlias, Builder* newBuilder, Metadata* newMetadata, TransactionBuffer* newTransactionBuffer,
+                     uint64_t newQueueSizeMax);
+        ~CommitWorker() override;
+
+        void wakeUp() override;
+        void pushTransaction(Transaction* transaction);
+        void pushCheckpoint(typeScn scn, typeTime timestamp, typeSeq sequence, uint64_t offset, bool redo);
+        void pushCheckpoint(typeScn scn, typeTime timestamp, typeSeq sequence, uint64_t offset, uint64_t bytes, typeSeq minSequence,
+                            uint64_t minOffset, typeXid minXid);
+        void drain();
+        void finish();
+        void cancel();
+        [[nodiscard]] std::exception_ptr getException();
+    };
+}
+
+#endif
@@ -516,7 +516,7 @@ namespace OpenLogReplicator {
         }
 
         if (!RedoLogRecord::nextFieldOpt(ctx, redoLogRecord, fieldNum, fieldPos, fieldLength, 0x050118)) {
-            ctx->suppLogSize += suppLogSize;
+            redoLogRecord->suppLogSize = suppLogSize;
             return;
         }
 
@@ -524,7 +524,7 @@ namespace OpenLogReplicator {
         uint8_t* colNumsSupp = redoLogRecord->data + redoLogRecord->suppLogNumsDelta;
 
         if (!RedoLogRecord::nextFieldOpt(ctx, redoLogRecord, fieldNum, fieldPos, fieldLength, 0x050119)) {
-            ctx->suppLogSize += suppLogSize;
+            redoLogRecord->suppLogSize = suppLogSize;
             return;
         }
         ++suppLogFieldCnt;
@@ -543,6 +543,6 @@ namespace OpenLogReplicator {
         }
 
         suppLogSize += ((redoLogRecord->fieldCnt * 2 + 2) & 0xFFFC) - (((redoLogRecord->fieldCnt - suppLogFieldCnt) * 2 + 2) & 0xFFFC);
-        ctx->suppLogSize += suppLogSize;
+        redoLogRecord->suppLogSize = suppLogSize;
     }
 }
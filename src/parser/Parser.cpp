@@ -17,15 +17,21 @@ You should have received a copy of the GNU General Public License
 along with OpenLogReplicator; see the file LICENSE;  If not see
 <http://www.gnu.org/licenses/>.  */
 
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
 #include "../builder/Builder.h"
 #include "../common/LobCtx.h"
 #include "../common/OracleLob.h"
 #include "../common/OracleTable.h"
+#include "../common/PerfStats.h"
 #include "../common/RedoLogException.h"
 #include "../common/Timer.h"
 #include "../metadata/Metadata.h"
 #include "../metadata/Schema.h"
 #include "../reader/Reader.h"
+#include "CommitWorker.h"
 #include "OpCode0501.h"
 #include "OpCode0502.h"
 #include "OpCode0504.h"
@@ -51,10 +57,69 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include "OpCode1A02.h"
 #include "OpCode1A06.h"
 #include "Parser.h"
+#include "ParserWorker.h"
 #include "Transaction.h"
 #include "TransactionBuffer.h"
 
 namespace OpenLogReplicator {
+    const ParserOpCode Parser::opCodes[PARSER_OPCODES] = {
+            // opCode, process, undoLink, undoRecord, record, rollback
+            {0x0000, OpCode::process, false, PARSER_RECORD_NONE, PARSER_RECORD_NONE, false},
+            {0x0A00, OpCode::process, false, PARSER_RECORD_INDEX, PARSER_RECORD_NONE, false},
+            {0x0B00, OpCode::process, false, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            // Undo
+            {0x0501, OpCode0501::process, false, PARSER_RECORD_UNDO, PARSER_RECORD_NONE, false},
+            // Begin transaction
+            {0x0502, OpCode0502::process, false, PARSER_RECORD_NONE, PARSER_RECORD_BEGIN, false},
+            // Commit/rollback transaction
+            {0x0504, OpCode0504::process, false, PARSER_RECORD_NONE, PARSER_RECORD_COMMIT, false},
+            // Partial rollback
+            {0x0506, OpCode0506::process, false, PARSER_RECORD_NONE, PARSER_RECORD_ROLLBACK, true},
+            {0x050B, OpCode050B::process, false, PARSER_RECORD_NONE, PARSER_RECORD_ROLLBACK, true},
+            // Session information
+            {0x0513, OpCode0513::process, false, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            {0x0514, OpCode0514::process, false, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            // REDO: Insert leaf row, Init header, Update key data in row
+            {0x0A02, OpCode0A02::process, true, PARSER_RECORD_INDEX, PARSER_RECORD_NONE, false},
+            {0x0A08, OpCode0A08::process, true, PARSER_RECORD_INDEX, PARSER_RECORD_NONE, false},
+            {0x0A12, OpCode0A12::process, true, PARSER_RECORD_INDEX, PARSER_RECORD_NONE, false},
+            // REDO: Insert, Delete, Lock, Update, Overwrite row piece, Change forwarding address
+            {0x0B02, OpCode0B02::process, true, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            {0x0B03, OpCode0B03::process, true, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            {0x0B04, OpCode0B04::process, true, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            {0x0B05, OpCode0B05::process, true, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            {0x0B06, OpCode0B06::process, true, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            {0x0B08, OpCode0B08::process, true, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            // REDO: Insert, Delete multiple rows, Supplemental log for update, Logminer support - KDOCMP
+            {0x0B0B, OpCode0B0B::process, true, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            {0x0B0C, OpCode0B0C::process, true, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            {0x0B10, OpCode0B10::process, true, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            {0x0B16, OpCode0B16::process, true, PARSER_RECORD_DML, PARSER_RECORD_NONE, false},
+            // LOB
+            {0x1301, OpCode1301::process, false, PARSER_RECORD_NONE, PARSER_RECORD_LOB, false},
+            // LOB index 12+
+            {0x1A02, OpCode1A02::process, true, PARSER_RECORD_INDEX, PARSER_RECORD_NONE, false},
+            {0x1A06, OpCode1A06::process, false, PARSER_RECORD_NONE, PARSER_RECORD_LOB, false},
+            // DDL
+            {0x1801, OpCode1801::process, false, PARSER_RECORD_NONE, PARSER_RECORD_DDL, false}
+    };
+
+    uint8_t Parser::opCodeMap[0x10000];
+
+    void Parser::initializeOpCodes() {
+        for (uint64_t opCode = 0; opCode < 0x10000; ++opCode) {
+            if ((opCode & 0xFF00) == 0x0A00)
+                opCodeMap[opCode] = 1;
+            else if ((opCode & 0xFF00) == 0x0B00)
+                opCodeMap[opCode] = 2;
+            else
+                opCodeMap[opCode] = 0;
+        }
+
+        for (uint64_t i = 3; i < PARSER_OPCODES; ++i)
+            opCodeMap[opCodes[i].opCode] = i;
+    }
+
     Parser::Parser(Ctx* newCtx, Builder* newBuilder, Metadata* newMetadata, TransactionBuffer* newTransactionBuffer, int64_t newGroup,
                 const std::string& newPath) :
             ctx(newCtx),
@@ -66,29 +131,52 @@ namespace OpenLogReplicator {
             lwnTimestamp(0),
             lwnScn(0),
             lwnCheckpointBlock(0),
+            producer(nullptr),
+            committer(nullptr),
+            lwnDecoded(nullptr),
+            lwnDecodedMember(0),
+            lwnLatencyCount(0),
+            lwnLatencySum(0),
+            lwnLatencyMax(0),
             group(newGroup),
             path(newPath),
             sequence(0),
             firstScn(ZERO_SCN),
             nextScn(ZERO_SCN),
-            reader(nullptr) {
+            reader(nullptr),
+            worker(nullptr) {
 
         memset(reinterpret_cast<void*>(&zero), 0, sizeof(RedoLogRecord));
+        memset(reinterpret_cast<void*>(lwnLatencyHistogram), 0, sizeof(lwnLatencyHistogram));
+        memset(reinterpret_cast<void*>(opCodeStats), 0, sizeof(opCodeStats));
+        memset(reinterpret_cast<void*>(&prefilterStats), 0, sizeof(prefilterStats));
+        suppLogSize = 0;
+
+        static std::once_flag opCodesInitialized;
+        std::call_once(opCodesInitialized, initializeOpCodes);
 
         lwnChunks[0] = ctx->getMemoryChunk("parser", false);
         auto length = reinterpret_cast<uint64_t*>(lwnChunks[0]);
         *length = sizeof(uint64_t);
         lwnAllocated = 1;
         lwnAllocatedMax = 1;
+        lwnInPlace = 0;
+        lwnHeldMax = 0;
     }
 
     Parser::~Parser() {
+        if (committer != nullptr)
+            commitStop(true);
+
         while (lwnAllocated > 0) {
             ctx->freeMemoryChunk("parser", lwnChunks[--lwnAllocated], false);
         }
     }
 
     void Parser::freeLwn() {
+        lwnInPlace = 0;
+        releaseLwn();
+
         while (lwnAllocated > 1) {
             ctx->freeMemoryChunk("parser", lwnChunks[--lwnAllocated], false);
         }
@@ -97,13 +185,98 @@ namespace OpenLogReplicator {
         *length = sizeof(uint64_t);
     }
 
+    LwnMember* Parser::allocateLwn(uint64_t recordLength4) {
+        uint64_t size = (sizeof(struct LwnMember) + recordLength4 + 7) & 0xFFFFFFF8;
+        auto length = reinterpret_cast<uint64_t*>(lwnChunks[lwnAllocated - 1]);
+
+        if (*length + size > ctx->memoryChunkSize) {
+            if (lwnAllocated == MAX_LWN_CHUNKS / ctx->memoryChunkSizeMb)
+                throw RedoLogException(50052, "all " + std::to_string(MAX_LWN_CHUNKS / ctx->memoryChunkSizeMb) + " lwn buffers allocated");
+
+            lwnChunks[lwnAllocated++] = ctx->getMemoryChunk("parser", false);
+            if (lwnAllocated > lwnAllocatedMax)
+                lwnAllocatedMax = lwnAllocated;
+            length = reinterpret_cast<uint64_t*>(lwnChunks[lwnAllocated - 1]);
+            *length = sizeof(uint64_t);
+        }
+
+        if (*length + size > ctx->memoryChunkSize)
+            throw RedoLogException(50053, "too big redo log record, length: " + std::to_string(recordLength4));
+
+        auto lwnMember = reinterpret_cast<struct LwnMember*>(lwnChunks[lwnAllocated - 1] + *length);
+        *length += size;
+        lwnMember->data = reinterpret_cast<uint8_t*>(lwnMember) + sizeof(struct LwnMember);
+        return lwnMember;
+    }
+
+    void Parser::materializeLwn(uint64_t lwnRecords) {
+        // Read buffers are going to be released, copy the records which are referenced in place
+        for (uint64_t i = 0; i < lwnRecords && lwnInPlace > 0; ++i) {
+            LwnMember* lwnMember = lwnMembers[i];
+            if (lwnMember->data == reinterpret_cast<uint8_t*>(lwnMember) + sizeof(struct LwnMember))
+                continue;
+
+            LwnMember* lwnMemberCopy = allocateLwn(lwnMember->length);
+            uint8_t* data = lwnMemberCopy->data;
+            *lwnMemberCopy = *lwnMember;
+            lwnMemberCopy->data = data;
+            memcpy(reinterpret_cast<void*>(lwnMemberCopy->data),
+                   reinterpret_cast<const void*>(lwnMember->data), lwnMember->length);
+            lwnMembers[i] = lwnMemberCopy;
+            --lwnInPlace;
+        }
+
+        releaseLwn();
+    }
+
+    void Parser::sortLwn(uint64_t lwnRecords) {
+        // Members mostly come in order of scn and subscn, so runs that are already sorted are found and merged pairwise
+        auto lwnMemberLess = [](const LwnMember* lwnMember1, const LwnMember* lwnMember2) -> bool {
+            return lwnMember1->scn < lwnMember2->scn || (lwnMember1->scn == lwnMember2->scn && lwnMember1->subScn < lwnMember2->subScn);
+        };
+
+        lwnRuns.clear();
+        lwnRuns.push_back(0);
+        for (uint64_t i = 1; i < lwnRecords; ++i) {
+            if (lwnMemberLess(lwnMembers[i], lwnMembers[i - 1]))
+                lwnRuns.push_back(i);
+        }
+        if (lwnRuns.size() == 1)
+            return;
+        lwnRuns.push_back(lwnRecords);
+
+        // Merge is stable, members with equal scn and subscn stay in order of appearance
+        while (lwnRuns.size() > 2) {
+            uint64_t runs = 0;
+            uint64_t i = 0;
+            for (; i + 2 < lwnRuns.size(); i += 2) {
+                std::inplace_merge(lwnMembers + lwnRuns[i], lwnMembers + lwnRuns[i + 1], lwnMembers + lwnRuns[i + 2], lwnMemberLess);
+                lwnRuns[runs++] = lwnRuns[i];
+            }
+            if (i + 1 < lwnRuns.size())
+                lwnRuns[runs++] = lwnRuns[i];
+            lwnRuns.resize(runs);
+            if (lwnRuns.back() != lwnRecords)
+                lwnRuns.push_back(lwnRecords);
+        }
+    }
+
+    void Parser::releaseLwn() {
+        for (uint8_t* buffer: lwnHeld)
+            reader->bufferRelease(buffer);
+        lwnHeld.clear();
+    }
+
     void Parser::analyzeLwn(LwnMember* lwnMember) {
+        PerfScope perfScope(ctx->perfStats, PERF_STAGE_DECODE);
+        if (ctx->perfStats != nullptr)
+            ctx->perfStats->add(PERF_STAGE_DECODE, lwnMember->length, 1);
         if (ctx->trace & TRACE_LWN)
             ctx->logTrace(TRACE_LWN, "analyze blk: " + std::to_string(lwnMember->block) + " offset: " +
                           std::to_string(lwnMember->offset) + " scn: " + std::to_string(lwnMember->scn) + " subscn: " +
                           std::to_string(lwnMember->subScn));
 
-        uint8_t* data = reinterpret_cast<uint8_t*>(lwnMember) + sizeof(struct LwnMember);
+        uint8_t* data = lwnMember->data;
         RedoLogRecord redoLogRecord[2];
         int64_t vectorCur = -1;
         int64_t vectorPrev = -1;
@@ -193,6 +366,10 @@ namespace OpenLogReplicator {
 
         uint64_t offset = headerLength;
         uint64_t vectors = 0;
+        // Objects which are not replicated can be dropped before decoding only when the schema is current; incomplete transactions
+        // are created by any DML, also of a table which is not replicated
+        bool prefilter = lwnDecoded == nullptr && ctx->dumpRedoLog == 0 && !FLAG(REDO_FLAGS_SCHEMALESS) &&
+                         !FLAG(REDO_FLAGS_SHOW_INCOMPLETE_TRANSACTIONS);
 
         while (offset < recordLength) {
             vectorPrev = vectorCur;
@@ -284,200 +461,49 @@ namespace OpenLogReplicator {
             redoLogRecord[vectorCur].recordDataObj = 0xFFFFFFFF;
             offset += redoLogRecord[vectorCur].length;
 
-            switch (redoLogRecord[vectorCur].opCode) {
-                // Undo
-                case 0x0501:
-                    OpCode0501::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // Begin transaction
-                case 0x0502:
-                    OpCode0502::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // Commit/rollback transaction
-                case 0x0504:
-                    OpCode0504::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // Partial rollback
-                case 0x0506:
-                    OpCode0506::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                case 0x050B:
-                    OpCode050B::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // Session information
-                case 0x0513:
-                    OpCode0513::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // Session information
-                case 0x0514:
-                    OpCode0514::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Insert leaf row
-                case 0x0A02:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0A02::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Init header
-                case 0x0A08:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0A08::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Update key data in row
-                case 0x0A12:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0A12::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Insert row piece
-                case 0x0B02:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0B02::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Delete row piece
-                case 0x0B03:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0B03::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Lock row piece
-                case 0x0B04:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0B04::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Update row piece
-                case 0x0B05:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0B05::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Overwrite row piece
-                case 0x0B06:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0B06::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Change forwarding address
-                case 0x0B08:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0B08::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Insert multiple rows
-                case 0x0B0B:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0B0B::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Delete multiple rows
-                case 0x0B0C:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0B0C::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Supplemental log for update
-                case 0x0B10:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0B10::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // REDO: Logminer support - KDOCMP
-                case 0x0B16:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode0B16::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // LOB
-                case 0x1301:
-                    OpCode1301::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // LOB index 12+
-                case 0x1A02:
-                    if (vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
-                        redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
-                        redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
-                    }
-                    OpCode1A02::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                case 0x1A06:
-                    OpCode1A06::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
-
-                // DDL
-                case 0x1801:
-                    OpCode1801::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
+            // Undo and redo pair of DML for a table which is not replicated
+            if (prefilter && redoLogRecord[vectorCur].opCode == 0x0501 && (vectorPrev == -1 || redoLogRecord[vectorPrev].opCode != 0x0501)) {
+                uint64_t skipLength = prefilterDml(&redoLogRecord[vectorCur], data, offset, recordLength);
+                if (skipLength > 0) {
+                    ++vectors;
+                    prefilterStats.count += 2;
+                    prefilterStats.bytes += redoLogRecord[vectorCur].length + skipLength;
+                    offset += skipLength;
+                    vectorCur = -1;
+                    continue;
+                }
+            }
 
-                default:
-                    OpCode::process(ctx, &redoLogRecord[vectorCur]);
-                    break;
+            uint8_t opCodeNum = opCodeMap[redoLogRecord[vectorCur].opCode & 0xFFFF];
+            const ParserOpCode& opCode = opCodes[opCodeNum];
+            if (opCode.undoLink && vectorPrev != -1 && redoLogRecord[vectorPrev].opCode == 0x0501) {
+                redoLogRecord[vectorCur].recordDataObj = redoLogRecord[vectorPrev].dataObj;
+                redoLogRecord[vectorCur].recordObj = redoLogRecord[vectorPrev].obj;
             }
 
+            ++opCodeStats[opCodeNum].count;
+            opCodeStats[opCodeNum].bytes += redoLogRecord[vectorCur].length;
+            if (ctx->trace & TRACE_PERFORMANCE) {
+                auto decodeStart = std::chrono::steady_clock::now();
+                opCode.process(ctx, &redoLogRecord[vectorCur]);
+                opCodeStats[opCodeNum].timeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - decodeStart).count();
+            } else
+                opCode.process(ctx, &redoLogRecord[vectorCur]);
+            suppLogSize += redoLogRecord[vectorCur].suppLogSize;
+
             if (vectorPrev != -1) {
                 if (redoLogRecord[vectorPrev].opCode == 0x0501) {
-                    // UNDO - index
-                    if ((redoLogRecord[vectorCur].opCode & 0xFF00) == 0x0A00 || redoLogRecord[vectorCur].opCode == 0x1A02)
-                        appendToTransactionIndex(&redoLogRecord[vectorPrev], &redoLogRecord[vectorCur]);
-                    // UNDO - data
-                    else if ((redoLogRecord[vectorCur].opCode & 0xFF00) == 0x0B00 || redoLogRecord[vectorCur].opCode == 0x0513 ||
-                            redoLogRecord[vectorCur].opCode == 0x0514)
-                        appendToTransaction(&redoLogRecord[vectorPrev], &redoLogRecord[vectorCur]);
                     // single 5.1
-                    else if (redoLogRecord[vectorCur].opCode == 0x0501) {
-                        appendToTransaction(&redoLogRecord[vectorPrev]);
+                    if (opCode.undoRecord == PARSER_RECORD_UNDO) {
+                        appendRecord(PARSER_RECORD_UNDO, &redoLogRecord[vectorPrev], nullptr);
                         continue;
-                    } else if (redoLogRecord[vectorPrev].opc == 0x0B01)
+                    }
+
+                    // UNDO - index or data
+                    if (opCode.undoRecord != PARSER_RECORD_NONE)
+                        appendRecord(opCode.undoRecord, &redoLogRecord[vectorPrev], &redoLogRecord[vectorCur]);
+                    else if (redoLogRecord[vectorPrev].opc == 0x0B01)
                         ctx->warning(70010, "unknown undo OP: " + std::to_string(redoLogRecord[vectorCur].opCode) + ", opc: " +
                                      std::to_string(redoLogRecord[vectorPrev].opc));
 
@@ -485,9 +511,9 @@ namespace OpenLogReplicator {
                     continue;
                 }
 
-                if ((redoLogRecord[vectorCur].opCode == 0x0506 || redoLogRecord[vectorCur].opCode == 0x050B)) {
+                if (opCode.rollback) {
                     if ((redoLogRecord[vectorPrev].opCode & 0xFF00) == 0x0B00)
-                        appendToTransactionRollback(&redoLogRecord[vectorPrev], &redoLogRecord[vectorCur]);
+                        appendRecord(PARSER_RECORD_DML_ROLLBACK, &redoLogRecord[vectorPrev], &redoLogRecord[vectorCur]);
                     else if (redoLogRecord[vectorCur].opc == 0x0B01)
                         ctx->warning(70011, "unknown rollback OP: " + std::to_string(redoLogRecord[vectorPrev].opCode) + ", opc: " +
                                      std::to_string(redoLogRecord[vectorCur].opc));
@@ -499,50 +525,277 @@ namespace OpenLogReplicator {
 
             // UNDO - data
             if (redoLogRecord[vectorCur].opCode == 0x0501 && (redoLogRecord[vectorCur].flg & (FLG_MULTIBLOCKUNDOTAIL | FLG_MULTIBLOCKUNDOMID)) != 0) {
-                appendToTransaction(&redoLogRecord[vectorCur]);
+                appendRecord(PARSER_RECORD_UNDO, &redoLogRecord[vectorCur], nullptr);
                 vectorCur = -1;
                 continue;
             }
 
-            // ROLLBACK - data
-            if (redoLogRecord[vectorCur].opCode == 0x0506 || redoLogRecord[vectorCur].opCode == 0x050B) {
-                appendToTransactionRollback(&redoLogRecord[vectorCur]);
+            // ROLLBACK, BEGIN, COMMIT, LOB, DDL
+            if (opCode.record != PARSER_RECORD_NONE) {
+                appendRecord(opCode.record, &redoLogRecord[vectorCur], nullptr);
                 vectorCur = -1;
                 continue;
             }
+        }
 
-            // BEGIN
-            if (redoLogRecord[vectorCur].opCode == 0x0502) {
-                appendToTransactionBegin(&redoLogRecord[vectorCur]);
-                vectorCur = -1;
-                continue;
-            }
+        // UNDO - data
+        if (vectorCur != -1 && redoLogRecord[vectorCur].opCode == 0x0501) {
+            appendRecord(PARSER_RECORD_UNDO, &redoLogRecord[vectorCur], nullptr);
+        }
+    }
 
-            // COMMIT
-            if (redoLogRecord[vectorCur].opCode == 0x0504) {
-                appendToTransactionCommit(&redoLogRecord[vectorCur]);
-                vectorCur = -1;
-                continue;
-            }
+    uint64_t Parser::prefilterDml(const RedoLogRecord* redoLogRecord, const uint8_t* data, uint64_t offset, uint64_t recordLength) const {
+        // Field 2 of undo vector: ktubl/ktubu, the same values as read by OpCode::ktub
+        if (redoLogRecord->fieldCnt < 2)
+            return 0;
+        const uint8_t* fieldList = redoLogRecord->data + redoLogRecord->fieldLengthsDelta;
+        uint64_t fieldPos = redoLogRecord->fieldPos + ((ctx->read16(fieldList + 2) + 3) & 0xFFFC);
+        if (ctx->read16(fieldList + 4) < 24 || fieldPos + 24 > redoLogRecord->length)
+            return 0;
+
+        const uint8_t* ktub = redoLogRecord->data + fieldPos;
+        typeObj obj = ctx->read32(ktub + 0);
+        typeDataObj dataObj = ctx->read32(ktub + 4);
+        typeOp2 opc = (static_cast<typeOp1>(ktub[16]) << 8) | ktub[17];
+        uint16_t flg = ctx->read16(ktub + 20);
+        if (dataObj == 0 || opc != 0x0B01 || (flg & (FLG_MULTIBLOCKUNDOHEAD | FLG_MULTIBLOCKUNDOTAIL | FLG_MULTIBLOCKUNDOMID)) != 0)
+            return 0;
+
+        // Next vector must be the matching table redo, the layout is verified the same way as in analyzeLwn
+        uint64_t fieldOffset = redoLogRecord->fieldLengthsDelta;
+        if (offset + fieldOffset + 2 > recordLength)
+            return 0;
+        const uint8_t* redo = data + offset;
+        const ParserOpCode& opCode = opCodes[opCodeMap[(static_cast<typeOp1>(redo[0]) << 8) | redo[1]]];
+        if (!opCode.undoLink || opCode.undoRecord != PARSER_RECORD_DML)
+            return 0;
+
+        const uint8_t* redoFieldList = redo + fieldOffset;
+        uint16_t fieldListLength = ctx->read16(redoFieldList);
+        if (fieldListLength < 2)
+            return 0;
+        uint64_t length = fieldOffset + ((fieldListLength + 2) & 0xFFFC);
+        if (offset + length > recordLength)
+            return 0;
+        uint64_t fieldCnt = (fieldListLength - 2) / 2;
+        for (uint64_t i = 1; i <= fieldCnt; ++i)
+            length += (ctx->read16(redoFieldList + i * 2) + 3) & 0xFFFC;
+        if (offset + length > recordLength)
+            return 0;
+
+        // Container and table checks of appendToTransaction, the bdba consistency check (50045) is not done for dropped records
+        if (metadata->conId > 0 && ctx->version >= REDO_VERSION_12_1 && static_cast<typeConId>(ctx->read16(redo + 24)) != metadata->conId)
+            return length;
+        if (metadata->schema->checkTableDict(obj) != nullptr)
+            return 0;
+        return length;
+    }
 
-            // LOB
-            if (redoLogRecord[vectorCur].opCode == 0x1301 || redoLogRecord[vectorCur].opCode == 0x1A06) {
-                appendToTransactionLob(&redoLogRecord[vectorCur]);
-                vectorCur = -1;
-                continue;
-            }
+    void Parser::mergeStats(const Parser* parser) {
+        for (uint64_t i = 0; i < PARSER_OPCODES; ++i) {
+            opCodeStats[i].count += parser->opCodeStats[i].count;
+            opCodeStats[i].bytes += parser->opCodeStats[i].bytes;
+            opCodeStats[i].timeNs += parser->opCodeStats[i].timeNs;
+        }
+        prefilterStats.count += parser->prefilterStats.count;
+        prefilterStats.bytes += parser->prefilterStats.bytes;
+        suppLogSize += parser->suppLogSize;
+    }
 
-            // DDL
-            if (redoLogRecord[vectorCur].opCode == 0x1801) {
-                appendToTransactionDdl(&redoLogRecord[vectorCur]);
-                vectorCur = -1;
+    void Parser::printOpCodeStats() const {
+        for (uint64_t i = 0; i < PARSER_OPCODES; ++i) {
+            if (opCodeStats[i].count == 0)
                 continue;
+
+            std::string opCode;
+            if (i == 0)
+                opCode = "other";
+            else if (opCodes[i].opCode == 0x0A00 || opCodes[i].opCode == 0x0B00)
+                opCode = std::to_string(opCodes[i].opCode >> 8) + ".*";
+            else
+                opCode = std::to_string(opCodes[i].opCode >> 8) + "." + std::to_string(opCodes[i].opCode & 0xFF);
+
+            ctx->logTrace(TRACE_PERFORMANCE, "OP " + opCode + ": " + std::to_string(opCodeStats[i].count) + " records, " +
+                          std::to_string(opCodeStats[i].bytes) + " bytes, " + std::to_string(opCodeStats[i].timeNs / 1000) + " us");
+        }
+
+        if (prefilterStats.count > 0)
+            ctx->logTrace(TRACE_PERFORMANCE, "OP filtered: " + std::to_string(prefilterStats.count) + " records, " +
+                          std::to_string(prefilterStats.bytes) + " bytes");
+    }
+
+    void Parser::analyzeError(const RedoLogException& ex) {
+        if (FLAG(REDO_FLAGS_IGNORE_DATA_ERRORS)) {
+            ctx->error(ex.code, ex.msg);
+            ctx->warning(60013, "forced to continue working in spite of error");
+        } else
+            throw RedoLogException(ex.code, "runtime error, aborting further redo log processing: " + ex.msg);
+    }
+
+    void Parser::appendRecord(uint64_t type, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2) {
+        if (lwnDecoded == nullptr) {
+            applyRecord(type, redoLogRecord1, redoLogRecord2);
+            return;
+        }
+
+        // Catch-up worker: the record is appended later by the ordered stage, the data stays in the LWN chunks
+        lwnDecoded->records.emplace_back();
+        ParserRecord& parserRecord = lwnDecoded->records.back();
+        parserRecord.type = type;
+        parserRecord.member = lwnDecodedMember;
+        parserRecord.error = 0;
+        parserRecord.redoLogRecord1 = *redoLogRecord1;
+        if (redoLogRecord2 != nullptr)
+            parserRecord.redoLogRecord2 = *redoLogRecord2;
+        lwnDecoded->size += sizeof(ParserRecord);
+    }
+
+    void Parser::applyRecord(uint64_t type, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2) {
+        switch (type) {
+            case PARSER_RECORD_DDL:
+                appendToTransactionDdl(redoLogRecord1);
+                break;
+
+            case PARSER_RECORD_BEGIN:
+                appendToTransactionBegin(redoLogRecord1);
+                break;
+
+            case PARSER_RECORD_COMMIT:
+                appendToTransactionCommit(redoLogRecord1);
+                break;
+
+            case PARSER_RECORD_LOB:
+                appendToTransactionLob(redoLogRecord1);
+                break;
+
+            case PARSER_RECORD_INDEX:
+                appendToTransactionIndex(redoLogRecord1, redoLogRecord2);
+                break;
+
+            case PARSER_RECORD_UNDO:
+                appendToTransaction(redoLogRecord1);
+                break;
+
+            case PARSER_RECORD_ROLLBACK:
+                appendToTransactionRollback(redoLogRecord1);
+                break;
+
+            case PARSER_RECORD_DML:
+                appendToTransaction(redoLogRecord1, redoLogRecord2);
+                break;
+
+            case PARSER_RECORD_DML_ROLLBACK:
+                appendToTransactionRollback(redoLogRecord1, redoLogRecord2);
+                break;
+
+            default:
+                throw RedoLogException(50064, "unknown decoded record type: " + std::to_string(type));
+        }
+    }
+
+    void Parser::updateLwnLatency() {
+        // Time from the last write to the redo log file until the complete LWN is seen by the parser
+        time_t writeTime = reader->getWriteTime();
+        if (writeTime == 0)
+            return;
+
+        time_t nowTime = Timer::getTime();
+        uint64_t latency = (nowTime > writeTime) ? static_cast<uint64_t>(nowTime - writeTime) : 0;
+        ++lwnLatencyCount;
+        lwnLatencySum += latency;
+        if (latency > lwnLatencyMax)
+            lwnLatencyMax = latency;
+
+        // Bucket n holds latencies below 2^n microseconds
+        uint64_t bucket = 0;
+        while (bucket < LWN_LATENCY_BUCKETS - 1 && (latency >> bucket) > 0)
+            ++bucket;
+        ++lwnLatencyHistogram[bucket];
+
+        if (ctx->trace & TRACE_LWN)
+            ctx->logTrace(TRACE_LWN, "latency: " + std::to_string(latency) + " us");
+    }
+
+    uint64_t Parser::getLwnLatencyPercentile(uint64_t percent) const {
+        uint64_t count = 0;
+        for (uint64_t bucket = 0; bucket < LWN_LATENCY_BUCKETS; ++bucket) {
+            count += lwnLatencyHistogram[bucket];
+            if (count * 100 >= lwnLatencyCount * percent)
+                return static_cast<uint64_t>(1) << bucket;
+        }
+        return lwnLatencyMax;
+    }
+
+    void Parser::decodeLwn(uint64_t lwnRecords, uint64_t currentBlock) {
+        lwnDecoded = new ParserLwn();
+        lwnDecoded->size = 0;
+        lwnDecoded->scn = lwnScn;
+        lwnDecoded->timestamp = lwnTimestamp;
+        lwnDecoded->checkpointBlock = lwnCheckpointBlock;
+        lwnDecoded->block = currentBlock;
+
+        if (producer->decode) {
+            for (lwnDecodedMember = 0; lwnDecodedMember < lwnRecords; ++lwnDecodedMember) {
+                try {
+                    analyzeLwn(lwnMembers[lwnDecodedMember]);
+                } catch (RedoLogException &ex) {
+                    // Reported by the ordered stage at the same position as it would be during serial parsing
+                    lwnDecoded->records.emplace_back();
+                    ParserRecord& parserRecord = lwnDecoded->records.back();
+                    parserRecord.type = PARSER_RECORD_ERROR;
+                    parserRecord.member = lwnDecodedMember;
+                    parserRecord.error = lwnDecoded->errors.size();
+                    lwnDecoded->errors.push_back(ex);
+                }
             }
+        } else {
+            // Parser pipeline: the sorted LWN is analyzed by the ordered stage
+            lwnDecoded->members.assign(lwnMembers, lwnMembers + lwnRecords);
+            lwnDecoded->size += lwnRecords * sizeof(LwnMember*);
         }
 
-        // UNDO - data
-        if (vectorCur != -1 && redoLogRecord[vectorCur].opCode == 0x0501) {
-            appendToTransaction(&redoLogRecord[vectorCur]);
+        // The records and members point to the LWN data, so the chunks are handed over together with them
+        for (uint64_t i = 0; i < lwnAllocated; ++i) {
+            lwnDecoded->chunks.push_back(lwnChunks[i]);
+            lwnDecoded->size += ctx->memoryChunkSize;
+        }
+        lwnChunks[0] = ctx->getMemoryChunk("parser", false);
+        lwnAllocated = 1;
+
+        ParserLwn* lwn = lwnDecoded;
+        lwnDecoded = nullptr;
+        producer->push(lwn);
+    }
+
+    void Parser::checkpointLwn(uint64_t lwnConfirmedBlock, uint64_t currentBlock) {
+        if (lwnScn <= metadata->firstDataScn)
+            return;
+
+        if (ctx->trace & TRACE_CHECKPOINT)
+            ctx->logTrace(TRACE_CHECKPOINT, "on: " + std::to_string(lwnScn));
+        typeSeq minSequence = ZERO_SEQ;
+        uint64_t minOffset = -1;
+        typeXid minXid;
+        transactionBuffer->checkpoint(minSequence, minOffset, minXid);
+
+        // Transactions committed before the checkpoint are formatted first, so the position is stored after them
+        if (committer != nullptr) {
+            committer->pushCheckpoint(lwnScn, lwnTimestamp, sequence, currentBlock * reader->getBlockSize(),
+                                      (currentBlock - lwnConfirmedBlock) * reader->getBlockSize(), minSequence, minOffset, minXid);
+        } else {
+            builder->processCheckpoint(lwnScn, lwnTimestamp, sequence, currentBlock * reader->getBlockSize(), false);
+            metadata->checkpoint(lwnScn, lwnTimestamp, sequence,
+                                 currentBlock * reader->getBlockSize(),
+                                 (currentBlock - lwnConfirmedBlock) * reader->getBlockSize(), minSequence,
+                                 minOffset, minXid);
+        }
+
+        if (ctx->stopCheckpoints > 0) {
+            --ctx->stopCheckpoints;
+            if (ctx->stopCheckpoints == 0) {
+                ctx->info(0, "shutdown started - exhausted number of checkpoints");
+                ctx->stopSoft();
+            }
         }
     }
 
@@ -710,8 +963,7 @@ namespace OpenLogReplicator {
         Transaction* transaction = transactionBuffer->findTransaction(redoLogRecord1->xid, redoLogRecord1->conId, false, true,
                                                                       false);
         transaction->begin = true;
-        transaction->firstSequence = sequence;
-        transaction->firstOffset = lwnCheckpointBlock * reader->getBlockSize();
+        transactionBuffer->setFirstPosition(transaction, sequence, lwnCheckpointBlock * reader->getBlockSize());
         transaction->log(ctx, "B   ", redoLogRecord1);
     }
 
@@ -753,6 +1005,15 @@ namespace OpenLogReplicator {
             (transaction->commitScn > metadata->firstSchemaScn && transaction->system)) {
 
             if (transaction->begin) {
+                // System transactions change the schema used by the parser, they are applied when the commit worker is idle
+                if (committer != nullptr && !transaction->system && !transaction->shutdown) {
+                    transactionBuffer->dropTransaction(redoLogRecord1->xid, redoLogRecord1->conId);
+                    committer->pushTransaction(transaction);
+                    return;
+                }
+                if (committer != nullptr)
+                    committer->drain();
+
                 transaction->flush(metadata, transactionBuffer, builder);
 
                 if (ctx->stopTransactions > 0) {
@@ -1138,13 +1399,11 @@ namespace OpenLogReplicator {
 
     uint64_t Parser::parse() {
         uint64_t lwnConfirmedBlock = 2;
-        uint64_t lwnRecords = 0;
 
         if (firstScn == ZERO_SCN && nextScn == ZERO_SCN && reader->getFirstScn() != 0) {
             firstScn = reader->getFirstScn();
             nextScn = reader->getNextScn();
         }
-        ctx->suppLogSize = 0;
 
         if (reader->getBufferStart() == reader->getBlockSize() * 2) {
             if (ctx->dumpRedoLog >= 1) {
@@ -1173,8 +1432,10 @@ namespace OpenLogReplicator {
                               std::to_string(lwnConfirmedBlock) + ")");
             metadata->offset = 0;
         }
-        reader->setBufferStartEnd(lwnConfirmedBlock * reader->getBlockSize(),
-                                  lwnConfirmedBlock * reader->getBlockSize());
+        // Prefetched redo log might be already partially read, decoded redo log is read by the catch-up worker
+        if (worker == nullptr && reader->getBufferStart() != lwnConfirmedBlock * reader->getBlockSize())
+            reader->setBufferStartEnd(lwnConfirmedBlock * reader->getBlockSize(),
+                                      lwnConfirmedBlock * reader->getBlockSize());
 
         ctx->info(0, "processing redo log: " + toString() + " offset: " + std::to_string(reader->getBufferStart()));
         if (FLAG(REDO_FLAGS_ADAPTIVE_SCHEMA) && !metadata->schema->loaded && ctx->versionStr.length() > 0) {
@@ -1195,11 +1456,120 @@ namespace OpenLogReplicator {
         }
 
         time_t cStart = Timer::getTime();
-        reader->setStatusRead();
-        LwnMember* lwnMember;
+        lwnLatencyCount = 0;
+        lwnLatencySum = 0;
+        lwnLatencyMax = 0;
+        memset(reinterpret_cast<void*>(lwnLatencyHistogram), 0, sizeof(lwnLatencyHistogram));
+        memset(reinterpret_cast<void*>(opCodeStats), 0, sizeof(opCodeStats));
+        memset(reinterpret_cast<void*>(&prefilterStats), 0, sizeof(prefilterStats));
+        suppLogSize = 0;
+        uint64_t startBlock = lwnConfirmedBlock;
         uint64_t currentBlock = lwnConfirmedBlock;
+        bool confirmedAll;
+        commitStart();
+        try {
+            if (worker != nullptr) {
+                confirmedAll = applyLwns(lwnConfirmedBlock, currentBlock);
+                // Records were decoded by the catch-up worker, its counters are complete only when it has finished
+                if (worker->isDone())
+                    mergeStats(worker->parser);
+            } else if (ctx->parserPipeline) {
+                reader->setStatusRead();
+                confirmedAll = pipelineLwns(lwnConfirmedBlock, currentBlock);
+            } else {
+                reader->setStatusRead();
+                confirmedAll = readLwns(lwnConfirmedBlock, currentBlock);
+            }
+
+            // Processing finished
+            if (lwnScn > 0 && lwnScn > metadata->firstDataScn && confirmedAll && reader->getRet() == REDO_FINISHED) {
+                if (ctx->trace & TRACE_CHECKPOINT)
+                    ctx->logTrace(TRACE_CHECKPOINT, "on: " + std::to_string(lwnScn) + " with switch");
+                if (committer != nullptr)
+                    committer->pushCheckpoint(lwnScn, lwnTimestamp, sequence, currentBlock * reader->getBlockSize(), true);
+                else
+                    builder->processCheckpoint(lwnScn, lwnTimestamp, sequence, currentBlock * reader->getBlockSize(), true);
+            } else if (ctx->softShutdown) {
+                if (ctx->trace & TRACE_CHECKPOINT)
+                    ctx->logTrace(TRACE_CHECKPOINT, "on: " + std::to_string(lwnScn) + " at exit");
+                if (committer != nullptr)
+                    committer->pushCheckpoint(lwnScn, lwnTimestamp, sequence, currentBlock * reader->getBlockSize(), false);
+                else
+                    builder->processCheckpoint(lwnScn, lwnTimestamp, sequence, currentBlock * reader->getBlockSize(), false);
+            }
+        } catch (...) {
+            commitStop(true);
+            throw;
+        }
+        // The redo log is processed when all its transactions are formatted
+        commitStop(false);
+
+        if (ctx->softShutdown) {
+            reader->setRet(REDO_SHUTDOWN);
+        } else {
+            if (reader->getRet() == REDO_FINISHED && nextScn == ZERO_SCN && reader->getNextScn() != ZERO_SCN)
+                nextScn = reader->getNextScn();
+            if (reader->getRet() == REDO_STOPPED || reader->getRet() == REDO_OVERWRITTEN)
+                metadata->offset = lwnConfirmedBlock * reader->getBlockSize();
+        }
+
+        // Print performance information
+        if ((ctx->trace & TRACE_PERFORMANCE) != 0) {
+            double suppLogPercent = 0.0;
+            if (currentBlock != startBlock)
+                suppLogPercent = 100.0 * suppLogSize / ((currentBlock - startBlock) * reader->getBlockSize());
+
+            if (group == 0) {
+                time_t cEnd = Timer::getTime();
+                double mySpeed = 0;
+                double myTime = (double)(cEnd - cStart) / 1000.0;
+                if (myTime > 0)
+                    mySpeed = (double)(currentBlock - startBlock) * reader->getBlockSize() * 1000.0 / 1024 / 1024 / myTime;
+
+                double myReadSpeed = 0;
+                if (reader->getSumTime() > 0)
+                    myReadSpeed = ((double)reader->getSumRead() * 1000000.0 / 1024 / 1024 / (double)reader->getSumTime());
+
+                ctx->logTrace(TRACE_PERFORMANCE, std::to_string(myTime) + " ms, " +
+                              "Speed: " + std::to_string(mySpeed) + " MB/s, " +
+                              "Redo log size: " + std::to_string((currentBlock - startBlock) * reader->getBlockSize() / 1024 / 1024) + " MB, " +
+                              "Read size: " + std::to_string(reader->getSumRead() / 1024 / 1024) + " MB, " +
+                              "Read speed: " + std::to_string(myReadSpeed) + " MB/s, " +
+                              "Max LWN size: " + std::to_string(lwnAllocatedMax) + ", " +
+                              "Supplemental redo log size: " + std::to_string(suppLogSize) + " bytes " +
+                              "(" + std::to_string(suppLogPercent) + " %)");
+            } else {
+                ctx->logTrace(TRACE_PERFORMANCE,
+                              "Redo log size: " + std::to_string((currentBlock - startBlock) * reader->getBlockSize() / 1024 / 1024) + " MB, " +
+                              "Max LWN size: " + std::to_string(lwnAllocatedMax) + ", " +
+                              "Supplemental redo log size: " + std::to_string(suppLogSize) + " bytes " +
+                              "(" + std::to_string(suppLogPercent) + " %)");
+
+                if (lwnLatencyCount > 0)
+                    ctx->logTrace(TRACE_PERFORMANCE,
+                                  "LWN latency: " + std::to_string(lwnLatencyCount) + " LWNs, " +
+                                  "avg: " + std::to_string(lwnLatencySum / lwnLatencyCount) + " us, " +
+                                  "p50: < " + std::to_string(getLwnLatencyPercentile(50)) + " us, " +
+                                  "p99: < " + std::to_string(getLwnLatencyPercentile(99)) + " us, " +
+                                  "max: " + std::to_string(lwnLatencyMax) + " us");
+            }
+
+            printOpCodeStats();
+        }
+
+        if (ctx->dumpRedoLog >= 1 && ctx->dumpStream.is_open()) {
+            ctx->dumpStream << "END OF REDO DUMP" << std::endl;
+            ctx->dumpStream.close();
+        }
+
+        freeLwn();
+        return reader->getRet();
+    }
+
+    bool Parser::readLwns(uint64_t& lwnConfirmedBlock, uint64_t& currentBlock) {
+        uint64_t lwnRecords = 0;
+        LwnMember* lwnMember;
         uint64_t blockOffset = 16;
-        uint64_t startBlock = lwnConfirmedBlock;
         uint64_t confirmedBufferStart = reader->getBufferStart();
         uint64_t recordLength4 = 0;
         uint64_t recordPos = 0;
@@ -1211,13 +1581,20 @@ namespace OpenLogReplicator {
         uint16_t lwnNumCur = 0;
         uint16_t lwnNumCnt = 0;
         lwnCheckpointBlock = lwnConfirmedBlock;
-        bool switchRedo = false;
+        currentBlock = lwnConfirmedBlock;
 
-        while (!ctx->softShutdown) {
+        // Held buffers must leave enough free buffers for this reader and for prefetching readers
+        uint64_t buffersShared = (ctx->archPrefetch + ctx->archCatchupThreads > 0) ? ctx->readBufferMax / 2 : 0;
+        lwnHeldMax = (ctx->readBufferMax - buffersShared) / 2;
+        if (lwnHeldMax > 0)
+            --lwnHeldMax;
+
+        while (!ctx->softShutdown && (producer == nullptr || !producer->isCancelled())) {
             // There is some work to do
+            PerfScope perfScope(ctx->perfStats, PERF_STAGE_LWN);
             while (confirmedBufferStart < reader->getBufferEnd()) {
-                uint64_t redoBufferPos = (currentBlock * reader->getBlockSize()) % MEMORY_CHUNK_SIZE;
-                uint64_t redoBufferNum = ((currentBlock * reader->getBlockSize()) / MEMORY_CHUNK_SIZE) % ctx->readBufferMax;
+                uint64_t redoBufferPos = (currentBlock * reader->getBlockSize()) % ctx->memoryChunkSize;
+                uint64_t redoBufferNum = ((currentBlock * reader->getBlockSize()) / ctx->memoryChunkSize) % ctx->readBufferMax;
                 uint8_t* redoBlock = reader->redoBufferList[redoBufferNum] + redoBufferPos;
 
                 blockOffset = 16;
@@ -1263,24 +1640,9 @@ namespace OpenLogReplicator {
 
                         recordLength4 = (static_cast<uint64_t>(ctx->read32(redoBlock + blockOffset)) + 3) & 0xFFFFFFFC;
                         if (recordLength4 > 0) {
-                            uint64_t* length = reinterpret_cast<uint64_t*>(lwnChunks[lwnAllocated - 1]);
-
-                            if (((*length + sizeof(struct LwnMember) + recordLength4 + 7) & 0xFFFFFFF8) > MEMORY_CHUNK_SIZE_MB * 1024 * 1024) {
-                                if (lwnAllocated == MAX_LWN_CHUNKS)
-                                    throw RedoLogException(50052, "all " + std::to_string(MAX_LWN_CHUNKS) + " lwn buffers allocated");
-
-                                lwnChunks[lwnAllocated++] = ctx->getMemoryChunk("parser", false);
-                                if (lwnAllocated > lwnAllocatedMax)
-                                    lwnAllocatedMax = lwnAllocated;
-                                length = reinterpret_cast<uint64_t*>(lwnChunks[lwnAllocated - 1]);
-                                *length = sizeof(uint64_t);
-                            }
-
-                            if (((*length + sizeof(struct LwnMember) + recordLength4 + 7) & 0xFFFFFFF8) > MEMORY_CHUNK_SIZE_MB * 1024 * 1024)
-                                throw RedoLogException(50053, "too big redo log record, length: " + std::to_string(recordLength4));
-
-                            lwnMember = reinterpret_cast<struct LwnMember*>(lwnChunks[lwnAllocated - 1] + *length);
-                            *length += (sizeof(struct LwnMember) + recordLength4 + 7) & 0xFFFFFFF8;
+                            // Record inside one block is referenced in the read buffer, it is copied only when it spans blocks
+                            bool inPlace = (producer == nullptr && blockOffset + recordLength4 <= reader->getBlockSize());
+                            lwnMember = allocateLwn(inPlace ? 0 : recordLength4);
                             lwnMember->scn = ctx->read32(redoBlock + blockOffset + 8) |
                                              (static_cast<uint64_t>(ctx->read16(redoBlock + blockOffset + 6)) << 32);
                             lwnMember->subScn = ctx->read16(redoBlock + blockOffset + 12);
@@ -1294,14 +1656,15 @@ namespace OpenLogReplicator {
                             uint64_t lwnPos = lwnRecords++;
                             if (lwnPos >= MAX_RECORDS_IN_LWN)
                                 throw RedoLogException(50054, "all " + std::to_string(lwnPos) + " records in lwn were used");
+                            // Sorted when the LWN is complete
+                            lwnMembers[lwnPos] = lwnMember;
 
-                            while (lwnPos > 0 &&
-                                   (lwnMembers[lwnPos - 1]->scn > lwnMember->scn ||
-                                    (lwnMembers[lwnPos - 1]->scn == lwnMember->scn && lwnMembers[lwnPos - 1]->subScn > lwnMember->subScn))) {
-                                lwnMembers[lwnPos] = lwnMembers[lwnPos - 1];
-                                --lwnPos;
+                            if (inPlace) {
+                                lwnMember->data = redoBlock + blockOffset;
+                                ++lwnInPlace;
+                                blockOffset += recordLength4;
+                                continue;
                             }
-                            lwnMembers[lwnPos] = lwnMember;
                         }
 
                         recordLeftToCopy = recordLength4;
@@ -1318,7 +1681,7 @@ namespace OpenLogReplicator {
                     else
                         toCopy = recordLeftToCopy;
 
-                    memcpy(reinterpret_cast<void*>(reinterpret_cast<uint8_t*>(lwnMember) + sizeof(struct LwnMember) + recordPos),
+                    memcpy(reinterpret_cast<void*>(lwnMember->data + recordPos),
                            reinterpret_cast<const void*>(redoBlock + blockOffset), toCopy);
                     recordLeftToCopy -= toCopy;
                     blockOffset += toCopy;
@@ -1336,39 +1699,23 @@ namespace OpenLogReplicator {
                 if (currentBlock == lwnEndBlock && lwnNumCnt == lwnNumMax) {
                     if (ctx->trace & TRACE_LWN)
                         ctx->logTrace(TRACE_LWN, "analyze");
-                    for (uint64_t i = 0; i < lwnRecords; ++i) {
-                        try {
-                            analyzeLwn(lwnMembers[i]);
-                        } catch (RedoLogException &ex) {
-                            if (FLAG(REDO_FLAGS_IGNORE_DATA_ERRORS)) {
-                                ctx->error(ex.code, ex.msg);
-                                ctx->warning(60013, "forced to continue working in spite of error");
-                            } else
-                                throw RedoLogException(ex.code, "runtime error, aborting further redo log processing: " + ex.msg);
-                        }
-                    }
-
-                    if (lwnScn > metadata->firstDataScn) {
-                        if (ctx->trace & TRACE_CHECKPOINT)
-                            ctx->logTrace(TRACE_CHECKPOINT, "on: " + std::to_string(lwnScn));
-                        builder->processCheckpoint(lwnScn, lwnTimestamp, sequence, currentBlock * reader->getBlockSize(), switchRedo);
-
-                        typeSeq minSequence = ZERO_SEQ;
-                        uint64_t minOffset = -1;
-                        typeXid minXid;
-                        transactionBuffer->checkpoint(minSequence, minOffset, minXid);
-                        metadata->checkpoint(lwnScn, lwnTimestamp, sequence,
-                                             currentBlock * reader->getBlockSize(),
-                                             (currentBlock - lwnConfirmedBlock) * reader->getBlockSize(), minSequence,
-                                             minOffset, minXid);
-
-                        if (ctx->stopCheckpoints > 0) {
-                            --ctx->stopCheckpoints;
-                            if (ctx->stopCheckpoints == 0) {
-                                ctx->info(0, "shutdown started - exhausted number of checkpoints");
-                                ctx->stopSoft();
+                    if (ctx->perfStats != nullptr)
+                        ctx->perfStats->add(PERF_STAGE_LWN, (currentBlock - lwnConfirmedBlock) * reader->getBlockSize(), lwnRecords);
+                    if (group != 0 && (ctx->trace & TRACE_PERFORMANCE) != 0)
+                        updateLwnLatency();
+                    sortLwn(lwnRecords);
+                    if (producer != nullptr)
+                        decodeLwn(lwnRecords, currentBlock);
+                    else {
+                        for (uint64_t i = 0; i < lwnRecords; ++i) {
+                            try {
+                                analyzeLwn(lwnMembers[i]);
+                            } catch (RedoLogException &ex) {
+                                analyzeError(ex);
                             }
                         }
+
+                        checkpointLwn(lwnConfirmedBlock, currentBlock);
                     }
 
                     lwnNumCnt = 0;
@@ -1379,82 +1726,154 @@ namespace OpenLogReplicator {
                     throw RedoLogException(50055, "lwn overflow: " + std::to_string(lwnNumCnt) + "/" + std::to_string(lwnNumMax));
 
                 // Free memory
-                if (redoBufferPos == MEMORY_CHUNK_SIZE) {
+                if (redoBufferPos == ctx->memoryChunkSize) {
                     redoBufferPos = 0;
-                    reader->bufferFree(redoBufferNum);
+                    if (lwnInPlace > 0) {
+                        // Records of the LWN are referenced in the buffer, it is released after the LWN is analyzed
+                        lwnHeld.push_back(reader->bufferHold(redoBufferNum));
+                        if (lwnHeld.size() > lwnHeldMax)
+                            materializeLwn(lwnRecords);
+                    } else
+                        reader->bufferFree(redoBufferNum);
                     if (++redoBufferNum == ctx->readBufferMax)
                         redoBufferNum = 0;
                     reader->confirmReadData(confirmedBufferStart);
                 }
             }
+            perfScope.stop();
 
-            // Processing finished
-            if (!switchRedo && lwnScn > 0 && lwnScn > metadata->firstDataScn &&
-                    confirmedBufferStart == reader->getBufferEnd() && reader->getRet() == REDO_FINISHED) {
-                switchRedo = true;
-                if (ctx->trace & TRACE_CHECKPOINT)
-                    ctx->logTrace(TRACE_CHECKPOINT, "on: " + std::to_string(lwnScn) + " with switch");
-                builder->processCheckpoint(lwnScn, lwnTimestamp, sequence, currentBlock * reader->getBlockSize(), switchRedo);
-            } else if (ctx->softShutdown) {
-                if (ctx->trace & TRACE_CHECKPOINT)
-                    ctx->logTrace(TRACE_CHECKPOINT, "on: " + std::to_string(lwnScn) + " at exit");
-                builder->processCheckpoint(lwnScn, lwnTimestamp, sequence, currentBlock * reader->getBlockSize(), false);
-            }
+            if (ctx->softShutdown || (producer != nullptr && producer->isCancelled()))
+                break;
 
-            if (ctx->softShutdown) {
-                reader->setRet(REDO_SHUTDOWN);
-            } else {
-                if (reader->checkFinished(confirmedBufferStart)) {
-                    if (reader->getRet() == REDO_FINISHED && nextScn == ZERO_SCN && reader->getNextScn() != ZERO_SCN)
-                        nextScn = reader->getNextScn();
-                    if (reader->getRet() == REDO_STOPPED || reader->getRet() == REDO_OVERWRITTEN)
-                        metadata->offset = lwnConfirmedBlock * reader->getBlockSize();
-                    break;
-                }
-            }
+            if (reader->checkFinished(confirmedBufferStart))
+                break;
         }
 
-        // Print performance information
-        if ((ctx->trace & TRACE_PERFORMANCE) != 0) {
-            double suppLogPercent = 0.0;
-            if (currentBlock != startBlock)
-                suppLogPercent = 100.0 * ctx->suppLogSize / ((currentBlock - startBlock) * reader->getBlockSize());
+        return confirmedBufferStart == reader->getBufferEnd();
+    }
 
-            if (group == 0) {
-                time_t cEnd = Timer::getTime();
-                double mySpeed = 0;
-                double myTime = (double)(cEnd - cStart) / 1000.0;
-                if (myTime > 0)
-                    mySpeed = (double)(currentBlock - startBlock) * reader->getBlockSize() * 1000.0 / 1024 / 1024 / myTime;
+    bool Parser::applyLwns(uint64_t& lwnConfirmedBlock, uint64_t& currentBlock) {
+        while (!ctx->softShutdown) {
+            ParserLwn* lwn = worker->pop();
+            if (lwn == nullptr)
+                break;
 
-                double myReadSpeed = 0;
-                if (reader->getSumTime() > 0)
-                    myReadSpeed = ((double)reader->getSumRead() * 1000000.0 / 1024 / 1024 / (double)reader->getSumTime());
+            lwnScn = lwn->scn;
+            lwnTimestamp = lwn->timestamp;
+            lwnCheckpointBlock = lwn->checkpointBlock;
+            currentBlock = lwn->block;
+
+            uint64_t memberSkip = -1;
+            try {
+                for (LwnMember* lwnMember : lwn->members) {
+                    try {
+                        analyzeLwn(lwnMember);
+                    } catch (RedoLogException &ex) {
+                        analyzeError(ex);
+                    }
+                }
 
-                ctx->logTrace(TRACE_PERFORMANCE, std::to_string(myTime) + " ms, " +
-                              "Speed: " + std::to_string(mySpeed) + " MB/s, " +
-                              "Redo log size: " + std::to_string((currentBlock - startBlock) * reader->getBlockSize() / 1024 / 1024) + " MB, " +
-                              "Read size: " + std::to_string(reader->getSumRead() / 1024 / 1024) + " MB, " +
-                              "Read speed: " + std::to_string(myReadSpeed) + " MB/s, " +
-                              "Max LWN size: " + std::to_string(lwnAllocatedMax) + ", " +
-                              "Supplemental redo log size: " + std::to_string(ctx->suppLogSize) + " bytes " +
-                              "(" + std::to_string(suppLogPercent) + " %)");
-            } else {
-                ctx->logTrace(TRACE_PERFORMANCE,
-                              "Redo log size: " + std::to_string((currentBlock - startBlock) * reader->getBlockSize() / 1024 / 1024) + " MB, " +
-                              "Max LWN size: " + std::to_string(lwnAllocatedMax) + ", " +
-                              "Supplemental redo log size: " + std::to_string(ctx->suppLogSize) + " bytes " +
-                              "(" + std::to_string(suppLogPercent) + " %)");
+                for (ParserRecord& parserRecord : lwn->records) {
+                    if (parserRecord.member == memberSkip)
+                        continue;
+
+                    try {
+                        if (parserRecord.type == PARSER_RECORD_ERROR)
+                            throw lwn->errors[parserRecord.error];
+                        applyRecord(parserRecord.type, &parserRecord.redoLogRecord1, &parserRecord.redoLogRecord2);
+                    } catch (RedoLogException &ex) {
+                        // Like in serial parsing, the rest of the LWN member is skipped
+                        memberSkip = parserRecord.member;
+                        analyzeError(ex);
+                    }
+                }
+            } catch (...) {
+                worker->freeLwn(lwn);
+                throw;
             }
+            worker->freeLwn(lwn);
+
+            checkpointLwn(lwnConfirmedBlock, currentBlock);
+            lwnConfirmedBlock = currentBlock;
         }
 
-        if (ctx->dumpRedoLog >= 1 && ctx->dumpStream.is_open()) {
-            ctx->dumpStream << "END OF REDO DUMP" << std::endl;
-            ctx->dumpStream.close();
+        return worker->finish();
+    }
+
+    bool Parser::pipelineLwns(uint64_t& lwnConfirmedBlock, uint64_t& currentBlock) {
+        // Second parser reads the blocks and sorts the LWNs in a separate thread, this one analyzes them and appends to transactions
+        auto parserAssembler = new Parser(ctx, builder, metadata, transactionBuffer, group, path);
+        parserAssembler->sequence = sequence;
+        parserAssembler->firstScn = firstScn;
+        parserAssembler->nextScn = nextScn;
+        parserAssembler->reader = reader;
+        uint64_t lwnsSizeMax = (ctx->readBufferMax / 2) * ctx->memoryChunkSize;
+        if (lwnsSizeMax < ctx->memoryChunkSize)
+            lwnsSizeMax = ctx->memoryChunkSize;
+        worker = new ParserWorker(ctx, "parser-" + std::to_string(sequence), parserAssembler, lwnsSizeMax, lwnConfirmedBlock, false);
+
+        bool confirmedAll;
+        try {
+            ctx->spawnThread(worker);
+            confirmedAll = applyLwns(lwnConfirmedBlock, currentBlock);
+        } catch (...) {
+            pipelineStop();
+            throw;
         }
+        pipelineStop();
+        return confirmedAll;
+    }
 
-        freeLwn();
-        return reader->getRet();
+    void Parser::pipelineStop() {
+        worker->cancel();
+        ctx->finishThread(worker);
+
+        // Statistics of the reading stage
+        Parser* parserAssembler = worker->parser;
+        if (parserAssembler->lwnAllocatedMax > lwnAllocatedMax)
+            lwnAllocatedMax = parserAssembler->lwnAllocatedMax;
+        lwnLatencyCount += parserAssembler->lwnLatencyCount;
+        lwnLatencySum += parserAssembler->lwnLatencySum;
+        if (parserAssembler->lwnLatencyMax > lwnLatencyMax)
+            lwnLatencyMax = parserAssembler->lwnLatencyMax;
+        for (uint64_t i = 0; i < LWN_LATENCY_BUCKETS; ++i)
+            lwnLatencyHistogram[i] += parserAssembler->lwnLatencyHistogram[i];
+
+        delete worker;
+        worker = nullptr;
+    }
+
+    void Parser::commitStart() {
+        // Debug shutdown after a number of transactions is decided by the formatting, so it stays on the parser thread
+        if (ctx->commitQueueMb == 0 || ctx->stopTransactions > 0)
+            return;
+
+        committer = new CommitWorker(ctx, "commit-" + std::to_string(sequence), builder, metadata, transactionBuffer,
+                                     ctx->commitQueueMb * 1024 * 1024);
+        try {
+            ctx->spawnThread(committer);
+        } catch (...) {
+            delete committer;
+            committer = nullptr;
+            throw;
+        }
+    }
+
+    void Parser::commitStop(bool cancel) {
+        if (committer == nullptr)
+            return;
+
+        if (cancel)
+            committer->cancel();
+        else
+            committer->finish();
+        ctx->finishThread(committer);
+
+        std::exception_ptr exception = committer->getException();
+        delete committer;
+        committer = nullptr;
+        if (exception && !cancel)
+            std::rethrow_exception(exception);
     }
 
     std::string Parser::toString() {
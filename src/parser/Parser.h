@@ -17,7 +17,10 @@ You should have received a copy of the GNU General Public License
 along with OpenLogReplicator; see the file LICENSE;  If not see
 <http://www.gnu.org/licenses/>.  */
 
+#include <vector>
+
 #include "../common/Ctx.h"
+#include "../common/RedoLogException.h"
 #include "../common/RedoLogRecord.h"
 #include "../common/types.h"
 #include "../common/typeTime.h"
@@ -26,15 +29,33 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #ifndef PARSER_H_
 #define PARSER_H_
 
-#define MAX_LWN_CHUNKS (512*2/MEMORY_CHUNK_SIZE_MB)
+#define MAX_LWN_CHUNKS (512*2)
+#define LWN_LATENCY_BUCKETS 32
+
+#define PARSER_RECORD_ERROR                     0
+#define PARSER_RECORD_DDL                       1
+#define PARSER_RECORD_BEGIN                     2
+#define PARSER_RECORD_COMMIT                    3
+#define PARSER_RECORD_LOB                       4
+#define PARSER_RECORD_INDEX                     5
+#define PARSER_RECORD_UNDO                      6
+#define PARSER_RECORD_ROLLBACK                  7
+#define PARSER_RECORD_DML                       8
+#define PARSER_RECORD_DML_ROLLBACK              9
+#define PARSER_RECORD_NONE                      10
+
+#define PARSER_OPCODES                          27
 
 namespace OpenLogReplicator {
     class Builder;
+    class CommitWorker;
     class Reader;
     class Metadata;
+    class ParserWorker;
     class TransactionBuffer;
 
     struct LwnMember {
+        uint8_t* data;
         uint64_t offset;
         uint64_t length;
         typeScn scn;
@@ -42,6 +63,44 @@ namespace OpenLogReplicator {
         typeBlk block;
     };
 
+    // Dispatch table entry, opcode 0 is a catch-all entry for the whole layer
+    struct ParserOpCode {
+        typeOp2 opCode;
+        void (*process)(Ctx* ctx, RedoLogRecord* redoLogRecord);
+        bool undoLink;
+        uint64_t undoRecord;
+        uint64_t record;
+        bool rollback;
+    };
+
+    struct ParserOpCodeStats {
+        uint64_t count;
+        uint64_t bytes;
+        uint64_t timeNs;
+    };
+
+    // Decoded redo record waiting to be appended to the transaction buffer
+    struct ParserRecord {
+        uint64_t type;
+        uint64_t member;
+        uint64_t error;
+        RedoLogRecord redoLogRecord1;
+        RedoLogRecord redoLogRecord2;
+    };
+
+    // LWN passed from a worker to the ordered stage: decoded by a catch-up worker or only sorted by the parser pipeline
+    struct ParserLwn {
+        std::vector<uint8_t*> chunks;
+        std::vector<LwnMember*> members;
+        std::vector<ParserRecord> records;
+        std::vector<RedoLogException> errors;
+        uint64_t size;
+        typeScn scn;
+        typeTime timestamp;
+        uint64_t checkpointBlock;
+        uint64_t block;
+    };
+
     class Parser {
     protected:
         Ctx* ctx;
@@ -54,12 +113,51 @@ namespace OpenLogReplicator {
         LwnMember* lwnMembers[MAX_RECORDS_IN_LWN];
         uint64_t lwnAllocated;
         uint64_t lwnAllocatedMax;
+        uint64_t lwnInPlace;
+        uint64_t lwnHeldMax;
+        std::vector<uint8_t*> lwnHeld;
+        std::vector<uint64_t> lwnRuns;
         typeTime lwnTimestamp;
         typeScn lwnScn;
         uint64_t lwnCheckpointBlock;
+        ParserWorker* producer;
+        CommitWorker* committer;
+        ParserLwn* lwnDecoded;
+        uint64_t lwnDecodedMember;
+        uint64_t lwnLatencyCount;
+        uint64_t lwnLatencySum;
+        uint64_t lwnLatencyMax;
+        uint64_t lwnLatencyHistogram[LWN_LATENCY_BUCKETS];
+        ParserOpCodeStats opCodeStats[PARSER_OPCODES];
+        ParserOpCodeStats prefilterStats;
+        uint64_t suppLogSize;
+
+        static const ParserOpCode opCodes[PARSER_OPCODES];
+        static uint8_t opCodeMap[0x10000];
+        static void initializeOpCodes();
 
         void freeLwn();
+        [[nodiscard]] LwnMember* allocateLwn(uint64_t recordLength4);
+        void materializeLwn(uint64_t lwnRecords);
+        void releaseLwn();
+        void sortLwn(uint64_t lwnRecords);
+        void updateLwnLatency();
+        [[nodiscard]] uint64_t getLwnLatencyPercentile(uint64_t percent) const;
+        void printOpCodeStats() const;
+        void mergeStats(const Parser* parser);
+        [[nodiscard]] uint64_t prefilterDml(const RedoLogRecord* redoLogRecord, const uint8_t* data, uint64_t offset, uint64_t recordLength) const;
         void analyzeLwn(LwnMember* lwnMember);
+        void analyzeError(const RedoLogException& ex);
+        void decodeLwn(uint64_t lwnRecords, uint64_t currentBlock);
+        void checkpointLwn(uint64_t lwnConfirmedBlock, uint64_t currentBlock);
+        bool readLwns(uint64_t& lwnConfirmedBlock, uint64_t& currentBlock);
+        bool applyLwns(uint64_t& lwnConfirmedBlock, uint64_t& currentBlock);
+        bool pipelineLwns(uint64_t& lwnConfirmedBlock, uint64_t& currentBlock);
+        void pipelineStop();
+        void commitStart();
+        void commitStop(bool cancel);
+        void appendRecord(uint64_t type, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2);
+        void applyRecord(uint64_t type, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2);
         void appendToTransactionDdl(RedoLogRecord* redoLogRecord1);
         void appendToTransactionBegin(RedoLogRecord* redoLogRecord1);
         void appendToTransactionCommit(RedoLogRecord* redoLogRecord1);
@@ -78,12 +176,15 @@ namespace OpenLogReplicator {
         typeScn firstScn;
         typeScn nextScn;
         Reader* reader;
+        ParserWorker* worker;
 
         Parser(Ctx* newCtx, Builder* newBuilder, Metadata* newMetadata, TransactionBuffer* newTransactionBuffer, int64_t newGroup, const std::string& newPath);
         virtual ~Parser();
 
         uint64_t parse();
         std::string toString();
+
+        friend class ParserWorker;
     };
 }
 
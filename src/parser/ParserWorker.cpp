@@ -0,0 +1,187 @@
+/* Thread decoding archived redo log ahead of the ordered stage
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <thread>
+
+#include "../common/RuntimeException.h"
+#include "../reader/Reader.h"
+#include "Parser.h"
+#include "ParserWorker.h"
+
+namespace OpenLogReplicator {
+    ParserWorker::ParserWorker(Ctx* newCtx, const std::string& newAlias, Parser* newParser, uint64_t newLwnsSizeMax, uint64_t newStartBlock,
+                               bool newDecode) :
+            Thread(newCtx, newAlias),
+            ring{},
+            ringHead(0),
+            ringTail(0),
+            lwnsSize(0),
+            lwnsSizeMax(newLwnsSizeMax),
+            startBlock(newStartBlock),
+            waitingFull(false),
+            waitingEmpty(false),
+            cancelled(false),
+            done(false),
+            confirmedAll(false),
+            parser(newParser),
+            decode(newDecode) {
+        parser->producer = this;
+    }
+
+    ParserWorker::~ParserWorker() {
+        while (ringHead != ringTail) {
+            ParserLwn* lwn = ring[ringHead % PARSER_WORKER_RING];
+            ++ringHead;
+            freeLwn(lwn);
+        }
+
+        delete parser;
+        parser = nullptr;
+    }
+
+    void ParserWorker::wakeUp() {
+        std::unique_lock<std::mutex> lck(mtx);
+        condLwnFull.notify_all();
+        condLwnEmpty.notify_all();
+    }
+
+    void ParserWorker::cancel() {
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            cancelled = true;
+            condLwnFull.notify_all();
+            condLwnEmpty.notify_all();
+        }
+        // The worker might wait for the reader
+        parser->reader->wakeUp();
+    }
+
+    bool ParserWorker::isCancelled() const {
+        return cancelled;
+    }
+
+    bool ParserWorker::isDone() const {
+        return done;
+    }
+
+    bool ParserWorker::isFull(uint64_t size) const {
+        // At least one LWN is always accepted, even if it is bigger than the limit
+        return ringTail - ringHead == PARSER_WORKER_RING || (lwnsSize > 0 && lwnsSize + size > lwnsSizeMax);
+    }
+
+    void ParserWorker::push(ParserLwn* lwn) {
+        while (isFull(lwn->size) && !cancelled && !ctx->softShutdown) {
+            std::unique_lock<std::mutex> lck(mtx);
+            // Set before the check, the consumer notifies only when it sees the flag after freeing space
+            waitingFull = true;
+            if (isFull(lwn->size) && !cancelled && !ctx->softShutdown)
+                condLwnFull.wait(lck);
+            waitingFull = false;
+        }
+
+        if (cancelled || ctx->softShutdown) {
+            freeLwn(lwn);
+            return;
+        }
+
+        uint64_t tail = ringTail.load(std::memory_order_relaxed);
+        ring[tail % PARSER_WORKER_RING] = lwn;
+        lwnsSize += lwn->size;
+        // Sequentially consistent, it must be visible before the check of the waiting flag
+        ringTail = tail + 1;
+
+        if (waitingEmpty) {
+            std::unique_lock<std::mutex> lck(mtx);
+            condLwnEmpty.notify_all();
+        }
+    }
+
+    ParserLwn* ParserWorker::pop() {
+        while (ringHead == ringTail && !done && !ctx->softShutdown) {
+            std::unique_lock<std::mutex> lck(mtx);
+            waitingEmpty = true;
+            if (ringHead == ringTail && !done && !ctx->softShutdown)
+                condLwnEmpty.wait(lck);
+            waitingEmpty = false;
+        }
+
+        uint64_t head = ringHead.load(std::memory_order_relaxed);
+        if (head == ringTail.load(std::memory_order_acquire))
+            return nullptr;
+
+        ParserLwn* lwn = ring[head % PARSER_WORKER_RING];
+        lwnsSize -= lwn->size;
+        ringHead = head + 1;
+
+        if (waitingFull) {
+            std::unique_lock<std::mutex> lck(mtx);
+            condLwnFull.notify_all();
+        }
+        return lwn;
+    }
+
+    void ParserWorker::freeLwn(ParserLwn* lwn) {
+        for (uint8_t* chunk : lwn->chunks)
+            ctx->freeMemoryChunk("parser", chunk, false);
+        delete lwn;
+    }
+
+    bool ParserWorker::finish() {
+        std::unique_lock<std::mutex> lck(mtx);
+        if (exception)
+            std::rethrow_exception(exception);
+        return done && confirmedAll && ringHead == ringTail;
+    }
+
+    void ParserWorker::run() {
+        if (ctx->trace & TRACE_THREADS) {
+            std::ostringstream ss;
+            ss << std::this_thread::get_id();
+            ctx->logTrace(TRACE_THREADS, "parser worker (" + ss.str() + ") start");
+        }
+
+        bool confirmedAllTmp = false;
+        std::exception_ptr exceptionTmp;
+        try {
+            uint64_t lwnConfirmedBlock = startBlock;
+            uint64_t currentBlock = lwnConfirmedBlock;
+            confirmedAllTmp = parser->readLwns(lwnConfirmedBlock, currentBlock);
+        } catch (RedoLogException&) {
+            exceptionTmp = std::current_exception();
+        } catch (RuntimeException&) {
+            exceptionTmp = std::current_exception();
+        } catch (std::bad_alloc& ex) {
+            exceptionTmp = std::make_exception_ptr(RuntimeException(10018, "memory allocation failed: " + std::string(ex.what())));
+        }
+
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            confirmedAll = confirmedAllTmp;
+            exception = exceptionTmp;
+            done = true;
+            condLwnEmpty.notify_all();
+        }
+
+        if (ctx->trace & TRACE_THREADS) {
+            std::ostringstream ss;
+            ss << std::this_thread::get_id();
+            ctx->logTrace(TRACE_THREADS, "parser worker (" + ss.str() + ") stop");
+        }
+    }
+}
@@ -0,0 +1,76 @@
+/* Header for ParserWorker class
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+#include "../common/Thread.h"
+
+#ifndef PARSER_WORKER_H_
+#define PARSER_WORKER_H_
+
+#define PARSER_WORKER_RING                      256
+
+namespace OpenLogReplicator {
+    class Parser;
+    struct ParserLwn;
+
+    class ParserWorker : public Thread {
+    protected:
+        // Single producer, single consumer ring, the mutex is only used to sleep when the ring is empty or full
+        std::mutex mtx;
+        std::condition_variable condLwnFull;
+        std::condition_variable condLwnEmpty;
+        ParserLwn* ring[PARSER_WORKER_RING];
+        std::atomic<uint64_t> ringHead;
+        std::atomic<uint64_t> ringTail;
+        std::atomic<uint64_t> lwnsSize;
+        uint64_t lwnsSizeMax;
+        uint64_t startBlock;
+        std::atomic<bool> waitingFull;
+        std::atomic<bool> waitingEmpty;
+        std::atomic<bool> cancelled;
+        std::atomic<bool> done;
+        bool confirmedAll;
+        std::exception_ptr exception;
+
+        [[nodiscard]] bool isFull(uint64_t size) const;
+        void run() override;
+
+    public:
+        Parser* parser;
+        bool decode;
+
+        ParserWorker(Ctx* newCtx, const std::string& newAlias, Parser* newParser, uint64_t newLwnsSizeMax, uint64_t newStartBlock, bool newDecode);
+        ~ParserWorker() override;
+
+        void wakeUp() override;
+        void cancel();
+        [[nodiscard]] bool isCancelled() const;
+        [[nodiscard]] bool isDone() const;
+        void push(ParserLwn* lwn);
+        ParserLwn* pop();
+        void freeLwn(ParserLwn* lwn);
+        bool finish();
+    };
+}
+
+#endif
@@ -23,6 +23,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include "../common/LobCtx.h"
 #include "../common/OracleLob.h"
 #include "../common/OracleTable.h"
+#include "../common/PerfStats.h"
 #include "../common/RedoLogException.h"
 #include "../common/RedoLogRecord.h"
 #include "../metadata/Metadata.h"
@@ -32,7 +33,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include "TransactionBuffer.h"
 
 namespace OpenLogReplicator {
-    Transaction::Transaction(typeXid newXid, std::map<LobKey, uint8_t*>* newOrphanedLobs) :
+    Transaction::Transaction(typeXid newXid, std::map<LobKey, uint8_t*>* newOrphanedLobs, std::mutex* newOrphanedLobsMtx) :
         deallocTc(nullptr),
         opCodes(0),
         mergeBuffer(nullptr),
@@ -43,6 +44,7 @@ namespace OpenLogReplicator {
         commitScn(0),
         firstTc(nullptr),
         lastTc(nullptr),
+        spill(nullptr),
         commitTimestamp(0),
         begin(false),
         rollback(false),
@@ -53,15 +55,22 @@ namespace OpenLogReplicator {
         dump(false),
         size(0) {
         lobCtx.orphanedLobs = newOrphanedLobs;
+        lobCtx.orphanedLobsMtx = newOrphanedLobsMtx;
     }
 
     void Transaction::add(Metadata* metadata, TransactionBuffer* transactionBuffer, RedoLogRecord* redoLogRecord1) {
+        PerfScope perfScope(metadata->ctx->perfStats, PERF_STAGE_TRANSACTION);
+        if (metadata->ctx->perfStats != nullptr)
+            metadata->ctx->perfStats->add(PERF_STAGE_TRANSACTION, redoLogRecord1->length, 1);
         log(metadata->ctx, "add ", redoLogRecord1);
         transactionBuffer->addTransactionChunk(this, redoLogRecord1);
         ++opCodes;
     }
 
     void Transaction::add(Metadata* metadata, TransactionBuffer* transactionBuffer, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2) {
+        PerfScope perfScope(metadata->ctx->perfStats, PERF_STAGE_TRANSACTION);
+        if (metadata->ctx->perfStats != nullptr)
+            metadata->ctx->perfStats->add(PERF_STAGE_TRANSACTION, redoLogRecord1->length + redoLogRecord2->length, 1);
         log(metadata->ctx, "add1", redoLogRecord1);
         log(metadata->ctx, "add2", redoLogRecord2);
         transactionBuffer->addTransactionChunk(this, redoLogRecord1, redoLogRecord2);
@@ -74,9 +83,11 @@ namespace OpenLogReplicator {
         log(ctx, "rlb2", redoLogRecord2);
 
         while (lastTc != nullptr && lastTc->size > 0 && opCodes > 0) {
-            uint64_t lengthLast = *(reinterpret_cast<uint64_t*>(lastTc->buffer + lastTc->size - ROW_HEADER_TOTAL + ROW_HEADER_SIZE));
-            //auto lastRedoLogRecord1 = reinterpret_cast<RedoLogRecord*>(lastTc->buffer + lastTc->size - lengthLast + ROW_HEADER_REDO1);
-            auto lastRedoLogRecord2 = reinterpret_cast<RedoLogRecord*>(lastTc->buffer + lastTc->size - lengthLast + ROW_HEADER_REDO2);
+            typeOp2 lastOp;
+            RedoLogRecord lastRecord1;
+            RedoLogRecord lastRecord2;
+            TransactionBuffer::unpackRow(lastTc->buffer + lastTc->size - TransactionBuffer::lastRowLength(lastTc), lastOp, &lastRecord1, &lastRecord2);
+            const RedoLogRecord* lastRedoLogRecord2 = &lastRecord2;
 
             bool ok = false;
             switch (lastRedoLogRecord2->opCode) {
@@ -145,9 +156,12 @@ namespace OpenLogReplicator {
         log(metadata->ctx, "rlb ", redoLogRecord1);
 
         while (lastTc != nullptr && lastTc->size > 0 && opCodes > 0) {
-            uint64_t lengthLast = *(reinterpret_cast<uint64_t*>(lastTc->buffer + lastTc->size - ROW_HEADER_TOTAL + ROW_HEADER_SIZE));
-            auto lastRedoLogRecord1 = reinterpret_cast<RedoLogRecord*>(lastTc->buffer + lastTc->size - lengthLast + ROW_HEADER_REDO1);
-            auto lastRedoLogRecord2 = reinterpret_cast<RedoLogRecord*>(lastTc->buffer + lastTc->size - lengthLast + ROW_HEADER_REDO2);
+            typeOp2 lastOp;
+            RedoLogRecord lastRecord1;
+            RedoLogRecord lastRecord2;
+            TransactionBuffer::unpackRow(lastTc->buffer + lastTc->size - TransactionBuffer::lastRowLength(lastTc), lastOp, &lastRecord1, &lastRecord2);
+            const RedoLogRecord* lastRedoLogRecord1 = &lastRecord1;
+            const RedoLogRecord* lastRedoLogRecord2 = &lastRecord2;
 
             bool ok = false;
             switch (lastRedoLogRecord2->opCode) {
@@ -187,6 +201,7 @@ namespace OpenLogReplicator {
     }
 
     void Transaction::flush(Metadata* metadata, TransactionBuffer* transactionBuffer, Builder* builder) {
+        PerfScope perfScope(metadata->ctx->perfStats, PERF_STAGE_TRANSACTION);
         bool opFlush = false;
         deallocTc = nullptr;
         uint64_t maxMessageMb = builder->getMaxMessageMb();
@@ -205,6 +220,7 @@ namespace OpenLogReplicator {
             builder->systemTransaction = new SystemTransaction(builder, metadata);
         }
         builder->processBegin(commitScn, commitTimestamp, commitSequence, xid);
+        transactionBuffer->releaseFlushRecords();
 
         uint64_t pos;
         uint64_t type = 0;
@@ -213,20 +229,22 @@ namespace OpenLogReplicator {
         RedoLogRecord* last1 = nullptr;
         RedoLogRecord* last2 = nullptr;
 
+        // Spilled chunks are older than the chunks in memory
         TransactionChunk* tc = firstTc;
+        if (spill != nullptr && spill->read < spill->chunks.size())
+            tc = transactionBuffer->readSpilledChunk(this, firstTc);
+
         while (tc != nullptr) {
             pos = 0;
             for (uint64_t i = 0; i < tc->elements; ++i) {
-                typeOp2 op = *(reinterpret_cast<typeOp2*>(tc->buffer + pos));
-
-                RedoLogRecord* redoLogRecord1 = reinterpret_cast<RedoLogRecord*>(tc->buffer + pos + ROW_HEADER_REDO1);
-                RedoLogRecord* redoLogRecord2 = reinterpret_cast<RedoLogRecord*>(tc->buffer + pos + ROW_HEADER_REDO2);
+                typeOp2 op;
+                RedoLogRecord* redoLogRecord1 = transactionBuffer->newFlushRecord();
+                RedoLogRecord* redoLogRecord2 = transactionBuffer->newFlushRecord();
+                uint64_t headerSize = TransactionBuffer::unpackRow(tc->buffer + pos, op, redoLogRecord1, redoLogRecord2);
                 log(metadata->ctx, "flu1", redoLogRecord1);
                 log(metadata->ctx, "flu2", redoLogRecord2);
 
-                redoLogRecord1->data = tc->buffer + pos + ROW_HEADER_DATA;
-                redoLogRecord2->data = tc->buffer + pos + ROW_HEADER_DATA + redoLogRecord1->length;
-                pos += redoLogRecord1->length + redoLogRecord2->length + ROW_HEADER_TOTAL;
+                pos += TransactionBuffer::rowLength(headerSize, redoLogRecord1->length + redoLogRecord2->length);
 
                 if (metadata->ctx->trace & TRACE_TRANSACTION)
                     metadata->ctx->logTrace(TRACE_TRANSACTION,std::to_string(redoLogRecord1->length) + ":" +
@@ -532,12 +550,15 @@ namespace OpenLogReplicator {
                         transactionBuffer->deleteTransactionChunk(deallocTc);
                         deallocTc = nextTc;
                     }
+                    transactionBuffer->releaseFlushRecords();
                 }
             }
 
             TransactionChunk* nextTc = tc->next;
             tc->next = deallocTc;
             deallocTc = tc;
+            if (spill != nullptr && spill->read < spill->chunks.size())
+                nextTc = transactionBuffer->readSpilledChunk(this, nextTc);
             tc = nextTc;
             firstTc = tc;
         }
@@ -548,6 +569,8 @@ namespace OpenLogReplicator {
             deallocTc = nextTc;
         }
 
+        transactionBuffer->releaseFlushRecords();
+
         firstTc = nullptr;
         lastTc = nullptr;
         opCodes = 0;
@@ -576,6 +599,7 @@ namespace OpenLogReplicator {
             deallocTc = nextTc;
         }
         deallocTc = nullptr;
+        transactionBuffer->dropSpill(this);
 
         if (mergeBuffer != nullptr) {
             delete[] mergeBuffer;
@@ -596,6 +620,9 @@ namespace OpenLogReplicator {
             tc = tc->next;
         }
 
+        if (spill != nullptr)
+            tcCount += spill->chunks.size() - spill->read;
+
         std::ostringstream ss;
         ss << "scn: " << std::dec << commitScn <<
                 " seq: " << std::dec << firstSequence <<
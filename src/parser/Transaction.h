@@ -18,6 +18,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 <http://www.gnu.org/licenses/>.  */
 
 #include <map>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
@@ -36,6 +37,7 @@ namespace OpenLogReplicator {
     class Metadata;
     class TransactionBuffer;
     struct TransactionChunk;
+    struct TransactionSpill;
 
     class Transaction {
     protected:
@@ -52,6 +54,7 @@ namespace OpenLogReplicator {
         typeScn commitScn;
         TransactionChunk* firstTc;
         TransactionChunk* lastTc;
+        TransactionSpill* spill;
         typeTime commitTimestamp;
         bool begin;
         bool rollback;
@@ -62,7 +65,7 @@ namespace OpenLogReplicator {
         bool dump;
         uint64_t size;
 
-        explicit Transaction(typeXid newXid, std::map<LobKey, uint8_t*>* newOrphanedLobs);
+        Transaction(typeXid newXid, std::map<LobKey, uint8_t*>* newOrphanedLobs, std::mutex* newOrphanedLobsMtx);
 
         void add(Metadata* metadata, TransactionBuffer* transactionBuffer, RedoLogRecord* redoLogRecord1);
         void add(Metadata* metadata, TransactionBuffer* transactionBuffer, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2);
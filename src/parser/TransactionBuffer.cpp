@@ -17,10 +17,16 @@ You should have received a copy of the GNU General Public License
 along with OpenLogReplicator; see the file LICENSE;  If not see
 <http://www.gnu.org/licenses/>.  */
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "../common/RedoLogException.h"
 #include "../common/RedoLogRecord.h"
+#include "../common/RuntimeException.h"
 #include "OpCode0501.h"
 #include "OpCode050B.h"
 #include "Transaction.h"
@@ -28,22 +34,47 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 
 namespace OpenLogReplicator {
     TransactionBuffer::TransactionBuffer(Ctx* newCtx) :
-        ctx(newCtx) {
+        ctx(newCtx),
+        slabs(0),
+        spillFiles(0),
+        flushRecordsUsed(0) {
+        for (uint64_t sizeClass = 0; sizeClass < CHUNK_CLASSES; ++sizeClass)
+            partialSlabs[sizeClass] = nullptr;
     }
 
     TransactionBuffer::~TransactionBuffer() {
-        if (!partiallyFullChunks.empty())
-            ctx->error(50062, "non-free blocks in transaction buffer: " + std::to_string(partiallyFullChunks.size()));
+        for (uint64_t sizeClass = 0; sizeClass < CHUNK_CLASSES; ++sizeClass) {
+            TransactionSlab* slab = partialSlabs[sizeClass];
+            while (slab != nullptr) {
+                TransactionSlab* nextSlab = slab->next;
+                if (slab->used == 0) {
+                    ctx->freeMemoryChunk("transaction", slab->data, false);
+                    delete slab;
+                    --slabs;
+                }
+                slab = nextSlab;
+            }
+        }
+
+        if (slabs > 0)
+            ctx->error(50062, "non-free blocks in transaction buffer: " + std::to_string(slabs));
 
         skipXidList.clear();
         dumpXidList.clear();
         brokenXidMapList.clear();
 
-        for (const auto& orphanedLobsIt: orphanedLobs) {
-            uint8_t* data = orphanedLobsIt.second;
-            delete[] data;
+        for (RedoLogRecord* records : flushRecords)
+            delete[] records;
+        flushRecords.clear();
+
+        {
+            std::unique_lock<std::mutex> lck(orphanedLobsMtx);
+            for (const auto& orphanedLobsIt: orphanedLobs) {
+                uint8_t* data = orphanedLobsIt.second;
+                delete[] data;
+            }
+            orphanedLobs.clear();
         }
-        orphanedLobs.clear();
     }
 
     void TransactionBuffer::purge() {
@@ -53,6 +84,7 @@ namespace OpenLogReplicator {
             delete transaction;
         }
         xidTransactionMap.clear();
+        openTransactions.clear();
     }
 
     Transaction* TransactionBuffer::findTransaction(typeXid xid, typeConId conId, bool old, bool add, bool rollback) {
@@ -68,10 +100,11 @@ namespace OpenLogReplicator {
             if (!add)
                 return nullptr;
 
-            transaction = new Transaction(xid, &orphanedLobs);
+            transaction = new Transaction(xid, &orphanedLobs, &orphanedLobsMtx);
             {
                 std::unique_lock<std::mutex> lck(mtx);
                 xidTransactionMap[xidMap] = transaction;
+                openTransactions.insert(TransactionPosition{transaction->firstSequence, transaction->firstOffset, transaction});
             }
 
             if (dumpXidList.find(xid) != dumpXidList.end())
@@ -85,51 +118,110 @@ namespace OpenLogReplicator {
         typeXidMap xidMap = (xid.getData() >> 32) | (static_cast<uint64_t>(conId) << 32);
         {
             std::unique_lock<std::mutex> lck(mtx);
-            xidTransactionMap.erase(xidMap);
+            auto xidTransactionMapIt = xidTransactionMap.find(xidMap);
+            if (xidTransactionMapIt == xidTransactionMap.end())
+                return;
+
+            Transaction* transaction = xidTransactionMapIt->second;
+            openTransactions.erase(TransactionPosition{transaction->firstSequence, transaction->firstOffset, transaction});
+            xidTransactionMap.erase(xidTransactionMapIt);
         }
     }
 
-    TransactionChunk* TransactionBuffer::newTransactionChunk() {
-        uint8_t* chunk;
-        TransactionChunk* tc;
-        uint64_t pos;
-        uint64_t freeMap;
-        if (!partiallyFullChunks.empty()) {
-            auto partiallyFullChunksIt = partiallyFullChunks.cbegin();
-            chunk = partiallyFullChunksIt->first;
-            freeMap = partiallyFullChunksIt->second;
-            pos = ffs(freeMap) - 1;
-            freeMap &= ~(1 << pos);
-            if (freeMap == 0)
-                partiallyFullChunks.erase(chunk);
-            else
-                partiallyFullChunks[chunk] = freeMap;
-        } else {
-            chunk = ctx->getMemoryChunk("transaction", false);
-            pos = 0;
-            freeMap = BUFFERS_FREE_MASK & (~1);
-            partiallyFullChunks[chunk] = freeMap;
+    void TransactionBuffer::setFirstPosition(Transaction* transaction, typeSeq sequence, uint64_t offset) {
+        std::unique_lock<std::mutex> lck(mtx);
+        // The position is part of the key, so the entry is moved
+        if (openTransactions.erase(TransactionPosition{transaction->firstSequence, transaction->firstOffset, transaction}) == 0)
+            throw RedoLogException(50065, "transaction " + transaction->xid.toString() + " is not open");
+
+        transaction->firstSequence = sequence;
+        transaction->firstOffset = offset;
+        openTransactions.insert(TransactionPosition{sequence, offset, transaction});
+    }
+
+    TransactionChunk* TransactionBuffer::newTransactionChunk(uint64_t minSize) {
+        // Smallest class which fits, every next class is 4 times bigger
+        uint64_t sizeClass = 0;
+        while (sizeClass < CHUNK_CLASSES - 1 && (static_cast<uint64_t>(1) << (CHUNK_CLASS_SHIFT + sizeClass * 2)) - HEADER_BUFFER_SIZE < minSize)
+            ++sizeClass;
+        uint64_t slotSize = static_cast<uint64_t>(1) << (CHUNK_CLASS_SHIFT + sizeClass * 2);
+
+        std::unique_lock<std::mutex> lck(slabsMtx);
+        TransactionSlab* slab = partialSlabs[sizeClass];
+        if (slab == nullptr) {
+            // Waiting for free memory must not block the commit worker, which releases chunks
+            lck.unlock();
+            uint8_t* data = ctx->getMemoryChunk("transaction", false);
+            lck.lock();
+
+            slab = new TransactionSlab;
+            slab->data = data;
+            slab->freeList = nullptr;
+            slab->sizeClass = sizeClass;
+            slab->slots = ctx->memoryChunkSize / slotSize;
+            slab->used = 0;
+            slab->carved = 0;
+            slab->prev = nullptr;
+            slab->next = partialSlabs[sizeClass];
+            if (slab->next != nullptr)
+                slab->next->prev = slab;
+            partialSlabs[sizeClass] = slab;
+            ++slabs;
+        }
+
+        // Released slots are used first, the rest of the slab is carved on demand
+        uint8_t* slot;
+        if (slab->freeList != nullptr) {
+            slot = slab->freeList;
+            slab->freeList = *(reinterpret_cast<uint8_t**>(slot));
+        } else
+            slot = slab->data + slotSize * slab->carved++;
+
+        // The slab is full
+        if (++slab->used == slab->slots) {
+            partialSlabs[sizeClass] = slab->next;
+            if (slab->next != nullptr)
+                slab->next->prev = nullptr;
+            slab->next = nullptr;
         }
 
-        tc = reinterpret_cast<TransactionChunk*>(chunk + FULL_BUFFER_SIZE * pos);
+        TransactionChunk* tc = reinterpret_cast<TransactionChunk*>(slot);
         memset(reinterpret_cast<void*>(tc), 0, HEADER_BUFFER_SIZE);
-        tc->header = chunk;
-        tc->pos = pos;
+        tc->capacity = slotSize - HEADER_BUFFER_SIZE;
+        tc->slab = slab;
         return tc;
     }
 
     void TransactionBuffer::deleteTransactionChunk(TransactionChunk* tc) {
-        uint8_t* chunk = tc->header;
-        uint64_t pos = tc->pos;
-        uint64_t freeMap = partiallyFullChunks[chunk];
+        std::unique_lock<std::mutex> lck(slabsMtx);
+        TransactionSlab* slab = tc->slab;
+        uint8_t* slot = reinterpret_cast<uint8_t*>(tc);
+        *(reinterpret_cast<uint8_t**>(slot)) = slab->freeList;
+        slab->freeList = slot;
+
+        // The slab was full, it has a free slot again
+        if (slab->used-- == slab->slots) {
+            slab->prev = nullptr;
+            slab->next = partialSlabs[slab->sizeClass];
+            if (slab->next != nullptr)
+                slab->next->prev = slab;
+            partialSlabs[slab->sizeClass] = slab;
+        }
 
-        freeMap |= (1 << pos);
+        // One empty slab of the class is kept, so that short transactions do not allocate and free memory chunks
+        if (slab->used > 0 || (partialSlabs[slab->sizeClass] == slab && slab->next == nullptr))
+            return;
 
-        if (freeMap == BUFFERS_FREE_MASK) {
-            ctx->freeMemoryChunk("transaction", chunk, false);
-            partiallyFullChunks.erase(chunk);
-        } else
-            partiallyFullChunks[chunk] = freeMap;
+        if (slab->prev != nullptr)
+            slab->prev->next = slab->next;
+        else
+            partialSlabs[slab->sizeClass] = slab->next;
+        if (slab->next != nullptr)
+            slab->next->prev = slab->prev;
+
+        ctx->freeMemoryChunk("transaction", slab->data, false);
+        delete slab;
+        --slabs;
     }
 
     void TransactionBuffer::deleteTransactionChunks(TransactionChunk* tc) {
@@ -142,24 +234,19 @@ namespace OpenLogReplicator {
     }
 
     void TransactionBuffer::addTransactionChunk(Transaction* transaction, RedoLogRecord* redoLogRecord) {
-        uint64_t length = redoLogRecord->length + ROW_HEADER_TOTAL;
-
-        if (length > DATA_BUFFER_SIZE)
-            throw RedoLogException(50040, "block size (" + std::to_string(length) + ") exceeding max block size (" +
-                                   std::to_string(FULL_BUFFER_SIZE) + "), try increasing the FULL_BUFFER_SIZE parameter");
-
         if (transaction->lastSplit) {
             if ((redoLogRecord->flg & FLG_MULTIBLOCKUNDOMID) == 0)
                 throw RedoLogException(50041, "bad split offset: " + std::to_string(redoLogRecord->dataOffset) + " xid: " +
                                        transaction->xid.toString());
 
-            uint64_t lengthLast = *(reinterpret_cast<uint64_t*>(transaction->lastTc->buffer + transaction->lastTc->size - ROW_HEADER_TOTAL + ROW_HEADER_SIZE));
-            RedoLogRecord* last501 = reinterpret_cast<RedoLogRecord*>(transaction->lastTc->buffer + transaction->lastTc->size - lengthLast + ROW_HEADER_REDO1);
-            last501->data = transaction->lastTc->buffer + transaction->lastTc->size - lengthLast + ROW_HEADER_DATA;
+            typeOp2 lastOp;
+            RedoLogRecord last501;
+            RedoLogRecord last2;
+            unpackRow(transaction->lastTc->buffer + transaction->lastTc->size - lastRowLength(transaction->lastTc), lastOp, &last501, &last2);
 
-            uint64_t size = last501->length + redoLogRecord->length;
+            uint64_t size = last501.length + redoLogRecord->length;
             transaction->mergeBuffer = new uint8_t[size];
-            mergeBlocks(transaction->mergeBuffer, redoLogRecord, last501);
+            mergeBlocks(transaction->mergeBuffer, redoLogRecord, &last501);
             rollbackTransactionChunk(transaction);
         }
         if ((redoLogRecord->flg & (FLG_MULTIBLOCKUNDOTAIL | FLG_MULTIBLOCKUNDOMID)) != 0)
@@ -167,15 +254,27 @@ namespace OpenLogReplicator {
         else
             transaction->lastSplit = false;
 
+        uint8_t header[ROW_HEADER_MAX];
+        uint64_t headerSize = packRow(header, redoLogRecord->opCode << 16, redoLogRecord, nullptr);
+        uint64_t length = rowLength(headerSize, redoLogRecord->length);
+
+        if (length > DATA_BUFFER_SIZE)
+            throw RedoLogException(50040, "block size (" + std::to_string(length) + ") exceeding max block size (" +
+                                   std::to_string(FULL_BUFFER_SIZE) + "), try increasing the FULL_BUFFER_SIZE parameter");
+
         // Empty list
         if (transaction->lastTc == nullptr) {
-            transaction->lastTc = newTransactionChunk();
+            transaction->lastTc = newTransactionChunk(length);
             transaction->firstTc = transaction->lastTc;
         }
 
-        // New block needed
-        if (transaction->lastTc->size + length > DATA_BUFFER_SIZE) {
-            TransactionChunk* tcNew = newTransactionChunk();
+        // New block needed, the transaction grows to the next size class
+        if (transaction->lastTc->size + length > transaction->lastTc->capacity) {
+            if (ctx->transactionSpillMb > 0 && transaction->size >= SPILL_MIN_SIZE &&
+                    ctx->getAllocatedMemory() - ctx->getFreeMemory() >= ctx->transactionSpillMb)
+                spillTransactionChunks(transaction);
+
+            TransactionChunk* tcNew = newTransactionChunk(std::max(length, transaction->lastTc->capacity + 1));
             tcNew->prev = transaction->lastTc;
             transaction->lastTc->next = tcNew;
             transaction->lastTc = tcNew;
@@ -183,14 +282,12 @@ namespace OpenLogReplicator {
 
         // Append to the chunk at the end
         TransactionChunk* tc = transaction->lastTc;
-        *(reinterpret_cast<typeOp2*>(tc->buffer + tc->size + ROW_HEADER_OP)) = (redoLogRecord->opCode << 16);
-        memcpy(reinterpret_cast<void*>(tc->buffer + tc->size + ROW_HEADER_REDO1),
-               reinterpret_cast<const void*>(redoLogRecord), sizeof(RedoLogRecord));
-        memset(reinterpret_cast<void*>(tc->buffer + tc->size + ROW_HEADER_REDO2), 0, sizeof(RedoLogRecord));
-        memcpy(reinterpret_cast<void*>(tc->buffer + tc->size + ROW_HEADER_DATA),
+        memcpy(reinterpret_cast<void*>(tc->buffer + tc->size),
+               reinterpret_cast<const void*>(header), headerSize);
+        memcpy(reinterpret_cast<void*>(tc->buffer + tc->size + headerSize),
                reinterpret_cast<const void*>(redoLogRecord->data), redoLogRecord->length);
 
-        *(reinterpret_cast<uint64_t*>(tc->buffer + tc->size + ROW_HEADER_SIZE + redoLogRecord->length)) = length;
+        *(reinterpret_cast<uint64_t*>(tc->buffer + tc->size + length - sizeof(uint64_t))) = length;
 
         tc->size += length;
         ++tc->elements;
@@ -203,12 +300,6 @@ namespace OpenLogReplicator {
     }
 
     void TransactionBuffer::addTransactionChunk(Transaction* transaction, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2) {
-        uint64_t length = redoLogRecord1->length + redoLogRecord2->length + ROW_HEADER_TOTAL;
-
-        if (length > DATA_BUFFER_SIZE)
-            throw RedoLogException(50040, "block size (" + std::to_string(length) +  ") exceeding max block size (" +
-                                   std::to_string(FULL_BUFFER_SIZE) + "), try increasing the FULL_BUFFER_SIZE parameter");
-
         if (transaction->lastSplit) {
             if ((redoLogRecord1->opCode) != 0x0501)
                 throw RedoLogException(50042, "split undo HEAD no 5.1 offset: " + std::to_string(redoLogRecord1->dataOffset));
@@ -217,13 +308,14 @@ namespace OpenLogReplicator {
                 throw RedoLogException(50043, "bad split offset: " + std::to_string(redoLogRecord1->dataOffset) + " xid: " +
                                        transaction->xid.toString() + " second position");
 
-            uint64_t lengthLast = *(reinterpret_cast<uint64_t*>(transaction->lastTc->buffer + transaction->lastTc->size - ROW_HEADER_TOTAL + ROW_HEADER_SIZE));
-            RedoLogRecord* last501 = reinterpret_cast<RedoLogRecord*>(transaction->lastTc->buffer + transaction->lastTc->size - lengthLast + ROW_HEADER_REDO1);
-            last501->data = transaction->lastTc->buffer + transaction->lastTc->size - lengthLast + ROW_HEADER_DATA;
+            typeOp2 lastOp;
+            RedoLogRecord last501;
+            RedoLogRecord last2;
+            unpackRow(transaction->lastTc->buffer + transaction->lastTc->size - lastRowLength(transaction->lastTc), lastOp, &last501, &last2);
 
-            uint64_t size = last501->length + redoLogRecord1->length;
+            uint64_t size = last501.length + redoLogRecord1->length;
             transaction->mergeBuffer = new uint8_t[size];
-            mergeBlocks(transaction->mergeBuffer, redoLogRecord1, last501);
+            mergeBlocks(transaction->mergeBuffer, redoLogRecord1, &last501);
 
             uint16_t fieldPos = redoLogRecord1->fieldPos;
             uint16_t fieldLength = ctx->read16(redoLogRecord1->data + redoLogRecord1->fieldLengthsDelta + 1 * 2);
@@ -231,21 +323,32 @@ namespace OpenLogReplicator {
 
             ctx->write16(redoLogRecord1->data + fieldPos + 20, redoLogRecord1->flg);
             OpCode0501::process(ctx, redoLogRecord1);
-            length = redoLogRecord1->length + redoLogRecord2->length + ROW_HEADER_TOTAL;
 
             rollbackTransactionChunk(transaction);
             transaction->lastSplit = false;
         }
 
+        uint8_t header[ROW_HEADER_MAX];
+        uint64_t headerSize = packRow(header, (redoLogRecord1->opCode << 16) | redoLogRecord2->opCode, redoLogRecord1, redoLogRecord2);
+        uint64_t length = rowLength(headerSize, redoLogRecord1->length + redoLogRecord2->length);
+
+        if (length > DATA_BUFFER_SIZE)
+            throw RedoLogException(50040, "block size (" + std::to_string(length) +  ") exceeding max block size (" +
+                                   std::to_string(FULL_BUFFER_SIZE) + "), try increasing the FULL_BUFFER_SIZE parameter");
+
         // Empty list
         if (transaction->lastTc == nullptr) {
-            transaction->lastTc = newTransactionChunk();
+            transaction->lastTc = newTransactionChunk(length);
             transaction->firstTc = transaction->lastTc;
         }
 
-        // New block needed
-        if (transaction->lastTc->size + length > DATA_BUFFER_SIZE) {
-            TransactionChunk* tcNew = newTransactionChunk();
+        // New block needed, the transaction grows to the next size class
+        if (transaction->lastTc->size + length > transaction->lastTc->capacity) {
+            if (ctx->transactionSpillMb > 0 && transaction->size >= SPILL_MIN_SIZE &&
+                    ctx->getAllocatedMemory() - ctx->getFreeMemory() >= ctx->transactionSpillMb)
+                spillTransactionChunks(transaction);
+
+            TransactionChunk* tcNew = newTransactionChunk(std::max(length, transaction->lastTc->capacity + 1));
             tcNew->prev = transaction->lastTc;
             transaction->lastTc->next = tcNew;
             transaction->lastTc = tcNew;
@@ -253,17 +356,14 @@ namespace OpenLogReplicator {
 
         // Append to the chunk at the end
         TransactionChunk* tc = transaction->lastTc;
-        *(reinterpret_cast<typeOp2*>(tc->buffer + tc->size + ROW_HEADER_OP)) = (redoLogRecord1->opCode << 16) | redoLogRecord2->opCode;
-        memcpy(reinterpret_cast<void*>(tc->buffer + tc->size + ROW_HEADER_REDO1),
-               reinterpret_cast<const void*>(redoLogRecord1), sizeof(RedoLogRecord));
-        memcpy(reinterpret_cast<void*>(tc->buffer + tc->size + ROW_HEADER_REDO2),
-               reinterpret_cast<const void*>(redoLogRecord2), sizeof(RedoLogRecord));
-        memcpy(reinterpret_cast<void*>(tc->buffer + tc->size + ROW_HEADER_DATA),
+        memcpy(reinterpret_cast<void*>(tc->buffer + tc->size),
+               reinterpret_cast<const void*>(header), headerSize);
+        memcpy(reinterpret_cast<void*>(tc->buffer + tc->size + headerSize),
                reinterpret_cast<const void*>(redoLogRecord1->data), redoLogRecord1->length);
-        memcpy(reinterpret_cast<void*>(tc->buffer + tc->size + ROW_HEADER_DATA + redoLogRecord1->length),
+        memcpy(reinterpret_cast<void*>(tc->buffer + tc->size + headerSize + redoLogRecord1->length),
                reinterpret_cast<const void*>(redoLogRecord2->data), redoLogRecord2->length);
 
-        *(reinterpret_cast<uint64_t*>(tc->buffer + tc->size + ROW_HEADER_SIZE + redoLogRecord1->length + redoLogRecord2->length)) = length;
+        *(reinterpret_cast<uint64_t*>(tc->buffer + tc->size + length - sizeof(uint64_t))) = length;
 
         tc->size += length;
         ++tc->elements;
@@ -276,11 +376,11 @@ namespace OpenLogReplicator {
     }
 
     void TransactionBuffer::rollbackTransactionChunk(Transaction* transaction) {
-        if (transaction->lastTc == nullptr || transaction->lastTc->size < ROW_HEADER_TOTAL || transaction->lastTc->elements == 0)
+        if (transaction->lastTc == nullptr || transaction->lastTc->size < sizeof(uint64_t) || transaction->lastTc->elements == 0)
             throw RedoLogException(50044, "trying to remove from empty buffer size: " + std::to_string(transaction->lastTc->size) +
                                    " elements: " + std::to_string(transaction->lastTc->elements));
 
-        uint64_t length = *(reinterpret_cast<uint64_t*>(transaction->lastTc->buffer + transaction->lastTc->size - ROW_HEADER_TOTAL + ROW_HEADER_SIZE));
+        uint64_t length = lastRowLength(transaction->lastTc);
         transaction->lastTc->size -= length;
         --transaction->lastTc->elements;
         transaction->size -= length;
@@ -295,9 +395,187 @@ namespace OpenLogReplicator {
                 transaction->firstTc = nullptr;
             }
             deleteTransactionChunk(tc);
+
+            // The newest spilled chunk is brought back, the space in the file is reused by the following chunks
+            if (transaction->lastTc == nullptr && transaction->spill != nullptr && !transaction->spill->chunks.empty()) {
+                TransactionSpill* spill = transaction->spill;
+                tc = loadSpilledChunk(transaction, spill->chunks.size() - 1);
+                spill->size = spill->chunks.back();
+                spill->chunks.pop_back();
+                transaction->firstTc = tc;
+                transaction->lastTc = tc;
+            }
         }
     }
 
+    void TransactionBuffer::spillTransactionChunks(Transaction* transaction) {
+        TransactionSpill* spill = transaction->spill;
+        if (spill == nullptr) {
+            spill = new TransactionSpill;
+            spill->fileName = ctx->transactionSpillPath + "/" + transaction->xid.toString() + "-" + std::to_string(spillFiles++) + ".spill";
+            spill->size = 0;
+            spill->read = 0;
+            spill->fileDes = open(spill->fileName.c_str(), O_CREAT | O_RDWR | O_TRUNC, S_IRUSR | S_IWUSR);
+            if (spill->fileDes == -1) {
+                std::string fileName = spill->fileName;
+                delete spill;
+                throw RuntimeException(10006, "file: " + fileName + " - open for write returned: " + strerror(errno));
+            }
+            // The file is not needed after restart
+            unlink(spill->fileName.c_str());
+            transaction->spill = spill;
+
+            ctx->info(0, "transaction " + transaction->xid.toString() + " of " + std::to_string(transaction->size) +
+                      " bytes is spilled to file: " + spill->fileName);
+        }
+
+        // The last chunk stays in memory, it is needed for rollback and split records
+        while (transaction->firstTc != transaction->lastTc) {
+            TransactionChunk* tc = transaction->firstTc;
+            uint64_t header[2] = {tc->elements, tc->size};
+
+            int64_t bytesWritten = pwrite(spill->fileDes, header, SPILL_HEADER_SIZE, static_cast<off_t>(spill->size));
+            if (static_cast<uint64_t>(bytesWritten) != SPILL_HEADER_SIZE)
+                throw RuntimeException(10007, "file: " + spill->fileName + " - " + std::to_string(bytesWritten) + " bytes written instead of " +
+                                       std::to_string(SPILL_HEADER_SIZE) + ", code returned: " + strerror(errno));
+
+            bytesWritten = pwrite(spill->fileDes, tc->buffer, tc->size, static_cast<off_t>(spill->size + SPILL_HEADER_SIZE));
+            if (static_cast<uint64_t>(bytesWritten) != tc->size)
+                throw RuntimeException(10007, "file: " + spill->fileName + " - " + std::to_string(bytesWritten) + " bytes written instead of " +
+                                       std::to_string(tc->size) + ", code returned: " + strerror(errno));
+
+            spill->chunks.push_back(spill->size);
+            spill->size += SPILL_HEADER_SIZE + tc->size;
+
+            transaction->firstTc = tc->next;
+            transaction->firstTc->prev = nullptr;
+            deleteTransactionChunk(tc);
+        }
+    }
+
+    TransactionChunk* TransactionBuffer::loadSpilledChunk(Transaction* transaction, uint64_t num) {
+        TransactionSpill* spill = transaction->spill;
+        uint64_t offset = spill->chunks[num];
+        uint64_t header[2];
+
+        int64_t bytesRead = pread(spill->fileDes, header, SPILL_HEADER_SIZE, static_cast<off_t>(offset));
+        if (static_cast<uint64_t>(bytesRead) != SPILL_HEADER_SIZE)
+            throw RuntimeException(10005, "file: " + spill->fileName + " - " + std::to_string(bytesRead) + " bytes read instead of " +
+                                   std::to_string(SPILL_HEADER_SIZE));
+
+        TransactionChunk* tc = newTransactionChunk(header[1]);
+        bytesRead = pread(spill->fileDes, tc->buffer, header[1], static_cast<off_t>(offset + SPILL_HEADER_SIZE));
+        if (static_cast<uint64_t>(bytesRead) != header[1]) {
+            deleteTransactionChunk(tc);
+            throw RuntimeException(10005, "file: " + spill->fileName + " - " + std::to_string(bytesRead) + " bytes read instead of " +
+                                   std::to_string(header[1]));
+        }
+
+        tc->elements = header[0];
+        tc->size = header[1];
+        return tc;
+    }
+
+    TransactionChunk* TransactionBuffer::readSpilledChunk(Transaction* transaction, TransactionChunk* next) {
+        TransactionSpill* spill = transaction->spill;
+
+#ifdef POSIX_FADV_WILLNEED
+        // Chunks are read in the order they were written, the next chunks are requested before they are needed
+        if (spill->read % SPILL_READAHEAD == 0) {
+            uint64_t start = spill->chunks[spill->read];
+            uint64_t end = spill->size;
+            if (spill->read + SPILL_READAHEAD * 2 < spill->chunks.size())
+                end = spill->chunks[spill->read + SPILL_READAHEAD * 2];
+            posix_fadvise(spill->fileDes, static_cast<off_t>(start), static_cast<off_t>(end - start), POSIX_FADV_WILLNEED);
+        }
+#endif
+
+        TransactionChunk* tc = loadSpilledChunk(transaction, spill->read++);
+        tc->next = next;
+        return tc;
+    }
+
+    void TransactionBuffer::dropSpill(Transaction* transaction) {
+        if (transaction->spill == nullptr)
+            return;
+
+        close(transaction->spill->fileDes);
+        delete transaction->spill;
+        transaction->spill = nullptr;
+    }
+
+    uint64_t TransactionBuffer::packRow(uint8_t* header, typeOp2 op, const RedoLogRecord* redoLogRecord1, const RedoLogRecord* redoLogRecord2) {
+        *(reinterpret_cast<typeOp2*>(header + ROW_HEADER_OP)) = op;
+        uint64_t pos = ROW_HEADER_RECORDS;
+
+        // Only bytes which are not zero are kept, most fields are not used by a DML row; pointers are set again when the row is read
+        const RedoLogRecord* redoLogRecords[2] = {redoLogRecord1, redoLogRecord2};
+        for (const RedoLogRecord* redoLogRecord : redoLogRecords) {
+            uint8_t* mask = header + pos;
+            memset(reinterpret_cast<void*>(mask), 0, ROW_RECORD_MASK);
+            pos += ROW_RECORD_MASK;
+            if (redoLogRecord == nullptr)
+                continue;
+
+            RedoLogRecord record;
+            memcpy(reinterpret_cast<void*>(&record), reinterpret_cast<const void*>(redoLogRecord), sizeof(RedoLogRecord));
+            record.next = nullptr;
+            record.prev = nullptr;
+            record.data = nullptr;
+
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+            for (uint64_t i = 0; i < sizeof(RedoLogRecord); ++i) {
+                if (bytes[i] == 0)
+                    continue;
+                mask[i >> 3] |= 1 << (i & 7);
+                header[pos++] = bytes[i];
+            }
+        }
+
+        while ((pos & 7) != 0)
+            header[pos++] = 0;
+        return pos;
+    }
+
+    uint64_t TransactionBuffer::unpackRow(uint8_t* row, typeOp2& op, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2) {
+        op = *(reinterpret_cast<const typeOp2*>(row + ROW_HEADER_OP));
+        uint64_t pos = ROW_HEADER_RECORDS;
+
+        RedoLogRecord* redoLogRecords[2] = {redoLogRecord1, redoLogRecord2};
+        for (RedoLogRecord* redoLogRecord : redoLogRecords) {
+            const uint8_t* mask = row + pos;
+            pos += ROW_RECORD_MASK;
+
+            memset(reinterpret_cast<void*>(redoLogRecord), 0, sizeof(RedoLogRecord));
+            uint8_t* bytes = reinterpret_cast<uint8_t*>(redoLogRecord);
+            for (uint64_t i = 0; i < ROW_RECORD_MASK; ++i) {
+                uint8_t bits = mask[i];
+                while (bits != 0) {
+                    bytes[(i << 3) + ffs(bits) - 1] = row[pos++];
+                    bits &= bits - 1;
+                }
+            }
+        }
+
+        uint64_t headerSize = (pos + 7) & ~static_cast<uint64_t>(7);
+        redoLogRecord1->data = row + headerSize;
+        redoLogRecord2->data = row + headerSize + redoLogRecord1->length;
+        return headerSize;
+    }
+
+    RedoLogRecord* TransactionBuffer::newFlushRecord() {
+        if (flushRecordsUsed == flushRecords.size() * FLUSH_RECORDS_BLOCK)
+            flushRecords.push_back(new RedoLogRecord[FLUSH_RECORDS_BLOCK]);
+
+        RedoLogRecord* redoLogRecord = flushRecords[flushRecordsUsed / FLUSH_RECORDS_BLOCK] + (flushRecordsUsed % FLUSH_RECORDS_BLOCK);
+        ++flushRecordsUsed;
+        return redoLogRecord;
+    }
+
+    void TransactionBuffer::releaseFlushRecords() {
+        flushRecordsUsed = 0;
+    }
+
     void TransactionBuffer::mergeBlocks(uint8_t* mergeBuffer, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2) {
         memcpy(reinterpret_cast<void*>(mergeBuffer),
                reinterpret_cast<const void*>(redoLogRecord1->data), redoLogRecord1->fieldLengthsDelta);
@@ -345,16 +623,15 @@ namespace OpenLogReplicator {
     }
 
     void TransactionBuffer::checkpoint(typeSeq& minSequence, uint64_t& minOffset, typeXid& minXid) {
-        for (auto xidTransactionMapIt : xidTransactionMap) {
-            Transaction* transaction = xidTransactionMapIt.second;
-            if (transaction->firstSequence < minSequence) {
-                minSequence = transaction->firstSequence;
-                minOffset = transaction->firstOffset;
-                minXid = transaction->xid;
-            } else if (transaction->firstSequence == minSequence && transaction->firstOffset < minOffset) {
-                minOffset = transaction->firstOffset;
-                minXid = transaction->xid;
-            }
+        // Open transactions are ordered by the position of the first record, the oldest one is first
+        if (openTransactions.empty())
+            return;
+
+        const TransactionPosition& oldest = *openTransactions.begin();
+        if (oldest.sequence < minSequence || (oldest.sequence == minSequence && oldest.offset < minOffset)) {
+            minSequence = oldest.sequence;
+            minOffset = oldest.offset;
+            minXid = oldest.transaction->xid;
         }
     }
 
@@ -364,6 +641,7 @@ namespace OpenLogReplicator {
                           " can't match, offset: " + std::to_string(redoLogRecord1->dataOffset));
 
         LobKey lobKey(redoLogRecord1->lobId, redoLogRecord1->dba);
+        std::unique_lock<std::mutex> lck(orphanedLobsMtx);
 
         if (orphanedLobs.find(lobKey) != orphanedLobs.end()) {
             ctx->warning(60009, "duplicate orphaned lob: " + redoLogRecord1->lobId.lower() + ", page: " +
@@ -20,9 +20,10 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include <map>
 #include <mutex>
 #include <set>
-#include <unordered_map>
+#include <vector>
 
 #include "../common/Ctx.h"
+#include "../common/FlatMap.h"
 #include "../common/LobKey.h"
 #include "../common/types.h"
 #include "../common/typeXid.h"
@@ -31,59 +32,131 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #define TRANSACTION_BUFFER_H_
 
 #define ROW_HEADER_OP       (0)
-#define ROW_HEADER_REDO1    (sizeof(typeOp2))
-#define ROW_HEADER_REDO2    (sizeof(typeOp2)+sizeof(RedoLogRecord))
-#define ROW_HEADER_DATA     (sizeof(typeOp2)+sizeof(RedoLogRecord)+sizeof(RedoLogRecord))
-#define ROW_HEADER_SIZE     (sizeof(typeOp2)+sizeof(RedoLogRecord)+sizeof(RedoLogRecord))
-#define ROW_HEADER_TOTAL    (sizeof(typeOp2)+sizeof(RedoLogRecord)+sizeof(RedoLogRecord)+sizeof(uint64_t))
+#define ROW_HEADER_RECORDS  (sizeof(typeOp2))
+#define ROW_RECORD_MASK     ((sizeof(RedoLogRecord)+7)/8)
+#define ROW_RECORD_MAX      (ROW_RECORD_MASK+sizeof(RedoLogRecord))
+#define ROW_HEADER_MAX      ((sizeof(typeOp2)+ROW_RECORD_MAX+ROW_RECORD_MAX+7)&~static_cast<uint64_t>(7))
+#define ROW_HEADER_TOTAL    (ROW_HEADER_MAX+7+sizeof(uint64_t))
+#define FLUSH_RECORDS_BLOCK 256
 
 #define FULL_BUFFER_SIZE    65536
-#define HEADER_BUFFER_SIZE  (sizeof(uint64_t)+sizeof(uint64_t)+sizeof(uint64_t)+sizeof(uint8_t*)+sizeof(TransactionChunk*)+sizeof(TransactionChunk*))
+#define HEADER_BUFFER_SIZE  (sizeof(uint64_t)+sizeof(uint64_t)+sizeof(uint64_t)+sizeof(TransactionSlab*)+sizeof(TransactionChunk*)+sizeof(TransactionChunk*))
 #define DATA_BUFFER_SIZE    (FULL_BUFFER_SIZE-HEADER_BUFFER_SIZE)
-#define BUFFERS_FREE_MASK   0xFFFF
+#define CHUNK_CLASSES       4
+#define CHUNK_CLASS_SHIFT   10
+#define SPILL_MIN_SIZE      (FULL_BUFFER_SIZE*16)
+#define SPILL_HEADER_SIZE   (sizeof(uint64_t)+sizeof(uint64_t))
+#define SPILL_READAHEAD     16
 
 namespace OpenLogReplicator {
     class RedoLogRecord;
     class Transaction;
+    struct TransactionSlab;
 
+    // Only the first 'capacity' bytes of the buffer are allocated, depending on the size class of the chunk
     struct TransactionChunk {
         uint64_t elements;
         uint64_t size;
-        uint64_t pos;
-        uint8_t* header;
+        uint64_t capacity;
+        TransactionSlab* slab;
         TransactionChunk* prev;
         TransactionChunk* next;
         uint8_t buffer[DATA_BUFFER_SIZE];
     };
 
+    // Memory chunk divided into transaction chunks of one size class (1, 4, 16 or 64 kB)
+    struct TransactionSlab {
+        uint8_t* data;
+        uint8_t* freeList;
+        uint64_t sizeClass;
+        uint64_t slots;
+        uint64_t used;
+        uint64_t carved;
+        TransactionSlab* prev;
+        TransactionSlab* next;
+    };
+
+    // Chunks of a large transaction moved to disk, the oldest first; the file is unlinked just after opening
+    struct TransactionSpill {
+        int fileDes;
+        std::string fileName;
+        uint64_t size;
+        uint64_t read;
+        std::vector<uint64_t> chunks;
+    };
+
+    // Position of the first redo record of an open transaction, the oldest one limits the checkpoint
+    struct TransactionPosition {
+        typeSeq sequence;
+        uint64_t offset;
+        Transaction* transaction;
+
+        bool operator<(const TransactionPosition& other) const {
+            if (sequence != other.sequence)
+                return sequence < other.sequence;
+            if (offset != other.offset)
+                return offset < other.offset;
+            return transaction < other.transaction;
+        }
+    };
+
     class TransactionBuffer {
     protected:
         Ctx* ctx;
         uint8_t buffer[DATA_BUFFER_SIZE];
-        std::unordered_map<uint8_t*, uint64_t> partiallyFullChunks;
+        // Slabs which have free slots, for every size class; chunks are also released by the commit worker
+        std::mutex slabsMtx;
+        TransactionSlab* partialSlabs[CHUNK_CLASSES];
+        uint64_t slabs;
 
         std::mutex mtx;
-        std::unordered_map<typeXidMap, Transaction*> xidTransactionMap;
+        FlatMap<typeXidMap, Transaction*> xidTransactionMap;
+        std::set<TransactionPosition> openTransactions;
+        // Orphaned LOB pages are matched by the commit worker, which runs in parallel with the parser
+        std::mutex orphanedLobsMtx;
         std::map<LobKey, uint8_t*> orphanedLobs;
+        uint64_t spillFiles;
+        std::vector<RedoLogRecord*> flushRecords;
+        uint64_t flushRecordsUsed;
+
+        void spillTransactionChunks(Transaction* transaction);
+        [[nodiscard]] TransactionChunk* loadSpilledChunk(Transaction* transaction, uint64_t num);
 
     public:
-        std::set<typeXid> skipXidList;
-        std::set<typeXid> dumpXidList;
-        std::set<typeXidMap> brokenXidMapList;
+        FlatSet<typeXid> skipXidList;
+        FlatSet<typeXid> dumpXidList;
+        FlatSet<typeXidMap> brokenXidMapList;
         std::string dumpPath;
 
         explicit TransactionBuffer(Ctx* newCtx);
         virtual ~TransactionBuffer();
 
+        // Row in a chunk: op code, both records packed, data of both records, padding and the length of the row
+        [[nodiscard]] static uint64_t packRow(uint8_t* header, typeOp2 op, const RedoLogRecord* redoLogRecord1, const RedoLogRecord* redoLogRecord2);
+        static uint64_t unpackRow(uint8_t* row, typeOp2& op, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2);
+
+        [[nodiscard]] static uint64_t rowLength(uint64_t headerSize, uint64_t dataLength) {
+            return ((headerSize + dataLength + 7) & ~static_cast<uint64_t>(7)) + sizeof(uint64_t);
+        }
+
+        [[nodiscard]] static uint64_t lastRowLength(const TransactionChunk* tc) {
+            return *(reinterpret_cast<const uint64_t*>(tc->buffer + tc->size - sizeof(uint64_t)));
+        }
+
         void purge();
         [[nodiscard]] Transaction* findTransaction(typeXid xid, typeConId conId, bool old, bool add, bool rollback);
         void dropTransaction(typeXid xid, typeConId conId);
+        void setFirstPosition(Transaction* transaction, typeSeq sequence, uint64_t offset);
         void addTransactionChunk(Transaction* transaction, RedoLogRecord* redoLogRecord);
         void addTransactionChunk(Transaction* transaction, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2);
         void rollbackTransactionChunk(Transaction* transaction);
-        [[nodiscard]] TransactionChunk* newTransactionChunk();
+        [[nodiscard]] TransactionChunk* newTransactionChunk(uint64_t minSize);
         void deleteTransactionChunk(TransactionChunk* tc);
         void deleteTransactionChunks(TransactionChunk* tc);
+        [[nodiscard]] TransactionChunk* readSpilledChunk(Transaction* transaction, TransactionChunk* next);
+        void dropSpill(Transaction* transaction);
+        [[nodiscard]] RedoLogRecord* newFlushRecord();
+        void releaseFlushRecords();
         void mergeBlocks(uint8_t* mergeBuffer, RedoLogRecord* redoLogRecord1, RedoLogRecord* redoLogRecord2);
         void checkpoint(typeSeq& minSequence, uint64_t& minOffset, typeXid& minXid);
         void addOrphanedLob(RedoLogRecord* redoLogRecord1);
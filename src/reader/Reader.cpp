@@ -23,13 +23,17 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include <cstring>
 #include <dirent.h>
 #include <fcntl.h>
+#include <sched.h>
 #include <thread>
 #include <unistd.h>
 
+#include "../common/BlockSum.h"
 #include "../common/Ctx.h"
+#include "../common/PerfStats.h"
 #include "../common/RuntimeException.h"
 #include "../common/Timer.h"
 #include "Reader.h"
+#include "RedoCopy.h"
 
 namespace OpenLogReplicator {
     const char* Reader::REDO_CODE[] = {"OK", "OVERWRITTEN", "FINISHED", "STOPPED", "SHUTDOWN", "EMPTY", "READ ERROR",
@@ -40,7 +44,7 @@ namespace OpenLogReplicator {
         Thread(newCtx, newAlias),
         ctx(newCtx),
         database(newDatabase),
-        fileCopyDes(-1),
+        redoCopy(nullptr),
         fileSize(0),
         fileCopySequence(0),
         hintDisplayed(false),
@@ -64,22 +68,34 @@ namespace OpenLogReplicator {
         sumTime(0),
         bufferScan(0),
         lastRead(0),
+        readAheadScan(0),
         lastReadTime(0),
         readTime(0),
         loopTime(0),
+        tailIdleTime(0),
+        tailModifyTime(0),
+        tailBackoffUs(0),
+        tailSize(0),
         bufferStart(0),
         bufferEnd(0),
+        bufferSizeLimit(0),
         status(READER_STATUS_SLEEPING),
         ret(REDO_OK),
+        writeTime(0),
         redoBufferList(nullptr) {
     }
 
     void Reader::initialize() {
+        bufferSizeLimit = static_cast<uint64_t>(ctx->bufferSizeMax);
+
         if (redoBufferList == nullptr) {
             redoBufferList = new uint8_t*[ctx->readBufferMax];
             memset(reinterpret_cast<void*>(redoBufferList), 0, ctx->readBufferMax * sizeof(uint8_t*));
         }
 
+        if (ctx->trace & TRACE_PERFORMANCE)
+            ctx->logTrace(TRACE_PERFORMANCE, "block checksum implementation: " + std::string(BlockSum::name));
+
         if (headerBuffer == nullptr) {
             headerBuffer = reinterpret_cast<uint8_t*>(aligned_alloc(MEMORY_ALIGNMENT, REDO_PAGE_SIZE_MAX * 2));
             if (headerBuffer == nullptr)
@@ -90,6 +106,11 @@ namespace OpenLogReplicator {
         if (ctx->redoCopyPath.length() > 0) {
             if ((opendir(ctx->redoCopyPath.c_str())) == nullptr)
                 throw RuntimeException(10012, "directory: " + ctx->redoCopyPath + " - can't read");
+
+            if (redoCopy == nullptr) {
+                redoCopy = new RedoCopy(ctx, alias + "-copy", ctx->redoCopyBufferSize);
+                ctx->spawnThread(redoCopy);
+            }
         }
     }
 
@@ -114,13 +135,14 @@ namespace OpenLogReplicator {
             headerBuffer = nullptr;
         }
 
-        if (fileCopyDes != -1) {
-            close(fileCopyDes);
-            fileCopyDes = -1;
+        if (redoCopy != nullptr) {
+            redoCopy->finish();
+            delete redoCopy;
+            redoCopy = nullptr;
         }
     }
 
-    uint64_t Reader::checkBlockHeader(uint8_t* buffer, typeBlk blockNumber, bool showHint) {
+    uint64_t Reader::checkBlockHeader(uint8_t* buffer, typeBlk blockNumber, bool showHint, bool checkSum) {
         if (buffer[0] == 0 && buffer[1] == 0)
             return REDO_EMPTY;
 
@@ -158,7 +180,7 @@ namespace OpenLogReplicator {
             return REDO_ERROR_BLOCK;
         }
 
-        if (!DISABLE_CHECKS(DISABLE_CHECKS_BLOCK_SUM)) {
+        if (checkSum && !DISABLE_CHECKS(DISABLE_CHECKS_BLOCK_SUM)) {
             typeSum chSum = ctx->read16(buffer + 14);
             typeSum chSumCalculated = calcChSum(buffer, blockSize);
             if (chSum != chSumCalculated) {
@@ -181,13 +203,29 @@ namespace OpenLogReplicator {
         return REDO_OK;
     }
 
+    bool Reader::redoReadAhead(uint8_t* buf __attribute__((unused)), uint64_t offset __attribute__((unused)),
+                               uint64_t size __attribute__((unused))) {
+        return false;
+    }
+
+    void Reader::redoReadCancel() {
+    }
+
+    bool Reader::bufferMapped() const {
+        return false;
+    }
+
+    bool Reader::redoStat(time_t& modifyTime __attribute__((unused)), uint64_t& size __attribute__((unused))) {
+        return false;
+    }
+
     uint64_t Reader::readSize(uint64_t prevRead) {
         if (prevRead < blockSize)
             return blockSize;
 
         prevRead *= 2;
-        if (prevRead > MEMORY_CHUNK_SIZE)
-            prevRead = MEMORY_CHUNK_SIZE;
+        if (prevRead > ctx->memoryChunkSize)
+            prevRead = ctx->memoryChunkSize;
 
         return prevRead;
     }
@@ -238,28 +276,18 @@ namespace OpenLogReplicator {
                 bytes = static_cast<int64_t>(blockSize * 2);
 
             typeSeq sequenceHeader = ctx->read32(headerBuffer + blockSize + 8);
-            if (fileCopySequence != sequenceHeader) {
-                if (fileCopyDes != -1) {
-                    close(fileCopyDes);
-                    fileCopyDes = -1;
-                }
-            }
+            if (fileCopySequence != sequenceHeader)
+                redoCopy->close();
 
-            if (fileCopyDes == -1) {
+            if (!redoCopy->isOpen()) {
                 fileNameWrite = ctx->redoCopyPath + "/" + database + "_" + std::to_string(sequenceHeader) + ".arc";
-                fileCopyDes = open(fileNameWrite.c_str(), O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
-                if (fileCopyDes == -1)
-                    throw RuntimeException(10006, "file: " + fileNameWrite + " - open for write returned: " + strerror(errno));
-                ctx->info(0, "writing redo log copy to: " + fileNameWrite);
+                redoCopy->open(fileNameWrite);
                 fileCopySequence = sequenceHeader;
             }
 
-            int64_t bytesWritten = pwrite(fileCopyDes, headerBuffer, bytes, 0);
-            if (bytesWritten != bytes) {
-                ctx->error(10007, "file: " + fileNameWrite + " - " + std::to_string(bytesWritten) + " bytes written instead of " +
-                           std::to_string(bytes) + ", code returned: " + strerror(errno));
+            // Written in the background, errors are reported by the redo copy thread
+            if (!redoCopy->write(headerBuffer, bytes, 0))
                 return REDO_ERROR_WRITE;
-            }
         }
 
         return REDO_OK;
@@ -326,7 +354,7 @@ namespace OpenLogReplicator {
         }
 
         uint64_t badBlockCrcCount = 0;
-        retReload = checkBlockHeader(headerBuffer + blockSize, 1, false);
+        retReload = checkBlockHeader(headerBuffer + blockSize, 1, false, true);
         if (ctx->trace & TRACE_DISK)
             ctx->logTrace(TRACE_DISK, "block: 1 check: " + std::to_string(retReload));
 
@@ -336,7 +364,7 @@ namespace OpenLogReplicator {
                 return REDO_ERROR_BAD_DATA;
 
             usleep(ctx->redoReadSleepUs);
-            retReload = checkBlockHeader(headerBuffer + blockSize, 1, false);
+            retReload = checkBlockHeader(headerBuffer + blockSize, 1, false, true);
             if (ctx->trace & TRACE_DISK)
                 ctx->logTrace(TRACE_DISK, "block: 1 check: " + std::to_string(retReload));
         }
@@ -369,16 +397,127 @@ namespace OpenLogReplicator {
         return retReload;
     }
 
+    bool Reader::tailActive() const {
+        // Archived redo logs are complete, only online redo logs are awaited
+        return group != 0 && ctx->redoReadTail == REDO_READ_TAIL_ADAPTIVE;
+    }
+
+    bool Reader::tailChanged() {
+        time_t modifyTime;
+        uint64_t size;
+        if (!redoStat(modifyTime, size))
+            return false;
+
+        if (modifyTime == tailModifyTime && size == tailSize)
+            return false;
+
+        tailModifyTime = modifyTime;
+        tailSize = size;
+        return true;
+    }
+
+    void Reader::tailWait() {
+        time_t nowTime = Timer::getTime();
+        if (tailIdleTime == 0) {
+            tailIdleTime = nowTime;
+            tailBackoffUs = 0;
+        }
+
+        // Data usually follows shortly after the previous write, so read again without sleeping
+        if (nowTime - tailIdleTime < static_cast<time_t>(ctx->redoReadSpinUs)) {
+            sched_yield();
+            return;
+        }
+
+        // Reading is retried less often, but the file being modified wakes the reader immediately
+        if (tailBackoffUs == 0)
+            tailBackoffUs = REDO_TAIL_BACKOFF_MIN_US;
+        else
+            tailBackoffUs *= 2;
+        if (tailBackoffUs > ctx->redoReadSleepUs)
+            tailBackoffUs = ctx->redoReadSleepUs;
+
+        time_t endTime = nowTime + static_cast<time_t>(tailBackoffUs);
+        while (!ctx->softShutdown && status == READER_STATUS_READ) {
+            if (tailChanged()) {
+                if (ctx->trace & TRACE_DISK)
+                    ctx->logTrace(TRACE_DISK, "file: " + fileName + " modified after " + std::to_string(nowTime - tailIdleTime) + " us");
+                tailIdleTime = 0;
+                return;
+            }
+
+            nowTime = Timer::getTime();
+            if (nowTime >= endTime)
+                return;
+
+            if (endTime - nowTime > REDO_TAIL_STAT_US)
+                usleep(REDO_TAIL_STAT_US);
+            else
+                usleep(endTime - nowTime);
+        }
+    }
+
+    time_t Reader::statWriteTime() {
+        // Time of the last write to the file is used for latency statistics of online redo logs
+        time_t modifyTime;
+        uint64_t size;
+        if (group != 0 && (ctx->trace & TRACE_PERFORMANCE) != 0 && redoStat(modifyTime, size))
+            return modifyTime;
+        return 0;
+    }
+
+    uint64_t Reader::readVerifyMaxBlocks() const {
+        return ctx->memoryChunkSize / blockSize;
+    }
+
+    bool Reader::readAheadActive() const {
+        // Archived redo logs are complete, so it is safe to read them ahead
+        return group == 0 && ctx->readEngine != READ_ENGINE_PREAD;
+    }
+
+    void Reader::readAhead() {
+        if (readAheadScan < bufferScan)
+            readAheadScan = bufferScan;
+
+        while (readAheadScan < fileSize && !ctx->softShutdown) {
+            uint64_t redoBufferPos = readAheadScan % ctx->memoryChunkSize;
+            uint64_t redoBufferNum = (readAheadScan / ctx->memoryChunkSize) % ctx->readBufferMax;
+            uint64_t toRead = ctx->memoryChunkSize - redoBufferPos;
+            if (readAheadScan + toRead > fileSize)
+                toRead = fileSize - readAheadScan;
+
+            // Don't overwrite buffers which are not yet processed by the parser
+            if (readAheadScan + toRead > (bufferStart / ctx->memoryChunkSize) * ctx->memoryChunkSize + bufferSizeLimit)
+                break;
+
+            if (!bufferAllocate(redoBufferNum, readAheadScan))
+                break;
+
+            if (!redoReadAhead(redoBufferList[redoBufferNum] + redoBufferPos, readAheadScan, toRead))
+                break;
+
+            if (ctx->trace & TRACE_DISK)
+                ctx->logTrace(TRACE_DISK, "reading ahead " + fileName + " at (" + std::to_string(bufferStart) + "/" +
+                              std::to_string(bufferEnd) + "/" + std::to_string(readAheadScan) + ") bytes: " + std::to_string(toRead));
+            readAheadScan += toRead;
+        }
+    }
+
     bool Reader::read1() {
-        uint64_t toRead = readSize(lastRead);
+        PerfScope perfScope(ctx->perfStats, PERF_STAGE_READ);
+        uint64_t toRead;
+        if (readAheadActive())
+            toRead = ctx->memoryChunkSize;
+        else
+            toRead = readSize(lastRead);
 
         if (bufferScan + toRead > fileSize)
             toRead = fileSize - bufferScan;
 
-        uint64_t redoBufferPos = bufferScan % MEMORY_CHUNK_SIZE;
-        uint64_t redoBufferNum = (bufferScan / MEMORY_CHUNK_SIZE) % ctx->readBufferMax;
-        if (redoBufferPos + toRead > MEMORY_CHUNK_SIZE)
-            toRead = MEMORY_CHUNK_SIZE - redoBufferPos;
+        uint64_t redoBufferPos = bufferScan % ctx->memoryChunkSize;
+        uint64_t redoBufferNum = (bufferScan / ctx->memoryChunkSize) % ctx->readBufferMax;
+        if (redoBufferPos + toRead > ctx->memoryChunkSize)
+            toRead = ctx->memoryChunkSize - redoBufferPos;
 
         if (toRead == 0) {
             ctx->error(40010, "file: " + fileName + " - zero to read, start: " + std::to_string(bufferStart) + ", end: " +
@@ -387,7 +526,13 @@ namespace OpenLogReplicator {
             return false;
         }
 
-        bufferAllocate(redoBufferNum);
+        // Other readers might have taken the last free buffer
+        if (!bufferAllocate(redoBufferNum, bufferScan))
+            return true;
+
+        if (readAheadActive())
+            readAhead();
+
         if (ctx->trace & TRACE_DISK)
             ctx->logTrace(TRACE_DISK, "reading#1 " + fileName + " at (" + std::to_string(bufferStart) + "/" +
                           std::to_string(bufferEnd) + "/" + std::to_string(bufferScan) + ") bytes: " + std::to_string(toRead));
@@ -401,12 +546,8 @@ namespace OpenLogReplicator {
             return false;
         }
 
-        if (actualRead > 0 && fileCopyDes != -1 && (ctx->redoVerifyDelayUs == 0 || group == 0)) {
-            int64_t bytesWritten = pwrite(fileCopyDes, redoBufferList[redoBufferNum] + redoBufferPos, actualRead,
-                                          static_cast<int64_t>(bufferEnd));
-            if (bytesWritten != actualRead) {
-                ctx->error(10007, "file: " + fileNameWrite + " - " + std::to_string(bytesWritten) + " bytes written instead of " +
-                           std::to_string(actualRead) + ", code returned: " + strerror(errno));
+        if (actualRead > 0 && redoCopy != nullptr && redoCopy->isOpen() && (ctx->redoVerifyDelayUs == 0 || group == 0)) {
+            if (!redoCopy->write(redoBufferList[redoBufferNum] + redoBufferPos, actualRead, bufferEnd)) {
                 ret = REDO_ERROR_WRITE;
                 return false;
             }
@@ -416,11 +557,14 @@ namespace OpenLogReplicator {
         typeBlk bufferScanBlock = bufferScan / blockSize;
         uint64_t goodBlocks = 0;
         uint64_t currentRet = REDO_OK;
+        uint64_t sumBlocks = 0;
+        if (!DISABLE_CHECKS(DISABLE_CHECKS_BLOCK_SUM))
+            sumBlocks = BlockSum::verify(redoBufferList[redoBufferNum] + redoBufferPos, blockSize, maxNumBlock);
 
         // Check which blocks are good
         for (uint64_t numBlock = 0; numBlock < maxNumBlock; ++numBlock) {
             currentRet = checkBlockHeader(redoBufferList[redoBufferNum] + redoBufferPos + numBlock * blockSize, bufferScanBlock + numBlock,
-                                      ctx->redoVerifyDelayUs == 0 || group == 0);
+                                      ctx->redoVerifyDelayUs == 0 || group == 0, numBlock >= sumBlocks);
             if (ctx->trace & TRACE_DISK)
                 ctx->logTrace(TRACE_DISK, "block: " + std::to_string(bufferScanBlock + numBlock) + " check: " +
                               std::to_string(currentRet));
@@ -429,6 +573,8 @@ namespace OpenLogReplicator {
                 break;
             ++goodBlocks;
         }
+        if (ctx->perfStats != nullptr)
+            ctx->perfStats->add(PERF_STAGE_READ, goodBlocks * blockSize, goodBlocks);
 
         // Partial online redo log file
         if (goodBlocks == 0 && group == 0) {
@@ -475,7 +621,11 @@ namespace OpenLogReplicator {
                     *readTimeP = lastReadTime;
                 }
             } else {
+                // Write time is set together with the end of the buffer, so that the parser never sees it before the blocks
+                time_t newWriteTime = statWriteTime();
                 std::unique_lock<std::mutex> lck(mtx);
+                if (newWriteTime != 0)
+                    writeTime = newWriteTime;
                 bufferEnd += goodBlocks * blockSize;
                 bufferScan = bufferEnd;
                 condParserSleeping.notify_all();
@@ -498,14 +648,15 @@ namespace OpenLogReplicator {
     }
 
     bool Reader::read2() {
+        PerfScope perfScope(ctx->perfStats, PERF_STAGE_READ);
         uint64_t maxNumBlock = (bufferScan - bufferEnd) / blockSize;
         uint64_t goodBlocks = 0;
-        if (maxNumBlock > REDO_READ_VERIFY_MAX_BLOCKS)
-            maxNumBlock = REDO_READ_VERIFY_MAX_BLOCKS;
+        if (maxNumBlock > readVerifyMaxBlocks())
+            maxNumBlock = readVerifyMaxBlocks();
 
         for (uint64_t numBlock = 0; numBlock < maxNumBlock; ++numBlock) {
-            uint64_t redoBufferPos = (bufferEnd + numBlock * blockSize) % MEMORY_CHUNK_SIZE;
-            uint64_t redoBufferNum = ((bufferEnd + numBlock * blockSize) / MEMORY_CHUNK_SIZE) % ctx->readBufferMax;
+            uint64_t redoBufferPos = (bufferEnd + numBlock * blockSize) % ctx->memoryChunkSize;
+            uint64_t redoBufferNum = ((bufferEnd + numBlock * blockSize) / ctx->memoryChunkSize) % ctx->readBufferMax;
 
             auto readTimeP = reinterpret_cast<time_t*>(redoBufferList[redoBufferNum] + redoBufferPos);
             if (*readTimeP + static_cast<time_t>(ctx->redoVerifyDelayUs) < loopTime) {
@@ -521,11 +672,11 @@ namespace OpenLogReplicator {
             if (toRead > goodBlocks * blockSize)
                 toRead = goodBlocks * blockSize;
 
-            uint64_t redoBufferPos = bufferEnd % MEMORY_CHUNK_SIZE;
-            uint64_t redoBufferNum = (bufferEnd / MEMORY_CHUNK_SIZE) % ctx->readBufferMax;
+            uint64_t redoBufferPos = bufferEnd % ctx->memoryChunkSize;
+            uint64_t redoBufferNum = (bufferEnd / ctx->memoryChunkSize) % ctx->readBufferMax;
 
-            if (redoBufferPos + toRead > MEMORY_CHUNK_SIZE)
-                toRead = MEMORY_CHUNK_SIZE - redoBufferPos;
+            if (redoBufferPos + toRead > ctx->memoryChunkSize)
+                toRead = ctx->memoryChunkSize - redoBufferPos;
 
             if (toRead == 0) {
                 ctx->error(40011, "zero to read (start: " + std::to_string(bufferStart) + ", end: " + std::to_string(bufferEnd) +
@@ -547,12 +698,8 @@ namespace OpenLogReplicator {
                 ret = REDO_ERROR_READ;
                 return false;
             }
-            if (actualRead > 0 && fileCopyDes != -1) {
-                int64_t bytesWritten = pwrite(fileCopyDes, redoBufferList[redoBufferNum] + redoBufferPos, actualRead,
-                                              static_cast<int64_t>(bufferEnd));
-                if (bytesWritten != actualRead) {
-                    ctx->error(10007, "file: " + fileNameWrite + " - " + std::to_string(bytesWritten) +
-                               " bytes written instead of " + std::to_string(actualRead) + ", code returned: " + strerror(errno));
+            if (actualRead > 0 && redoCopy != nullptr && redoCopy->isOpen()) {
+                if (!redoCopy->write(redoBufferList[redoBufferNum] + redoBufferPos, actualRead, bufferEnd)) {
                     ret = REDO_ERROR_WRITE;
                     return false;
                 }
@@ -562,11 +709,14 @@ namespace OpenLogReplicator {
             uint64_t currentRet = REDO_OK;
             maxNumBlock = actualRead / blockSize;
             typeBlk bufferEndBlock = bufferEnd / blockSize;
+            uint64_t sumBlocks = 0;
+            if (!DISABLE_CHECKS(DISABLE_CHECKS_BLOCK_SUM))
+                sumBlocks = BlockSum::verify(redoBufferList[redoBufferNum] + redoBufferPos, blockSize, maxNumBlock);
 
             // Check which blocks are good
             for (uint64_t numBlock = 0; numBlock < maxNumBlock; ++numBlock) {
                 currentRet = checkBlockHeader(redoBufferList[redoBufferNum] + redoBufferPos + numBlock * blockSize,
-                                              bufferEndBlock + numBlock, true);
+                                              bufferEndBlock + numBlock, true, numBlock >= sumBlocks);
                 if (ctx->trace & TRACE_DISK)
                     ctx->logTrace(TRACE_DISK, "block: " + std::to_string(bufferEndBlock + numBlock) + " check: " +
                                   std::to_string(currentRet));
@@ -585,8 +735,11 @@ namespace OpenLogReplicator {
                 return false;
             }
 
+            time_t newWriteTime = statWriteTime();
             {
                 std::unique_lock<std::mutex> lck(mtx);
+                if (newWriteTime != 0)
+                    writeTime = newWriteTime;
                 bufferEnd += actualRead;
                 condParserSleeping.notify_all();
             }
@@ -603,7 +756,8 @@ namespace OpenLogReplicator {
 
                 if (status == READER_STATUS_SLEEPING && !ctx->softShutdown) {
                     condReaderSleeping.wait(lck);
-                } else if (status == READER_STATUS_READ && !ctx->softShutdown && ctx->buffersFree == 0 && (bufferEnd % MEMORY_CHUNK_SIZE) == 0) {
+                } else if (status == READER_STATUS_READ && !ctx->softShutdown && !bufferMapped() && ctx->buffersFree == 0 &&
+                           (bufferEnd % ctx->memoryChunkSize) == 0 && readAheadScan <= bufferEnd) {
                     // Buffer full
                     condBufferFull.wait(lck);
                 }
@@ -626,11 +780,7 @@ namespace OpenLogReplicator {
                 continue;
 
             } else if (status == READER_STATUS_UPDATE) {
-                if (fileCopyDes != -1) {
-                    close(fileCopyDes);
-                    fileCopyDes = -1;
-                }
-
+                // The copy stays open, it is closed by reloadHeader() when the sequence changes
                 sumRead = 0;
                 sumTime = 0;
                 uint64_t currentRet = reloadHeader();
@@ -656,7 +806,13 @@ namespace OpenLogReplicator {
                 lastReadTime = 0;
                 readTime = 0;
                 bufferScan = bufferEnd;
+                readAheadScan = bufferScan;
                 reachedZero = false;
+                tailIdleTime = 0;
+                {
+                    std::unique_lock<std::mutex> lck(mtx);
+                    writeTime = 0;
+                }
 
                 while (!ctx->softShutdown && status == READER_STATUS_READ) {
                     loopTime = Timer::getTime();
@@ -676,9 +832,9 @@ namespace OpenLogReplicator {
                     }
 
                     // Buffer full?
-                    if (bufferStart + ctx->bufferSizeMax == bufferEnd) {
+                    if (bufferStart + bufferSizeLimit <= bufferEnd) {
                         std::unique_lock<std::mutex> lck(mtx);
-                        if (!ctx->softShutdown && bufferStart + ctx->bufferSizeMax == bufferEnd) {
+                        if (!ctx->softShutdown && status == READER_STATUS_READ && bufferStart + bufferSizeLimit <= bufferEnd) {
                             condBufferFull.wait(lck);
                             continue;
                         }
@@ -688,11 +844,16 @@ namespace OpenLogReplicator {
                         if (!read2())
                             break;
 
-                    // #1 read
-                    if (bufferScan < fileSize && (ctx->buffersFree > 0 || (bufferScan % MEMORY_CHUNK_SIZE) > 0)
-                        && (!reachedZero || lastReadTime + static_cast<time_t>(ctx->redoReadSleepUs) < loopTime))
+                    // #1 read, in adaptive mode the next write is awaited by tailWait(), mapped buffers don't use the memory pool
+                    if (bufferScan < fileSize && (bufferMapped() || ctx->buffersFree > 0 || (bufferScan % ctx->memoryChunkSize) > 0 ||
+                                                  readAheadScan > bufferScan)
+                        && (!reachedZero || tailActive() || lastReadTime + static_cast<time_t>(ctx->redoReadSleepUs) < loopTime)) {
+                        // Changes made after this point wake up the reader
+                        if (tailActive())
+                            tailChanged();
                         if (!read1())
                             break;
+                    }
 
                     if (numBlocksHeader != ZERO_BLK && bufferEnd == static_cast<uint64_t>(numBlocksHeader) * blockSize) {
                         if (nextScnHeader != ZERO_SCN) {
@@ -707,9 +868,14 @@ namespace OpenLogReplicator {
                     }
 
                     // Sleep some time
-                    if (!readBlocks) {
+                    if (readBlocks) {
+                        tailIdleTime = 0;
+                    } else {
                         if (readTime == 0) {
-                            usleep(ctx->redoReadSleepUs);
+                            if (tailActive())
+                                tailWait();
+                            else
+                                usleep(ctx->redoReadSleepUs);
                         } else {
                             time_t nowTime = Timer::getTime();
                             if (readTime > nowTime) {
@@ -722,9 +888,14 @@ namespace OpenLogReplicator {
                     }
                 }
 
+                // Buffers might be released after the read is finished
+                redoReadCancel();
+
                 {
                     std::unique_lock<std::mutex> lck(mtx);
-                    status = READER_STATUS_SLEEPING;
+                    // Reading might be interrupted by a new request
+                    if (status == READER_STATUS_READ)
+                        status = READER_STATUS_SLEEPING;
                     condParserSleeping.notify_all();
                 }
             }
@@ -733,15 +904,7 @@ namespace OpenLogReplicator {
 
     typeSum Reader::calcChSum(uint8_t* buffer, uint64_t size) const {
         typeSum oldChSum = ctx->read16(buffer + 14);
-        uint64_t sum = 0;
-
-        for (uint64_t i = 0; i < size / 8; ++i, buffer += 8)
-            sum ^= *(reinterpret_cast<uint64_t*>(buffer));
-        sum ^= (sum >> 32);
-        sum ^= (sum >> 16);
-        sum ^= oldChSum;
-
-        return sum & 0xFFFF;
+        return static_cast<typeSum>(BlockSum::fold(BlockSum::sumXor(buffer, size)) ^ oldChSum);
     }
 
     void Reader::run() {
@@ -762,10 +925,8 @@ namespace OpenLogReplicator {
         }
 
         redoClose();
-        if (fileCopyDes != -1) {
-            close(fileCopyDes);
-            fileCopyDes = -1;
-        }
+        if (redoCopy != nullptr)
+            redoCopy->finish();
 
         if (ctx->trace & TRACE_THREADS) {
             std::ostringstream ss;
@@ -774,15 +935,14 @@ namespace OpenLogReplicator {
         }
     }
 
-    void Reader::bufferAllocate(uint64_t num) {
+    bool Reader::bufferAllocate(uint64_t num, uint64_t offset __attribute__((unused))) {
         if (redoBufferList[num] == nullptr) {
-            redoBufferList[num] = ctx->getMemoryChunk("reader", false);
-            if (ctx->buffersFree == 0)
-                throw RuntimeException(10016, "couldn't allocate " + std::to_string(MEMORY_CHUNK_SIZE) +
-                                       " bytes memory for: read buffer");
+            if (!ctx->allocateBuffer())
+                return false;
 
-            ctx->allocateBuffer();
+            redoBufferList[num] = ctx->getMemoryChunk("reader", false);
         }
+        return true;
     }
 
     void Reader::bufferFree(uint64_t num) {
@@ -793,6 +953,20 @@ namespace OpenLogReplicator {
         }
     }
 
+    uint8_t* Reader::bufferHold(uint64_t num) {
+        // Detach the buffer from the list, so that it is not reused by the reader while still referenced by the parser
+        uint8_t* buffer = redoBufferList[num];
+        redoBufferList[num] = nullptr;
+        return buffer;
+    }
+
+    void Reader::bufferRelease(uint8_t* buffer) {
+        if (buffer != nullptr) {
+            ctx->freeMemoryChunk("reader", buffer, false);
+            ctx->releaseBuffer();
+        }
+    }
+
     void Reader::printHeaderInfo(std::ostringstream& ss, const std::string& path) const {
         char SID[9];
         memcpy(reinterpret_cast<void*>(SID),
@@ -1019,6 +1193,11 @@ namespace OpenLogReplicator {
         return sumTime;
     }
 
+    time_t Reader::getWriteTime() {
+        std::unique_lock<std::mutex> lck(mtx);
+        return writeTime;
+    }
+
     void Reader::setRet(uint64_t newRet) {
         ret = newRet;
     }
@@ -1028,6 +1207,12 @@ namespace OpenLogReplicator {
         bufferEnd = newBufferEnd;
     }
 
+    void Reader::setBufferSizeLimit(uint64_t newBufferSizeLimit) {
+        std::unique_lock<std::mutex> lck(mtx);
+        bufferSizeLimit = newBufferSizeLimit;
+        condBufferFull.notify_all();
+    }
+
     bool Reader::checkRedoLog() {
         std::unique_lock<std::mutex> lck(mtx);
         status = READER_STATUS_CHECK;
@@ -18,6 +18,8 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 <http://www.gnu.org/licenses/>.  */
 
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 
 #include "../common/Thread.h"
@@ -55,14 +57,17 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 
 #define REDO_PAGE_SIZE_MAX      4096
 #define REDO_BAD_CDC_MAX_CNT    20
-#define REDO_READ_VERIFY_MAX_BLOCKS (MEMORY_CHUNK_SIZE/blockSize)
+#define REDO_TAIL_BACKOFF_MIN_US 50
+#define REDO_TAIL_STAT_US       200
 
 namespace OpenLogReplicator {
+    class RedoCopy;
+
     class Reader : public Thread {
     protected:
         Ctx* ctx;
         std::string database;
-        int fileCopyDes;
+        RedoCopy* redoCopy;
         uint64_t fileSize;
         typeSeq fileCopySequence;
         bool hintDisplayed;
@@ -87,15 +92,23 @@ namespace OpenLogReplicator {
         uint64_t sumTime;
         uint64_t bufferScan;
         uint64_t lastRead;
+        uint64_t readAheadScan;
         time_t lastReadTime;
         time_t readTime;
         time_t loopTime;
+        time_t tailIdleTime;
+        time_t tailModifyTime;
+        uint64_t tailBackoffUs;
+        uint64_t tailSize;
 
         std::mutex mtx;
         std::atomic<uint64_t> bufferStart;
         std::atomic<uint64_t> bufferEnd;
+        std::atomic<uint64_t> bufferSizeLimit;
         std::atomic<uint64_t> status;
         std::atomic<uint64_t> ret;
+        // Protected by mtx, set together with bufferEnd
+        time_t writeTime;
         std::condition_variable condBufferFull;
         std::condition_variable condReaderSleeping;
         std::condition_variable condParserSleeping;
@@ -103,10 +116,22 @@ namespace OpenLogReplicator {
         virtual void redoClose() = 0;
         virtual uint64_t redoOpen() = 0;
         virtual int64_t redoRead(uint8_t* buf, uint64_t offset, uint64_t size) = 0;
+        virtual bool redoReadAhead(uint8_t* buf, uint64_t offset, uint64_t size);
+        virtual void redoReadCancel();
+        [[nodiscard]] virtual bool bufferMapped() const;
+        virtual bool redoStat(time_t& modifyTime, uint64_t& size);
         virtual uint64_t readSize(uint64_t lastRead);
         virtual uint64_t reloadHeaderRead();
-        uint64_t checkBlockHeader(uint8_t* buffer, typeBlk blockNumber, bool showHint);
+        uint64_t checkBlockHeader(uint8_t* buffer, typeBlk blockNumber, bool showHint, bool checkSum);
+
         uint64_t reloadHeader();
+        [[nodiscard]] uint64_t readVerifyMaxBlocks() const;
+        [[nodiscard]] bool readAheadActive() const;
+        [[nodiscard]] bool tailActive() const;
+        bool tailChanged();
+        void tailWait();
+        time_t statWriteTime();
+        void readAhead();
         bool read1();
         bool read2();
         void mainLoop();
@@ -123,8 +148,10 @@ namespace OpenLogReplicator {
         void initialize();
         void wakeUp() override;
         void run() override;
-        void bufferAllocate(uint64_t num);
-        void bufferFree(uint64_t num);
+        [[nodiscard]] virtual bool bufferAllocate(uint64_t num, uint64_t offset);
+        virtual void bufferFree(uint64_t num);
+        [[nodiscard]] uint8_t* bufferHold(uint64_t num);
+        virtual void bufferRelease(uint8_t* buffer);
         typeSum calcChSum(uint8_t* buffer, uint64_t size) const;
         void printHeaderInfo(std::ostringstream& ss, const std::string& path) const;
         [[nodiscard]] uint64_t getBlockSize();
@@ -141,9 +168,11 @@ namespace OpenLogReplicator {
         [[nodiscard]] typeActivation getActivation();
         [[nodiscard]] uint64_t getSumRead();
         [[nodiscard]] uint64_t getSumTime();
+        [[nodiscard]] time_t getWriteTime();
 
         void setRet(uint64_t newRet);
         void setBufferStartEnd(uint64_t newBufferStart, uint64_t newBufferEnd);
+        void setBufferSizeLimit(uint64_t newBufferSizeLimit);
         bool checkRedoLog();
         bool updateRedoLog();
         void setStatusRead();
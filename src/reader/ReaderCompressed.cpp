@@ -0,0 +1,416 @@
+/* Class for reading compressed archived redo logs
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#define _LARGEFILE_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../common/Ctx.h"
+#include "../common/Timer.h"
+#include "ReaderCompressed.h"
+
+namespace OpenLogReplicator {
+    const char* ReaderCompressed::COMPRESSION_SUFFIX[4] = {"", ".gz", ".zst", ".lz4"};
+
+    ReaderCompressed::ReaderCompressed(Ctx* newCtx, const std::string& newAlias, const std::string& newDatabase, int64_t newGroup,
+                                       bool newConfiguredBlockSum) :
+        ReaderFilesystem(newCtx, newAlias, newDatabase, newGroup, newConfiguredBlockSum),
+        compression(REDO_COMPRESSION_NONE),
+        inBuffer(nullptr),
+        inPos(0),
+        inSize(0),
+        inOffset(0),
+        inEof(false),
+        frameEnd(false),
+        skipBuffer(nullptr),
+        streamPos(0),
+        headerCacheSize(0) {
+#ifdef LINK_LIBRARY_ZLIB
+        zStreamInitialized = false;
+#endif /* LINK_LIBRARY_ZLIB */
+#ifdef LINK_LIBRARY_ZSTD
+        zstdCtx = nullptr;
+#endif /* LINK_LIBRARY_ZSTD */
+#ifdef LINK_LIBRARY_LZ4
+        lz4Ctx = nullptr;
+#endif /* LINK_LIBRARY_LZ4 */
+    }
+
+    ReaderCompressed::~ReaderCompressed() {
+        ReaderCompressed::redoClose();
+
+        delete[] inBuffer;
+        inBuffer = nullptr;
+        delete[] skipBuffer;
+        skipBuffer = nullptr;
+    }
+
+    uint64_t ReaderCompressed::getCompression(const std::string& name) {
+        for (uint64_t i = REDO_COMPRESSION_GZIP; i <= REDO_COMPRESSION_LZ4; ++i) {
+            uint64_t length = strlen(COMPRESSION_SUFFIX[i]);
+            if (name.length() > length && name.compare(name.length() - length, length, COMPRESSION_SUFFIX[i]) == 0)
+                return i;
+        }
+        return REDO_COMPRESSION_NONE;
+    }
+
+    void ReaderCompressed::redoClose() {
+        streamStop();
+        headerCacheSize = 0;
+
+        ReaderFilesystem::redoClose();
+    }
+
+    uint64_t ReaderCompressed::redoOpen() {
+        compression = getCompression(fileName);
+        if (compression == REDO_COMPRESSION_NONE)
+            return ReaderFilesystem::redoOpen();
+
+#ifndef LINK_LIBRARY_ZLIB
+        if (compression == REDO_COMPRESSION_GZIP) {
+            ctx->error(10070, "file: " + fileName + " - decompression failed: gzip support is not compiled");
+            return REDO_ERROR;
+        }
+#endif /* LINK_LIBRARY_ZLIB */
+#ifndef LINK_LIBRARY_ZSTD
+        if (compression == REDO_COMPRESSION_ZSTD) {
+            ctx->error(10070, "file: " + fileName + " - decompression failed: zstd support is not compiled");
+            return REDO_ERROR;
+        }
+#endif /* LINK_LIBRARY_ZSTD */
+#ifndef LINK_LIBRARY_LZ4
+        if (compression == REDO_COMPRESSION_LZ4) {
+            ctx->error(10070, "file: " + fileName + " - decompression failed: lz4 support is not compiled");
+            return REDO_ERROR;
+        }
+#endif /* LINK_LIBRARY_LZ4 */
+
+        // Compressed data is read once from the beginning to the end, so direct IO is not used
+        fileDes = open(fileName.c_str(), O_RDONLY);
+        if (fileDes == -1) {
+            ctx->error(10001, "file: " + fileName + " - open returned: " + strerror(errno));
+            return REDO_ERROR;
+        }
+#if __linux__
+        posix_fadvise(fileDes, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        if (inBuffer == nullptr)
+            inBuffer = new uint8_t[ctx->memoryChunkSize];
+        if (!streamStart())
+            return REDO_ERROR;
+
+        // The header is read many times, it is kept to avoid restarting decompression
+        int64_t bytes = streamDecompress(headerCache, sizeof(headerCache));
+        if (bytes < 0)
+            return REDO_ERROR;
+        headerCacheSize = bytes;
+
+        // Size of decompressed data is not stored in the file, use the size from the redo log header
+        fileSize = static_cast<uint64_t>(-1);
+        if (headerCacheSize >= 512) {
+            bool bigEndian = (headerCache[28] == 0x7A);
+            auto read32 = [bigEndian](const uint8_t* buf) -> uint32_t {
+                if (bigEndian)
+                    return (static_cast<uint32_t>(buf[0]) << 24) | (static_cast<uint32_t>(buf[1]) << 16) |
+                           (static_cast<uint32_t>(buf[2]) << 8) | static_cast<uint32_t>(buf[3]);
+                return static_cast<uint32_t>(buf[0]) | (static_cast<uint32_t>(buf[1]) << 8) |
+                       (static_cast<uint32_t>(buf[2]) << 16) | (static_cast<uint32_t>(buf[3]) << 24);
+            };
+
+            uint64_t headerBlockSize = read32(headerCache + 20);
+            if ((headerBlockSize == 512 || headerBlockSize == 1024 || headerBlockSize == 4096) && headerCacheSize >= headerBlockSize * 2) {
+                typeBlk headerNumBlocks = read32(headerCache + headerBlockSize + 156);
+                if (headerNumBlocks != ZERO_BLK)
+                    fileSize = static_cast<uint64_t>(headerNumBlocks) * headerBlockSize;
+            }
+        }
+
+        return REDO_OK;
+    }
+
+    bool ReaderCompressed::streamStart() {
+        inPos = 0;
+        inSize = 0;
+        inOffset = 0;
+        inEof = false;
+        frameEnd = false;
+        streamPos = 0;
+
+#ifdef LINK_LIBRARY_ZLIB
+        if (compression == REDO_COMPRESSION_GZIP) {
+            memset(reinterpret_cast<void*>(&zStream), 0, sizeof(zStream));
+            // Gzip header is expected
+            if (inflateInit2(&zStream, 16 + MAX_WBITS) != Z_OK) {
+                ctx->error(10070, "file: " + fileName + " - decompression failed: can't initialize gzip stream");
+                return false;
+            }
+            zStreamInitialized = true;
+        }
+#endif /* LINK_LIBRARY_ZLIB */
+#ifdef LINK_LIBRARY_ZSTD
+        if (compression == REDO_COMPRESSION_ZSTD) {
+            zstdCtx = ZSTD_createDCtx();
+            if (zstdCtx == nullptr) {
+                ctx->error(10070, "file: " + fileName + " - decompression failed: can't create zstd context");
+                return false;
+            }
+        }
+#endif /* LINK_LIBRARY_ZSTD */
+#ifdef LINK_LIBRARY_LZ4
+        if (compression == REDO_COMPRESSION_LZ4) {
+            if (LZ4F_isError(LZ4F_createDecompressionContext(&lz4Ctx, LZ4F_VERSION))) {
+                lz4Ctx = nullptr;
+                ctx->error(10070, "file: " + fileName + " - decompression failed: can't create lz4 context");
+                return false;
+            }
+        }
+#endif /* LINK_LIBRARY_LZ4 */
+
+        return true;
+    }
+
+    void ReaderCompressed::streamStop() {
+#ifdef LINK_LIBRARY_ZLIB
+        if (zStreamInitialized) {
+            inflateEnd(&zStream);
+            zStreamInitialized = false;
+        }
+#endif /* LINK_LIBRARY_ZLIB */
+#ifdef LINK_LIBRARY_ZSTD
+        if (zstdCtx != nullptr) {
+            ZSTD_freeDCtx(zstdCtx);
+            zstdCtx = nullptr;
+        }
+#endif /* LINK_LIBRARY_ZSTD */
+#ifdef LINK_LIBRARY_LZ4
+        if (lz4Ctx != nullptr) {
+            LZ4F_freeDecompressionContext(lz4Ctx);
+            lz4Ctx = nullptr;
+        }
+#endif /* LINK_LIBRARY_LZ4 */
+    }
+
+    bool ReaderCompressed::streamFill() {
+#if __linux__
+        // Compressed data is not read again, so it is not kept in the page cache
+        if (inSize > 0)
+            posix_fadvise(fileDes, static_cast<off_t>(inOffset - inSize), static_cast<off_t>(inSize), POSIX_FADV_DONTNEED);
+#endif
+
+        int64_t bytes;
+        do {
+            bytes = read(fileDes, inBuffer, ctx->memoryChunkSize);
+        } while (bytes == -1 && errno == EINTR);
+
+        if (bytes < 0) {
+            ctx->error(10070, "file: " + fileName + " - decompression failed: read returned: " + strerror(errno));
+            return false;
+        }
+
+        if (ctx->trace & TRACE_FILE)
+            ctx->logTrace(TRACE_FILE, "read " + fileName + ", " + std::to_string(inOffset) + ", " + std::to_string(ctx->memoryChunkSize) +
+                          " returns " + std::to_string(bytes) + " (compressed)");
+
+        inPos = 0;
+        inSize = bytes;
+        inOffset += bytes;
+        if (bytes == 0)
+            inEof = true;
+        return true;
+    }
+
+    bool ReaderCompressed::streamSkip(uint64_t offset) {
+        if (offset < streamPos) {
+            if (ctx->trace & TRACE_FILE)
+                ctx->logTrace(TRACE_FILE, "restarting decompression of " + fileName + " to read from " + std::to_string(offset));
+
+            streamStop();
+            if (lseek(fileDes, 0, SEEK_SET) != 0) {
+                ctx->error(10070, "file: " + fileName + " - decompression failed: lseek returned: " + strerror(errno));
+                return false;
+            }
+            if (!streamStart())
+                return false;
+        }
+
+        if (streamPos < offset && skipBuffer == nullptr)
+            skipBuffer = new uint8_t[ctx->memoryChunkSize];
+
+        // Offsets are aligned to block size and so is the chunk size, the stream is positioned at the block boundary
+        while (streamPos < offset) {
+            uint64_t toSkip = offset - streamPos;
+            if (toSkip > ctx->memoryChunkSize)
+                toSkip = ctx->memoryChunkSize;
+
+            int64_t bytes = streamDecompress(skipBuffer, toSkip);
+            if (bytes < 0)
+                return false;
+            if (bytes == 0)
+                break;
+        }
+
+        return true;
+    }
+
+#if defined(LINK_LIBRARY_ZLIB) || defined(LINK_LIBRARY_ZSTD) || defined(LINK_LIBRARY_LZ4)
+    int64_t ReaderCompressed::streamDecompress(uint8_t* buf, uint64_t size) {
+#else
+    int64_t ReaderCompressed::streamDecompress(uint8_t* buf __attribute__((unused)), uint64_t size) {
+#endif /* defined(LINK_LIBRARY_ZLIB) || defined(LINK_LIBRARY_ZSTD) || defined(LINK_LIBRARY_LZ4) */
+        uint64_t produced = 0;
+
+        while (produced < size) {
+            if (inPos == inSize && !inEof) {
+                if (!streamFill())
+                    return -1;
+                continue;
+            }
+
+            // All frames are complete and there is no more data
+            if (inPos == inSize && frameEnd)
+                break;
+
+            std::string error;
+            uint64_t consumed = 0;
+            uint64_t written = 0;
+
+#ifdef LINK_LIBRARY_ZLIB
+            if (compression == REDO_COMPRESSION_GZIP) {
+                zStream.next_in = inBuffer + inPos;
+                zStream.avail_in = static_cast<uInt>(inSize - inPos);
+                zStream.next_out = buf + produced;
+                zStream.avail_out = static_cast<uInt>(size - produced);
+
+                int zRet = inflate(&zStream, Z_NO_FLUSH);
+                consumed = (inSize - inPos) - zStream.avail_in;
+                written = (size - produced) - zStream.avail_out;
+
+                if (zRet == Z_STREAM_END) {
+                    // Next gzip member might follow
+                    frameEnd = true;
+                    inflateReset(&zStream);
+                } else if (zRet != Z_OK && zRet != Z_BUF_ERROR)
+                    error = (zStream.msg != nullptr) ? zStream.msg : "inflate returned: " + std::to_string(zRet);
+                else if (consumed > 0 || written > 0)
+                    frameEnd = false;
+            }
+#endif /* LINK_LIBRARY_ZLIB */
+#ifdef LINK_LIBRARY_ZSTD
+            if (compression == REDO_COMPRESSION_ZSTD) {
+                ZSTD_inBuffer input = {inBuffer + inPos, static_cast<size_t>(inSize - inPos), 0};
+                ZSTD_outBuffer output = {buf + produced, static_cast<size_t>(size - produced), 0};
+
+                size_t zstdRet = ZSTD_decompressStream(zstdCtx, &output, &input);
+                if (ZSTD_isError(zstdRet))
+                    error = ZSTD_getErrorName(zstdRet);
+                else
+                    frameEnd = (zstdRet == 0);
+                consumed = input.pos;
+                written = output.pos;
+            }
+#endif /* LINK_LIBRARY_ZSTD */
+#ifdef LINK_LIBRARY_LZ4
+            if (compression == REDO_COMPRESSION_LZ4) {
+                size_t srcSize = inSize - inPos;
+                size_t dstSize = size - produced;
+
+                size_t lz4Ret = LZ4F_decompress(lz4Ctx, buf + produced, &dstSize, inBuffer + inPos, &srcSize, nullptr);
+                if (LZ4F_isError(lz4Ret))
+                    error = LZ4F_getErrorName(lz4Ret);
+                else
+                    frameEnd = (lz4Ret == 0);
+                consumed = srcSize;
+                written = dstSize;
+            }
+#endif /* LINK_LIBRARY_LZ4 */
+
+            if (error.length() == 0 && consumed == 0 && written == 0)
+                error = inEof ? "unexpected end of compressed data" : "no progress of decompression";
+
+            if (error.length() > 0) {
+                ctx->error(10070, "file: " + fileName + " - decompression failed: " + error + " at compressed offset: " +
+                           std::to_string(inOffset - inSize + inPos));
+                return -1;
+            }
+
+            inPos += consumed;
+            produced += written;
+            streamPos += written;
+        }
+
+        return static_cast<int64_t>(produced);
+    }
+
+    int64_t ReaderCompressed::redoRead(uint8_t* buf, uint64_t offset, uint64_t size) {
+        if (compression == REDO_COMPRESSION_NONE)
+            return ReaderFilesystem::redoRead(buf, offset, size);
+
+        uint64_t startTime = 0;
+        if (ctx->trace & TRACE_PERFORMANCE)
+            startTime = Timer::getTime();
+
+        uint64_t cached = 0;
+        if (offset < headerCacheSize) {
+            cached = headerCacheSize - offset;
+            if (cached > size)
+                cached = size;
+            memcpy(reinterpret_cast<void*>(buf),
+                   reinterpret_cast<const void*>(headerCache + offset), cached);
+        }
+
+        int64_t bytes = static_cast<int64_t>(cached);
+        if (cached < size) {
+            if (!streamSkip(offset + cached))
+                bytes = -1;
+            else if (streamPos == offset + cached) {
+                // Decompressed directly to the read buffer
+                int64_t bytesDecompressed = streamDecompress(buf + cached, size - cached);
+                if (bytesDecompressed < 0)
+                    bytes = -1;
+                else
+                    bytes += bytesDecompressed;
+            }
+        }
+
+        if (ctx->trace & TRACE_FILE)
+            ctx->logTrace(TRACE_FILE, "read " + fileName + ", " + std::to_string(offset) + ", " + std::to_string(size) +
+                          " returns " + std::to_string(bytes) + " (decompressed)");
+
+        if (ctx->trace & TRACE_PERFORMANCE) {
+            if (bytes > 0)
+                sumRead += bytes;
+            sumTime += Timer::getTime() - startTime;
+        }
+
+        return bytes;
+    }
+
+    bool ReaderCompressed::redoReadAhead(uint8_t* buf, uint64_t offset, uint64_t size) {
+        // Data is decompressed sequentially on demand, it can't be read asynchronously
+        if (compression != REDO_COMPRESSION_NONE)
+            return Reader::redoReadAhead(buf, offset, size);
+
+        return ReaderFilesystem::redoReadAhead(buf, offset, size);
+    }
+}
@@ -0,0 +1,85 @@
+/* Header for ReaderCompressed class
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#ifdef LINK_LIBRARY_ZLIB
+#include <zlib.h>
+#endif /* LINK_LIBRARY_ZLIB */
+#ifdef LINK_LIBRARY_ZSTD
+#include <zstd.h>
+#endif /* LINK_LIBRARY_ZSTD */
+#ifdef LINK_LIBRARY_LZ4
+#include <lz4frame.h>
+#endif /* LINK_LIBRARY_LZ4 */
+
+#include "ReaderFilesystem.h"
+
+#ifndef READER_COMPRESSED_H_
+#define READER_COMPRESSED_H_
+
+#define REDO_COMPRESSION_NONE   0
+#define REDO_COMPRESSION_GZIP   1
+#define REDO_COMPRESSION_ZSTD   2
+#define REDO_COMPRESSION_LZ4    3
+
+namespace OpenLogReplicator {
+    class ReaderCompressed : public ReaderFilesystem {
+    protected:
+        uint64_t compression;
+        uint8_t* inBuffer;
+        uint64_t inPos;
+        uint64_t inSize;
+        uint64_t inOffset;
+        bool inEof;
+        bool frameEnd;
+        uint8_t* skipBuffer;
+        uint64_t streamPos;
+        uint8_t headerCache[REDO_PAGE_SIZE_MAX * 2];
+        uint64_t headerCacheSize;
+#ifdef LINK_LIBRARY_ZLIB
+        z_stream zStream;
+        bool zStreamInitialized;
+#endif /* LINK_LIBRARY_ZLIB */
+#ifdef LINK_LIBRARY_ZSTD
+        ZSTD_DCtx* zstdCtx;
+#endif /* LINK_LIBRARY_ZSTD */
+#ifdef LINK_LIBRARY_LZ4
+        LZ4F_dctx* lz4Ctx;
+#endif /* LINK_LIBRARY_LZ4 */
+
+        void redoClose() override;
+        uint64_t redoOpen() override;
+        int64_t redoRead(uint8_t* buf, uint64_t offset, uint64_t size) override;
+        bool redoReadAhead(uint8_t* buf, uint64_t offset, uint64_t size) override;
+        bool streamStart();
+        void streamStop();
+        bool streamFill();
+        bool streamSkip(uint64_t offset);
+        int64_t streamDecompress(uint8_t* buf, uint64_t size);
+
+    public:
+        const static char* COMPRESSION_SUFFIX[4];
+
+        ReaderCompressed(Ctx* newCtx, const std::string& newAlias, const std::string& newDatabase, int64_t newGroup, bool newConfiguredBlockSum);
+        ~ReaderCompressed() override;
+
+        [[nodiscard]] static uint64_t getCompression(const std::string& name);
+    };
+}
+
+#endif
@@ -27,6 +27,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include <unistd.h>
 
 #include "../common/Ctx.h"
+#include "../common/RuntimeException.h"
 #include "../common/Timer.h"
 #include "ReaderFilesystem.h"
 
@@ -34,14 +35,41 @@ namespace OpenLogReplicator {
     ReaderFilesystem::ReaderFilesystem(Ctx* newCtx, const std::string& newAlias, const std::string& newDatabase, int64_t newGroup, bool newConfiguredBlockSum) :
         Reader(newCtx, newAlias, newDatabase, newGroup, newConfiguredBlockSum),
         fileDes(-1),
+#ifdef LINK_LIBRARY_LIBURING
+        flags(0),
+        ringInitialized(false),
+        requestsFirst(0),
+        requestsCount(0) {
+
+        if (ctx->readEngine == READ_ENGINE_IO_URING && group == 0) {
+            int retInit = io_uring_queue_init(ctx->readQueueDepth, &ring, 0);
+            if (retInit < 0) {
+                ctx->warning(60035, "io_uring initialization returned: " + std::string(strerror(-retInit)) + ", falling back to pread");
+            } else {
+                ringInitialized = true;
+                requests.resize(ctx->readQueueDepth);
+            }
+        }
+    }
+#else
         flags(0) {
     }
+#endif /* LINK_LIBRARY_LIBURING */
 
     ReaderFilesystem::~ReaderFilesystem() {
         ReaderFilesystem::redoClose();
+
+#ifdef LINK_LIBRARY_LIBURING
+        if (ringInitialized) {
+            io_uring_queue_exit(&ring);
+            ringInitialized = false;
+        }
+#endif /* LINK_LIBRARY_LIBURING */
     }
 
     void ReaderFilesystem::redoClose() {
+        ReaderFilesystem::redoReadCancel();
+
         if (fileDes != -1) {
             close(fileDes);
             fileDes = -1;
@@ -80,11 +108,112 @@ namespace OpenLogReplicator {
         return REDO_OK;
     }
 
+    bool ReaderFilesystem::redoStat(time_t& modifyTime, uint64_t& size) {
+        struct stat fileStat;
+        if (fileDes == -1 || fstat(fileDes, &fileStat) != 0)
+            return false;
+
+#if __APPLE__
+        modifyTime = fileStat.st_mtimespec.tv_sec * 1000000 + fileStat.st_mtimespec.tv_nsec / 1000;
+#else
+        modifyTime = fileStat.st_mtim.tv_sec * 1000000 + fileStat.st_mtim.tv_nsec / 1000;
+#endif
+        size = fileStat.st_size;
+        return true;
+    }
+
+#ifdef LINK_LIBRARY_LIBURING
+    void ReaderFilesystem::redoReadReap() {
+        struct io_uring_cqe* cqe;
+        int retWait = io_uring_wait_cqe(&ring, &cqe);
+        if (retWait == -EINTR)
+            return;
+        if (retWait < 0)
+            throw RuntimeException(10067, "file: " + fileName + " - io_uring wait returned: " + strerror(-retWait));
+
+        auto request = reinterpret_cast<ReadRequest*>(io_uring_cqe_get_data(cqe));
+        request->bytes = cqe->res;
+        request->done = true;
+        io_uring_cqe_seen(&ring, cqe);
+    }
+#endif /* LINK_LIBRARY_LIBURING */
+
+    bool ReaderFilesystem::redoReadAhead(uint8_t* buf, uint64_t offset, uint64_t size) {
+#ifdef LINK_LIBRARY_LIBURING
+        if (!ringInitialized || fileDes == -1 || requestsCount == ctx->readQueueDepth)
+            return false;
+
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        if (sqe == nullptr)
+            return false;
+
+        ReadRequest* request = &requests[(requestsFirst + requestsCount) % ctx->readQueueDepth];
+        request->buf = buf;
+        request->offset = offset;
+        request->size = size;
+        request->bytes = 0;
+        request->done = false;
+        io_uring_prep_read(sqe, fileDes, buf, size, offset);
+        io_uring_sqe_set_data(sqe, request);
+
+        int retSubmit = io_uring_submit(&ring);
+        if (retSubmit < 0)
+            throw RuntimeException(10068, "file: " + fileName + " - io_uring submit returned: " + strerror(-retSubmit));
+        ++requestsCount;
+
+        return true;
+#else
+        return Reader::redoReadAhead(buf, offset, size);
+#endif /* LINK_LIBRARY_LIBURING */
+    }
+
+    void ReaderFilesystem::redoReadCancel() {
+#ifdef LINK_LIBRARY_LIBURING
+        // The kernel might still write to the buffers, so wait for all requests in flight
+        while (requestsCount > 0) {
+            while (!requests[requestsFirst].done)
+                redoReadReap();
+
+            requestsFirst = (requestsFirst + 1) % ctx->readQueueDepth;
+            --requestsCount;
+        }
+        readAheadScan = 0;
+#endif /* LINK_LIBRARY_LIBURING */
+    }
+
     int64_t ReaderFilesystem::redoRead(uint8_t* buf, uint64_t offset, uint64_t size) {
         uint64_t startTime = 0;
         if (ctx->trace & TRACE_PERFORMANCE)
             startTime = Timer::getTime();
         int64_t bytes = 0;
+
+#ifdef LINK_LIBRARY_LIBURING
+        if (requestsCount > 0) {
+            ReadRequest* request = &requests[requestsFirst];
+            if (request->buf == buf && request->offset == offset && request->size == size) {
+                while (!request->done)
+                    redoReadReap();
+
+                bytes = request->bytes;
+                requestsFirst = (requestsFirst + 1) % ctx->readQueueDepth;
+                --requestsCount;
+
+                if (ctx->trace & TRACE_FILE)
+                    ctx->logTrace(TRACE_FILE, "read " + fileName + ", " + std::to_string(offset) + ", " + std::to_string(size) +
+                                  " returns " + std::to_string(bytes) + " (io_uring)");
+
+                if (bytes > 0) {
+                    if (ctx->trace & TRACE_PERFORMANCE) {
+                        sumRead += bytes;
+                        sumTime += Timer::getTime() - startTime;
+                    }
+                    return bytes;
+                }
+                // Failed asynchronous read, retry using pread
+            } else
+                redoReadCancel();
+        }
+#endif /* LINK_LIBRARY_LIBURING */
         uint64_t tries = ctx->archReadTries;
 
         while (tries > 0) {
@@ -17,19 +17,43 @@ You should have received a copy of the GNU General Public License
 along with OpenLogReplicator; see the file LICENSE;  If not see
 <http://www.gnu.org/licenses/>.  */
 
+#ifdef LINK_LIBRARY_LIBURING
+#include <liburing.h>
+#endif /* LINK_LIBRARY_LIBURING */
+
 #include "Reader.h"
 
 #ifndef READER_FILESYSTEM_H_
 #define READER_FILESYSTEM_H_
 
 namespace OpenLogReplicator {
+    struct ReadRequest {
+        uint8_t* buf;
+        uint64_t offset;
+        uint64_t size;
+        int64_t bytes;
+        bool done;
+    };
+
     class ReaderFilesystem : public Reader {
     protected:
         int fileDes;
         int flags;
+#ifdef LINK_LIBRARY_LIBURING
+        struct io_uring ring;
+        bool ringInitialized;
+        std::vector<ReadRequest> requests;
+        uint64_t requestsFirst;
+        uint64_t requestsCount;
+
+        void redoReadReap();
+#endif /* LINK_LIBRARY_LIBURING */
         void redoClose() override;
         uint64_t redoOpen() override;
         int64_t redoRead(uint8_t* buf, uint64_t offset, uint64_t size) override;
+        bool redoReadAhead(uint8_t* buf, uint64_t offset, uint64_t size) override;
+        void redoReadCancel() override;
+        bool redoStat(time_t& modifyTime, uint64_t& size) override;
 
     public:
         ReaderFilesystem(Ctx* newCtx, const std::string& newAlias, const std::string& newDatabase, int64_t newGroup, bool newConfiguredBlockSum);
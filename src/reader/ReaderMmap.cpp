@@ -0,0 +1,197 @@
+/* Class for reading archived redo logs using memory mapped files
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#define _LARGEFILE_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/Ctx.h"
+#include "../common/Timer.h"
+#include "ReaderCompressed.h"
+#include "ReaderMmap.h"
+
+namespace OpenLogReplicator {
+    ReaderMmap::ReaderMmap(Ctx* newCtx, const std::string& newAlias, const std::string& newDatabase, int64_t newGroup, bool newConfiguredBlockSum) :
+        Reader(newCtx, newAlias, newDatabase, newGroup, newConfiguredBlockSum),
+        fileDes(-1),
+        map(nullptr),
+        mapSize(0) {
+    }
+
+    ReaderMmap::~ReaderMmap() {
+        ReaderMmap::redoClose();
+    }
+
+    void ReaderMmap::redoClose() {
+        if (map != nullptr) {
+            // Buffers point to the mapped file, the mapping is released here
+            for (uint64_t num = 0; num < ctx->readBufferMax; ++num) {
+                if (redoBufferList[num] >= map && redoBufferList[num] < map + mapSize)
+                    redoBufferList[num] = nullptr;
+            }
+
+            munmap(map, mapSize);
+            map = nullptr;
+            mapSize = 0;
+        }
+
+        if (fileDes != -1) {
+            close(fileDes);
+            fileDes = -1;
+        }
+    }
+
+    uint64_t ReaderMmap::redoOpen() {
+        struct stat fileStat;
+
+        if (ReaderCompressed::getCompression(fileName) != REDO_COMPRESSION_NONE) {
+            ctx->error(10070, "file: " + fileName + " - decompression failed: compressed file can't be memory mapped");
+            ctx->hint("set reader parameter 'read-engine' to 'pread' or 'io-uring' to read compressed archived redo logs");
+            return REDO_ERROR;
+        }
+
+        if (stat(fileName.c_str(), &fileStat) != 0) {
+            ctx->error(10003, "file: " + fileName + " - stat returned: " + strerror(errno));
+            return REDO_ERROR;
+        }
+
+        fileSize = fileStat.st_size;
+        fileDes = open(fileName.c_str(), O_RDONLY);
+        if (fileDes == -1) {
+            ctx->error(10001, "file: " + fileName + " - open returned: " + strerror(errno));
+            return REDO_ERROR;
+        }
+
+        if (fileSize == 0)
+            return REDO_OK;
+
+        // Private writable mapping, so that accidental modification of the data never reaches the file
+        void* mapAddress = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileDes, 0);
+        if (mapAddress == MAP_FAILED) {
+            ctx->error(10069, "file: " + fileName + " - mmap returned: " + strerror(errno));
+            return REDO_ERROR;
+        }
+        map = reinterpret_cast<uint8_t*>(mapAddress);
+        mapSize = fileSize;
+
+        if (madvise(map, mapSize, MADV_SEQUENTIAL) != 0)
+            ctx->warning(60036, "file: " + fileName + " - madvise returned: " + strerror(errno));
+
+        return REDO_OK;
+    }
+
+    int64_t ReaderMmap::redoRead(uint8_t* buf, uint64_t offset, uint64_t size) {
+        uint64_t startTime = 0;
+        if (ctx->trace & TRACE_PERFORMANCE)
+            startTime = Timer::getTime();
+
+        if (offset >= mapSize)
+            return 0;
+        if (offset + size > mapSize)
+            size = mapSize - offset;
+        if (!mapValid(offset, size))
+            return -1;
+
+        // Buffers allocated by bufferAllocate() already point to the mapped data
+        if (buf != map + offset)
+            memcpy(reinterpret_cast<void*>(buf),
+                   reinterpret_cast<const void*>(map + offset), size);
+
+        if (ctx->trace & TRACE_FILE)
+            ctx->logTrace(TRACE_FILE, "read " + fileName + ", " + std::to_string(offset) + ", " + std::to_string(size) +
+                          " returns " + std::to_string(size) + " (mmap)");
+
+        if (ctx->trace & TRACE_PERFORMANCE) {
+            sumRead += size;
+            sumTime += Timer::getTime() - startTime;
+        }
+
+        return static_cast<int64_t>(size);
+    }
+
+    bool ReaderMmap::redoReadAhead(uint8_t* buf, uint64_t offset, uint64_t size) {
+        if (!mapValid(offset, size))
+            return false;
+
+        // Start asynchronous page-in of the data which is going to be checked next
+        uint64_t pageOffset = reinterpret_cast<uintptr_t>(buf) % static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        madvise(buf - pageOffset, size + pageOffset, MADV_WILLNEED);
+        return true;
+    }
+
+    bool ReaderMmap::bufferMapped() const {
+        return map != nullptr;
+    }
+
+    bool ReaderMmap::mapValid(uint64_t offset, uint64_t size) {
+        // Access to a mapped page past the end of a truncated file raises SIGBUS, so the size is checked first
+        struct stat fileStat;
+        if (fstat(fileDes, &fileStat) != 0) {
+            ctx->error(10003, "file: " + fileName + " - stat returned: " + strerror(errno));
+            return false;
+        }
+
+        if (static_cast<uint64_t>(fileStat.st_size) < offset + size) {
+            ctx->error(10078, "file: " + fileName + " - size changed from: " + std::to_string(mapSize) + " to: " +
+                       std::to_string(fileStat.st_size) + " while memory mapped");
+            return false;
+        }
+        return true;
+    }
+
+    bool ReaderMmap::bufferAllocate(uint64_t num, uint64_t offset) {
+        if (map == nullptr)
+            return Reader::bufferAllocate(num, offset);
+
+        redoBufferList[num] = map + (offset / ctx->memoryChunkSize) * ctx->memoryChunkSize;
+        return true;
+    }
+
+    void ReaderMmap::bufferFree(uint64_t num) {
+        if (redoBufferList[num] != nullptr && redoBufferList[num] >= map && redoBufferList[num] < map + mapSize) {
+            // Release processed pages, they are not going to be read again
+            uint64_t length = ctx->memoryChunkSize;
+            if (redoBufferList[num] + length > map + mapSize)
+                length = map + mapSize - redoBufferList[num];
+            madvise(redoBufferList[num], length, MADV_DONTNEED);
+            redoBufferList[num] = nullptr;
+            return;
+        }
+
+        Reader::bufferFree(num);
+    }
+
+    void ReaderMmap::bufferRelease(uint8_t* buffer) {
+        if (buffer != nullptr && buffer >= map && buffer < map + mapSize) {
+            uint64_t length = ctx->memoryChunkSize;
+            if (buffer + length > map + mapSize)
+                length = map + mapSize - buffer;
+            madvise(buffer, length, MADV_DONTNEED);
+            return;
+        }
+
+        Reader::bufferRelease(buffer);
+    }
+}
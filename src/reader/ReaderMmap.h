@@ -0,0 +1,48 @@
+/* Header for ReaderMmap class
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include "Reader.h"
+
+#ifndef READER_MMAP_H_
+#define READER_MMAP_H_
+
+namespace OpenLogReplicator {
+    class ReaderMmap : public Reader {
+    protected:
+        int fileDes;
+        uint8_t* map;
+        uint64_t mapSize;
+        void redoClose() override;
+        uint64_t redoOpen() override;
+        int64_t redoRead(uint8_t* buf, uint64_t offset, uint64_t size) override;
+        bool redoReadAhead(uint8_t* buf, uint64_t offset, uint64_t size) override;
+        [[nodiscard]] bool bufferMapped() const override;
+        [[nodiscard]] bool mapValid(uint64_t offset, uint64_t size);
+
+    public:
+        ReaderMmap(Ctx* newCtx, const std::string& newAlias, const std::string& newDatabase, int64_t newGroup, bool newConfiguredBlockSum);
+        ~ReaderMmap() override;
+
+        [[nodiscard]] bool bufferAllocate(uint64_t num, uint64_t offset) override;
+        void bufferFree(uint64_t num) override;
+        void bufferRelease(uint8_t* buffer) override;
+    };
+}
+
+#endif
@@ -0,0 +1,295 @@
+/* Thread writing copy of redo log files
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+
+#include "../common/Ctx.h"
+#include "../common/RuntimeException.h"
+#include "RedoCopy.h"
+#include "RedoCopyCompress.h"
+
+namespace OpenLogReplicator {
+    std::mutex RedoCopy::compressedMtx;
+    std::set<std::string> RedoCopy::compressedFiles;
+
+    RedoCopy::RedoCopy(Ctx* newCtx, const std::string& newAlias, uint64_t newBufferSize) :
+            Thread(newCtx, newAlias),
+            buffer(nullptr),
+            bufferSize(newBufferSize),
+            bufferStart(0),
+            bufferUsed(0),
+            stop(false),
+            failed(false),
+            opened(false),
+            fileDes(-1),
+            compressor(nullptr) {
+
+        buffer = reinterpret_cast<uint8_t*>(aligned_alloc(MEMORY_ALIGNMENT, bufferSize));
+        if (buffer == nullptr)
+            throw RuntimeException(10016, "couldn't allocate " + std::to_string(bufferSize) + " bytes memory for: redo log copy");
+    }
+
+    RedoCopy::~RedoCopy() {
+        if (fileDes != -1) {
+            ::close(fileDes);
+            fileDes = -1;
+        }
+
+        if (buffer != nullptr) {
+            free(buffer);
+            buffer = nullptr;
+        }
+    }
+
+    void RedoCopy::wakeUp() {
+        std::unique_lock<std::mutex> lck(mtx);
+        condQueueFull.notify_all();
+        condQueueEmpty.notify_all();
+    }
+
+    void RedoCopy::open(const std::string& newFileName) {
+        std::unique_lock<std::mutex> lck(mtx);
+        requests.push_back({REDO_COPY_OPEN, 0, 0, 0, newFileName});
+        opened = true;
+        condQueueEmpty.notify_all();
+    }
+
+    bool RedoCopy::isOpen() const {
+        return opened;
+    }
+
+    bool RedoCopy::write(const uint8_t* data, uint64_t size, uint64_t offset) {
+        while (size > 0) {
+            uint64_t toWrite = std::min(size, bufferSize);
+            uint64_t pos;
+            {
+                std::unique_lock<std::mutex> lck(mtx);
+                // The reader is blocked only when the copy can't keep up
+                while (bufferSize - bufferUsed < toWrite && !failed && !finished && !ctx->softShutdown)
+                    condQueueFull.wait(lck);
+
+                if (failed)
+                    return false;
+                if (finished || ctx->softShutdown)
+                    return true;
+                pos = (bufferStart + bufferUsed) % bufferSize;
+            }
+
+            // Only the reader thread adds data, the free space can't be taken by anybody else
+            uint64_t toCopy = std::min(toWrite, bufferSize - pos);
+            memcpy(reinterpret_cast<void*>(buffer + pos), reinterpret_cast<const void*>(data), toCopy);
+            if (toCopy < toWrite)
+                memcpy(reinterpret_cast<void*>(buffer), reinterpret_cast<const void*>(data + toCopy), toWrite - toCopy);
+
+            {
+                std::unique_lock<std::mutex> lck(mtx);
+                bufferUsed += toWrite;
+                requests.push_back({REDO_COPY_WRITE, offset, pos, toWrite, ""});
+                condQueueEmpty.notify_all();
+            }
+
+            data += toWrite;
+            offset += toWrite;
+            size -= toWrite;
+        }
+        return true;
+    }
+
+    void RedoCopy::close() {
+        std::unique_lock<std::mutex> lck(mtx);
+        if (!opened)
+            return;
+        requests.push_back({REDO_COPY_CLOSE, 0, 0, 0, ""});
+        opened = false;
+        condQueueEmpty.notify_all();
+    }
+
+    void RedoCopy::finish() {
+        // The last copy is left open, so that it is not compressed before it is complete
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            stop = true;
+            condQueueEmpty.notify_all();
+        }
+        ctx->finishThread(this);
+    }
+
+    void RedoCopy::run() {
+        if (ctx->trace & TRACE_THREADS) {
+            std::ostringstream ss;
+            ss << std::this_thread::get_id();
+            ctx->logTrace(TRACE_THREADS, "redo copy (" + ss.str() + ") start");
+        }
+
+        try {
+            if (ctx->redoCopyCompression != REDO_COPY_COMPRESSION_NONE) {
+                compressor = new RedoCopyCompress(ctx, alias + "-compress");
+                ctx->spawnThread(compressor);
+            }
+            mainLoop();
+        } catch (RuntimeException& ex) {
+            ctx->error(ex.code, ex.msg);
+        }
+
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            failed = true;
+            condQueueFull.notify_all();
+        }
+        fileClose(false);
+
+        if (compressor != nullptr) {
+            compressor->finish();
+            delete compressor;
+            compressor = nullptr;
+        }
+
+        if (ctx->trace & TRACE_THREADS) {
+            std::ostringstream ss;
+            ss << std::this_thread::get_id();
+            ctx->logTrace(TRACE_THREADS, "redo copy (" + ss.str() + ") stop");
+        }
+    }
+
+    void RedoCopy::mainLoop() {
+        for (;;) {
+            uint64_t type;
+            uint64_t requestsCount = 1;
+            std::string newFileName;
+            {
+                std::unique_lock<std::mutex> lck(mtx);
+                // Queued data is written also after shutdown is requested
+                while (requests.empty() && !stop && !ctx->softShutdown)
+                    condQueueEmpty.wait(lck);
+
+                if (requests.empty())
+                    return;
+
+                type = requests.front().type;
+                if (type == REDO_COPY_OPEN)
+                    newFileName = requests.front().fileName;
+                else if (type == REDO_COPY_WRITE) {
+                    // Consecutive writes are joined into one call
+                    uint64_t iovCount = (requests.front().pos + requests.front().size > bufferSize) ? 2 : 1;
+                    uint64_t offsetNext = requests.front().offset + requests.front().size;
+                    while (requestsCount < requests.size()) {
+                        const RedoCopyRequest& request = requests[requestsCount];
+                        uint64_t iovNeeded = (request.pos + request.size > bufferSize) ? 2 : 1;
+                        if (request.type != REDO_COPY_WRITE || request.offset != offsetNext || iovCount + iovNeeded > IOV_MAX)
+                            break;
+                        iovCount += iovNeeded;
+                        offsetNext += request.size;
+                        ++requestsCount;
+                    }
+                }
+            }
+
+            if (type == REDO_COPY_OPEN)
+                fileOpen(newFileName);
+            else if (type == REDO_COPY_WRITE)
+                fileWrite(requestsCount);
+            else
+                fileClose(true);
+
+            {
+                std::unique_lock<std::mutex> lck(mtx);
+                for (uint64_t i = 0; i < requestsCount; ++i) {
+                    if (requests.front().type == REDO_COPY_WRITE) {
+                        bufferStart = (bufferStart + requests.front().size) % bufferSize;
+                        bufferUsed -= requests.front().size;
+                    }
+                    requests.pop_front();
+                }
+                condQueueFull.notify_all();
+            }
+        }
+    }
+
+    void RedoCopy::fileOpen(const std::string& newFileName) {
+        fileClose(true);
+
+        fileName = newFileName;
+        if (compressor != nullptr) {
+            std::unique_lock<std::mutex> lck(compressedMtx);
+            if (compressedFiles.find(fileName) != compressedFiles.end()) {
+                // The source file may be already removed by compression, data for this copy is ignored
+                ctx->info(0, "redo log copy: " + fileName + " is already compressed, not written again");
+                return;
+            }
+        }
+
+        fileDes = ::open(fileName.c_str(), O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
+        if (fileDes == -1)
+            throw RuntimeException(10006, "file: " + fileName + " - open for write returned: " + strerror(errno));
+        ctx->info(0, "writing redo log copy to: " + fileName);
+    }
+
+    void RedoCopy::fileWrite(uint64_t requestsCount) {
+        struct iovec iov[IOV_MAX];
+        uint64_t iovCount = 0;
+        uint64_t offset;
+        uint64_t size = 0;
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            offset = requests.front().offset;
+            for (uint64_t i = 0; i < requestsCount; ++i) {
+                const RedoCopyRequest& request = requests[i];
+                uint64_t toCopy = std::min(request.size, bufferSize - request.pos);
+                iov[iovCount].iov_base = buffer + request.pos;
+                iov[iovCount++].iov_len = toCopy;
+                if (toCopy < request.size) {
+                    iov[iovCount].iov_base = buffer;
+                    iov[iovCount++].iov_len = request.size - toCopy;
+                }
+                size += request.size;
+            }
+        }
+
+        if (fileDes == -1)
+            return;
+
+        int64_t bytesWritten = pwritev(fileDes, iov, static_cast<int>(iovCount), static_cast<off_t>(offset));
+        if (bytesWritten != static_cast<int64_t>(size))
+            throw RuntimeException(10007, "file: " + fileName + " - " + std::to_string(bytesWritten) + " bytes written instead of " +
+                                   std::to_string(size) + ", code returned: " + strerror(errno));
+    }
+
+    void RedoCopy::fileClose(bool compress) {
+        if (fileDes == -1)
+            return;
+
+        ::close(fileDes);
+        fileDes = -1;
+        // The copy is closed when the reader switches to the next sequence, it is not opened again after it is compressed
+        if (compress && compressor != nullptr) {
+            {
+                std::unique_lock<std::mutex> lck(compressedMtx);
+                compressedFiles.insert(fileName);
+            }
+            compressor->push(fileName);
+        }
+    }
+}
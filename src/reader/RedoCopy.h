@@ -0,0 +1,85 @@
+/* Header for RedoCopy class
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+
+#include "../common/Thread.h"
+
+#ifndef REDO_COPY_H_
+#define REDO_COPY_H_
+
+#define REDO_COPY_OPEN                  0
+#define REDO_COPY_WRITE                 1
+#define REDO_COPY_CLOSE                 2
+
+namespace OpenLogReplicator {
+    class RedoCopyCompress;
+
+    struct RedoCopyRequest {
+        uint64_t type;
+        uint64_t offset;
+        uint64_t pos;
+        uint64_t size;
+        std::string fileName;
+    };
+
+    class RedoCopy : public Thread {
+    protected:
+        // Copies passed to compression, shared by copies of all readers, since the archived and the online reader can copy the same sequence
+        static std::mutex compressedMtx;
+        static std::set<std::string> compressedFiles;
+
+        std::mutex mtx;
+        std::condition_variable condQueueFull;
+        std::condition_variable condQueueEmpty;
+        std::deque<RedoCopyRequest> requests;
+        uint8_t* buffer;
+        uint64_t bufferSize;
+        uint64_t bufferStart;
+        uint64_t bufferUsed;
+        bool stop;
+        bool failed;
+        bool opened;
+        int fileDes;
+        std::string fileName;
+        RedoCopyCompress* compressor;
+
+        void run() override;
+        void mainLoop();
+        void fileOpen(const std::string& newFileName);
+        void fileWrite(uint64_t requestsCount);
+        void fileClose(bool compress);
+
+    public:
+        RedoCopy(Ctx* newCtx, const std::string& newAlias, uint64_t newBufferSize);
+        ~RedoCopy() override;
+
+        void wakeUp() override;
+        void open(const std::string& newFileName);
+        [[nodiscard]] bool isOpen() const;
+        [[nodiscard]] bool write(const uint8_t* data, uint64_t size, uint64_t offset);
+        void close();
+        void finish();
+    };
+}
+
+#endif
@@ -0,0 +1,220 @@
+/* Thread compressing redo log copies
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+#ifdef LINK_LIBRARY_ZSTD
+#include <zstd.h>
+#endif /* LINK_LIBRARY_ZSTD */
+#ifdef LINK_LIBRARY_LZ4
+#include <lz4frame.h>
+#endif /* LINK_LIBRARY_LZ4 */
+
+#include "../common/Ctx.h"
+#include "RedoCopyCompress.h"
+
+namespace OpenLogReplicator {
+    RedoCopyCompress::RedoCopyCompress(Ctx* newCtx, const std::string& newAlias) :
+            Thread(newCtx, newAlias),
+            stop(false) {
+    }
+
+    RedoCopyCompress::~RedoCopyCompress() {
+        files.clear();
+    }
+
+    void RedoCopyCompress::wakeUp() {
+        std::unique_lock<std::mutex> lck(mtx);
+        condFiles.notify_all();
+    }
+
+    void RedoCopyCompress::push(const std::string& fileName) {
+        std::unique_lock<std::mutex> lck(mtx);
+        files.push_back(fileName);
+        condFiles.notify_all();
+    }
+
+    void RedoCopyCompress::finish() {
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            stop = true;
+            condFiles.notify_all();
+        }
+        ctx->finishThread(this);
+    }
+
+    void RedoCopyCompress::run() {
+        if (ctx->trace & TRACE_THREADS) {
+            std::ostringstream ss;
+            ss << std::this_thread::get_id();
+            ctx->logTrace(TRACE_THREADS, "redo copy compress (" + ss.str() + ") start");
+        }
+
+        for (;;) {
+            std::string fileName;
+            {
+                std::unique_lock<std::mutex> lck(mtx);
+                // Copies which are already complete are compressed also after shutdown is requested
+                while (files.empty() && !stop && !ctx->softShutdown)
+                    condFiles.wait(lck);
+
+                if (files.empty() || ctx->hardShutdown)
+                    break;
+                fileName = files.front();
+                files.pop_front();
+            }
+
+            compress(fileName);
+        }
+
+        if (ctx->trace & TRACE_THREADS) {
+            std::ostringstream ss;
+            ss << std::this_thread::get_id();
+            ctx->logTrace(TRACE_THREADS, "redo copy compress (" + ss.str() + ") stop");
+        }
+    }
+
+    void RedoCopyCompress::compress(const std::string& fileName) {
+        std::string fileNameCompressed;
+        if (ctx->redoCopyCompression == REDO_COPY_COMPRESSION_ZSTD)
+            fileNameCompressed = fileName + ".zst";
+        else
+            fileNameCompressed = fileName + ".lz4";
+
+        int fileDesIn = ::open(fileName.c_str(), O_RDONLY);
+        if (fileDesIn == -1) {
+            ctx->warning(60037, "file: " + fileName + " - open for read returned: " + strerror(errno) + ", copy is not compressed");
+            return;
+        }
+        int fileDesOut = ::open(fileNameCompressed.c_str(), O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (fileDesOut == -1) {
+            ctx->warning(60037, "file: " + fileNameCompressed + " - open for write returned: " + strerror(errno) + ", copy is not compressed");
+            ::close(fileDesIn);
+            return;
+        }
+
+        std::string error = "compression is not compiled";
+        uint8_t* bufferIn = new uint8_t[ctx->memoryChunkSize];
+        uint8_t* bufferOut = nullptr;
+        uint64_t bufferOutSize = 0;
+
+#ifdef LINK_LIBRARY_ZSTD
+        ZSTD_CCtx* zstdCtx = nullptr;
+        if (ctx->redoCopyCompression == REDO_COPY_COMPRESSION_ZSTD) {
+            zstdCtx = ZSTD_createCCtx();
+            bufferOutSize = ZSTD_CStreamOutSize();
+            error = (zstdCtx != nullptr) ? "" : "compression context not created";
+        }
+#endif /* LINK_LIBRARY_ZSTD */
+#ifdef LINK_LIBRARY_LZ4
+        LZ4F_cctx* lz4Ctx = nullptr;
+        if (ctx->redoCopyCompression == REDO_COPY_COMPRESSION_LZ4) {
+            if (LZ4F_isError(LZ4F_createCompressionContext(&lz4Ctx, LZ4F_VERSION)))
+                lz4Ctx = nullptr;
+            bufferOutSize = LZ4F_compressBound(ctx->memoryChunkSize, nullptr) + LZ4F_HEADER_SIZE_MAX;
+            error = (lz4Ctx != nullptr) ? "" : "compression context not created";
+        }
+#endif /* LINK_LIBRARY_LZ4 */
+        if (bufferOutSize > 0)
+            bufferOut = new uint8_t[bufferOutSize];
+
+#ifdef LINK_LIBRARY_LZ4
+        if (lz4Ctx != nullptr) {
+            size_t lz4Ret = LZ4F_compressBegin(lz4Ctx, bufferOut, bufferOutSize, nullptr);
+            if (LZ4F_isError(lz4Ret))
+                error = LZ4F_getErrorName(lz4Ret);
+            else if (::write(fileDesOut, bufferOut, lz4Ret) != static_cast<int64_t>(lz4Ret))
+                error = strerror(errno);
+        }
+#endif /* LINK_LIBRARY_LZ4 */
+
+        while (error.length() == 0) {
+            if (ctx->hardShutdown) {
+                error = "shutdown";
+                break;
+            }
+
+            int64_t bytesRead = ::read(fileDesIn, bufferIn, ctx->memoryChunkSize);
+            if (bytesRead < 0) {
+                error = strerror(errno);
+                break;
+            }
+
+#ifdef LINK_LIBRARY_ZSTD
+            if (zstdCtx != nullptr) {
+                ZSTD_EndDirective mode = (bytesRead == 0) ? ZSTD_e_end : ZSTD_e_continue;
+                ZSTD_inBuffer input = {bufferIn, static_cast<size_t>(bytesRead), 0};
+                bool finishedFrame;
+                do {
+                    ZSTD_outBuffer output = {bufferOut, bufferOutSize, 0};
+                    size_t zstdRet = ZSTD_compressStream2(zstdCtx, &output, &input, mode);
+                    if (ZSTD_isError(zstdRet)) {
+                        error = ZSTD_getErrorName(zstdRet);
+                        break;
+                    }
+                    if (::write(fileDesOut, bufferOut, output.pos) != static_cast<int64_t>(output.pos)) {
+                        error = strerror(errno);
+                        break;
+                    }
+                    finishedFrame = (mode == ZSTD_e_end) ? (zstdRet == 0) : (input.pos == input.size);
+                } while (!finishedFrame);
+            }
+#endif /* LINK_LIBRARY_ZSTD */
+#ifdef LINK_LIBRARY_LZ4
+            if (lz4Ctx != nullptr) {
+                size_t lz4Ret;
+                if (bytesRead > 0)
+                    lz4Ret = LZ4F_compressUpdate(lz4Ctx, bufferOut, bufferOutSize, bufferIn, bytesRead, nullptr);
+                else
+                    lz4Ret = LZ4F_compressEnd(lz4Ctx, bufferOut, bufferOutSize, nullptr);
+                if (LZ4F_isError(lz4Ret))
+                    error = LZ4F_getErrorName(lz4Ret);
+                else if (::write(fileDesOut, bufferOut, lz4Ret) != static_cast<int64_t>(lz4Ret))
+                    error = strerror(errno);
+            }
+#endif /* LINK_LIBRARY_LZ4 */
+            if (bytesRead == 0)
+                break;
+        }
+
+#ifdef LINK_LIBRARY_ZSTD
+        if (zstdCtx != nullptr)
+            ZSTD_freeCCtx(zstdCtx);
+#endif /* LINK_LIBRARY_ZSTD */
+#ifdef LINK_LIBRARY_LZ4
+        if (lz4Ctx != nullptr)
+            LZ4F_freeCompressionContext(lz4Ctx);
+#endif /* LINK_LIBRARY_LZ4 */
+        delete[] bufferIn;
+        delete[] bufferOut;
+        ::close(fileDesIn);
+        ::close(fileDesOut);
+
+        if (error.length() > 0) {
+            ctx->warning(60037, "file: " + fileNameCompressed + " - compression failed: " + error + ", copy is not compressed");
+            unlink(fileNameCompressed.c_str());
+            return;
+        }
+        unlink(fileName.c_str());
+        ctx->info(0, "redo log copy compressed to: " + fileNameCompressed);
+    }
+}
@@ -0,0 +1,51 @@
+/* Header for RedoCopyCompress class
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "../common/Thread.h"
+
+#ifndef REDO_COPY_COMPRESS_H_
+#define REDO_COPY_COMPRESS_H_
+
+namespace OpenLogReplicator {
+    // Compresses complete redo log copies, so that the copy thread keeps draining the ring buffer after a log switch
+    class RedoCopyCompress : public Thread {
+    protected:
+        std::mutex mtx;
+        std::condition_variable condFiles;
+        std::deque<std::string> files;
+        bool stop;
+
+        void run() override;
+        void compress(const std::string& fileName);
+
+    public:
+        RedoCopyCompress(Ctx* newCtx, const std::string& newAlias);
+        ~RedoCopyCompress() override;
+
+        void wakeUp() override;
+        void push(const std::string& fileName);
+        void finish();
+    };
+}
+
+#endif
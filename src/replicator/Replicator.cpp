@@ -19,6 +19,10 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 
 #include <cerrno>
 #include <dirent.h>
+#if __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
 #include <sys/stat.h>
 #include <thread>
 #include <unistd.h>
@@ -33,9 +37,11 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include "../metadata/Metadata.h"
 #include "../metadata/Schema.h"
 #include "../parser/Parser.h"
+#include "../parser/ParserWorker.h"
 #include "../parser/Transaction.h"
 #include "../parser/TransactionBuffer.h"
-#include "../reader/ReaderFilesystem.h"
+#include "../reader/ReaderCompressed.h"
+#include "../reader/ReaderMmap.h"
 #include "Replicator.h"
 
 namespace OpenLogReplicator {
@@ -47,11 +53,16 @@ namespace OpenLogReplicator {
             metadata(newMetadata),
             transactionBuffer(newTransactionBuffer),
             database(newDatabase),
-            archReader(nullptr) {
+            archReader(nullptr),
+            archWatchDes(-1),
+            archWatchRootWd(-1),
+            archWatchRescan(false),
+            archWatchDisabled(false) {
     }
 
     Replicator::~Replicator() {
         readerDropAll();
+        archWatchClose();
 
         if (transactionBuffer != nullptr)
             transactionBuffer->purge();
@@ -92,6 +103,14 @@ namespace OpenLogReplicator {
     }
 
     void Replicator::readerDropAll(void) {
+        // Catch-up workers read using the readers
+        for (auto archWorkerMapIt : archWorkerMap) {
+            archWorkerMapIt.second->cancel();
+            ctx->finishThread(archWorkerMapIt.second);
+            delete archWorkerMapIt.second;
+        }
+        archWorkerMap.clear();
+
         bool wakingUp;
         for (;;) {
             wakingUp = false;
@@ -114,6 +133,8 @@ namespace OpenLogReplicator {
         }
 
         archReader = nullptr;
+        archReaders.clear();
+        archPrefetchMap.clear();
         readers.clear();
     }
 
@@ -249,7 +270,16 @@ namespace OpenLogReplicator {
 
         ctx->replicatorFinished = true;
         ctx->info(0, "Oracle replicator for: " + database + " allocated at most " + std::to_string(ctx->getMaxUsedMemory()) +
-                  "MB memory, max disk read buffer: " + std::to_string(ctx->buffersMaxUsed * MEMORY_CHUNK_SIZE_MB) + "MB");
+                  "MB memory, max disk read buffer: " + std::to_string(ctx->buffersMaxUsed * ctx->memoryChunkSizeMb) + "MB");
+        if (ctx->memoryHugePages != MEMORY_HUGE_PAGES_NONE || ctx->memoryNuma) {
+            std::string hugePages = "memory backed by huge pages: " + std::to_string(ctx->getHugePagesMemory()) + "MB of " +
+                    std::to_string(ctx->getAllocatedMemory()) + "MB allocated";
+            if (ctx->memoryHugePages == MEMORY_HUGE_PAGES_THP)
+                hugePages += ", transparent huge pages in use: " + std::to_string(Ctx::getThpMemory()) + "MB";
+            if (ctx->memoryNuma)
+                hugePages += ", chunks taken from remote NUMA node: " + std::to_string(ctx->getRemoteNodeChunks());
+            ctx->info(0, "Oracle replicator for: " + database + " " + hugePages);
+        }
 
         if (ctx->trace & TRACE_THREADS) {
             std::ostringstream ss;
@@ -263,13 +293,30 @@ namespace OpenLogReplicator {
             if (reader->getGroup() == group)
                 return reader;
 
-        auto readerFS = new ReaderFilesystem(ctx, alias + "-reader-" + std::to_string(group) , database, group,
+        Reader* readerNew = readerSpawn(group, alias + "-reader-" + std::to_string(group));
+        if (group == 0)
+            archReaders.push_back(readerNew);
+        return readerNew;
+    }
+
+    Reader* Replicator::readerSpawn(int64_t group, const std::string& name) {
+        Reader* readerNew;
+        // Online redo logs are overwritten by the database, so only archived redo logs can be memory mapped
+        if (group == 0 && ctx->readEngine == READ_ENGINE_MMAP)
+            readerNew = new ReaderMmap(ctx, name, database, group,
+                                       metadata->dbBlockChecksum != "OFF" && metadata->dbBlockChecksum != "FALSE");
+        // Archived redo logs might be compressed
+        else if (group == 0)
+            readerNew = new ReaderCompressed(ctx, name, database, group,
                                              metadata->dbBlockChecksum != "OFF" && metadata->dbBlockChecksum != "FALSE");
-        readers.insert(readerFS);
-        readerFS->initialize();
+        else
+            readerNew = new ReaderFilesystem(ctx, name, database, group,
+                                             metadata->dbBlockChecksum != "OFF" && metadata->dbBlockChecksum != "FALSE");
+        readers.insert(readerNew);
+        readerNew->initialize();
 
-        ctx->spawnThread(readerFS);
-        return readerFS;
+        ctx->spawnThread(readerNew);
+        return readerNew;
     }
 
     void Replicator::checkOnlineRedoLogs() {
@@ -322,8 +369,10 @@ namespace OpenLogReplicator {
         uint64_t sequence = 0;
         uint64_t i = 0;
         uint64_t j = 0;
+        // Compressed archived redo log has the compression suffix appended to the name
+        uint64_t fileLength = file.length() - strlen(ReaderCompressed::COMPRESSION_SUFFIX[ReaderCompressed::getCompression(file)]);
 
-        while (i < replicator->metadata->logArchiveFormat.length() && j < file.length()) {
+        while (i < replicator->metadata->logArchiveFormat.length() && j < fileLength) {
             if (replicator->metadata->logArchiveFormat[i] == '%') {
                 if (i + 1 >= replicator->metadata->logArchiveFormat.length()) {
                     replicator->ctx->warning(60028, "can't get sequence from file: " + file + " log_archive_format: " +
@@ -338,7 +387,7 @@ namespace OpenLogReplicator {
                         replicator->metadata->logArchiveFormat[i + 1] == 'd') {
                     // Some [0-9]*
                     uint64_t number = 0;
-                    while (j < file.length() && file[j] >= '0' && file[j] <= '9') {
+                    while (j < fileLength && file[j] >= '0' && file[j] <= '9') {
                         number = number * 10 + (file[j] - '0');
                         ++j;
                         ++digits;
@@ -349,7 +398,7 @@ namespace OpenLogReplicator {
                     i += 2;
                 } else if (replicator->metadata->logArchiveFormat[i + 1] == 'h') {
                     // Some [0-9a-z]*
-                    while (j < file.length() && ((file[j] >= '0' && file[j] <= '9') || (file[j] >= 'a' && file[j] <= 'z'))) {
+                    while (j < fileLength && ((file[j] >= '0' && file[j] <= '9') || (file[j] >= 'a' && file[j] <= 'z'))) {
                         ++j;
                         ++digits;
                     }
@@ -373,7 +422,7 @@ namespace OpenLogReplicator {
             }
         }
 
-        if (i == replicator->metadata->logArchiveFormat.length() && j == file.length())
+        if (i == replicator->metadata->logArchiveFormat.length() && j == fileLength)
             return sequence;
 
         replicator->ctx->warning(60028, "error getting sequence from file: " + file + " log_archive_format: " +
@@ -447,6 +496,46 @@ namespace OpenLogReplicator {
         if (replicator->ctx->trace & TRACE_ARCHIVE_LIST)
             replicator->ctx->logTrace(TRACE_ARCHIVE_LIST, "checking path: " + mappedPath);
 
+        // Directories are scanned only at start and when inotify events are lost
+        if (replicator->ctx->archDiscovery == ARCH_DISCOVERY_INOTIFY && replicator->archWatchInit(mappedPath)) {
+            replicator->archWatchRead();
+
+            if (replicator->archWatchRescan) {
+                replicator->archWatchRescan = false;
+                replicator->archWatchFiles.clear();
+
+                DIR* dir;
+                if ((dir = opendir(mappedPath.c_str())) == nullptr)
+                    throw RuntimeException(10012, "directory: " + mappedPath + " - can't read");
+
+                struct dirent* ent;
+                while ((ent = readdir(dir)) != nullptr && !replicator->archWatchDisabled) {
+                    if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+                        continue;
+
+                    struct stat fileStat;
+                    std::string mappedSubPath(mappedPath + "/" + ent->d_name);
+                    if (stat(mappedSubPath.c_str(), &fileStat)) {
+                        replicator->ctx->warning(60034, "file: " + mappedSubPath + " - stat returned: " + strerror(errno));
+                        continue;
+                    }
+
+                    if (!S_ISDIR(fileStat.st_mode))
+                        continue;
+
+                    // The watch is added first, so no file created during the scan is missed
+                    if (replicator->archWatchAdd(mappedSubPath, false) != -1)
+                        replicator->archWatchScanDir(mappedSubPath);
+                }
+                closedir(dir);
+            }
+
+            if (!replicator->archWatchDisabled) {
+                replicator->archWatchQueue();
+                return;
+            }
+        }
+
         DIR* dir;
         if ((dir = opendir(mappedPath.c_str())) == nullptr)
             throw RuntimeException(10012, "directory: " + mappedPath + " - can't read");
@@ -602,6 +691,219 @@ namespace OpenLogReplicator {
         replicator->redoLogsBatch.clear();
     }
 
+    bool Replicator::archWatchInit(const std::string& path __attribute__((unused))) {
+#if __linux__
+        if (archWatchDisabled)
+            return false;
+        if (archWatchDes != -1 && archWatchPath == path)
+            return true;
+
+        archWatchClose();
+        archWatchDes = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (archWatchDes == -1) {
+            ctx->warning(60038, "inotify_init returned: " + std::string(strerror(errno)) + ", falling back to directory scan");
+            archWatchDisabled = true;
+            return false;
+        }
+
+        archWatchPath = path;
+        archWatchRootWd = archWatchAdd(path, true);
+        if (archWatchRootWd == -1) {
+            if (!archWatchDisabled)
+                throw RuntimeException(10012, "directory: " + path + " - can't read");
+            return false;
+        }
+        archWatchRescan = true;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    int Replicator::archWatchAdd(const std::string& path __attribute__((unused)), bool root __attribute__((unused))) {
+#if __linux__
+        // Directories for every day are created in the root directory, archived redo logs are complete when closed or moved
+        uint32_t mask = root ? (IN_CREATE | IN_MOVED_TO | IN_ONLYDIR) : (IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM);
+        int wd = inotify_add_watch(archWatchDes, path.c_str(), mask);
+        if (wd == -1) {
+            // The directory might be already deleted
+            if (errno == ENOENT)
+                return -1;
+
+            ctx->warning(60038, "directory: " + path + " - inotify_add_watch returned: " + strerror(errno) + ", falling back to directory scan");
+            archWatchClose();
+            archWatchDisabled = true;
+            return -1;
+        }
+
+        if (ctx->trace & TRACE_ARCHIVE_LIST)
+            ctx->logTrace(TRACE_ARCHIVE_LIST, "watching path: " + path);
+        archWatchDirs[wd] = path;
+        return wd;
+#else
+        return -1;
+#endif
+    }
+
+    void Replicator::archWatchClose() {
+        if (archWatchDes != -1) {
+            close(archWatchDes);
+            archWatchDes = -1;
+        }
+        archWatchRootWd = -1;
+        archWatchPath = "";
+        archWatchDirs.clear();
+        archWatchFiles.clear();
+    }
+
+    bool Replicator::archWatchRead() {
+        bool found = false;
+#if __linux__
+        alignas(struct inotify_event) char buffer[16384];
+
+        while (archWatchDes != -1) {
+            int64_t length = read(archWatchDes, buffer, sizeof(buffer));
+            if (length == -1) {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN) {
+                    ctx->warning(60038, "inotify read returned: " + std::string(strerror(errno)) + ", falling back to directory scan");
+                    archWatchClose();
+                    archWatchDisabled = true;
+                }
+                break;
+            }
+
+            for (char* ptr = buffer; ptr < buffer + length && archWatchDes != -1; ) {
+                auto event = reinterpret_cast<const struct inotify_event*>(ptr);
+                ptr += sizeof(struct inotify_event) + event->len;
+
+                // Events are lost, all directories need to be scanned
+                if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                    if (ctx->trace & TRACE_ARCHIVE_LIST)
+                        ctx->logTrace(TRACE_ARCHIVE_LIST, "inotify event queue overflow");
+                    archWatchRescan = true;
+                    continue;
+                }
+
+                if ((event->mask & IN_IGNORED) != 0) {
+                    archWatchDirs.erase(event->wd);
+                    continue;
+                }
+
+                auto archWatchDirsIt = archWatchDirs.find(event->wd);
+                if (event->len == 0 || archWatchDirsIt == archWatchDirs.end())
+                    continue;
+                std::string path(archWatchDirsIt->second + "/" + event->name);
+
+                if (event->wd == archWatchRootWd) {
+                    // Files might be created before the watch is added
+                    if ((event->mask & IN_ISDIR) != 0 && archWatchAdd(path, false) != -1)
+                        archWatchScanDir(path);
+                    continue;
+                }
+
+                if ((event->mask & IN_ISDIR) != 0)
+                    continue;
+
+                if ((event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+                    archWatchFiles.erase(path);
+                    continue;
+                }
+
+                if (ctx->trace & TRACE_ARCHIVE_LIST)
+                    ctx->logTrace(TRACE_ARCHIVE_LIST, "checking path: " + path);
+                typeSeq sequence = getSequenceFromFileName(this, event->name);
+                if (ctx->trace & TRACE_ARCHIVE_LIST)
+                    ctx->logTrace(TRACE_ARCHIVE_LIST, "found seq: " + std::to_string(sequence));
+
+                if (sequence == 0 || sequence < metadata->sequence)
+                    continue;
+
+                archWatchFiles[path] = sequence;
+                if (sequence == metadata->sequence)
+                    found = true;
+            }
+        }
+#endif
+        return found;
+    }
+
+    void Replicator::archWatchScanDir(const std::string& path) {
+        DIR* dir;
+        if ((dir = opendir(path.c_str())) == nullptr) {
+            // The directory might be already deleted
+            if (ctx->trace & TRACE_ARCHIVE_LIST)
+                ctx->logTrace(TRACE_ARCHIVE_LIST, "directory: " + path + " - can't read");
+            return;
+        }
+
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != nullptr) {
+            if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+                continue;
+
+            std::string fileName(path + "/" + ent->d_name);
+            if (ctx->trace & TRACE_ARCHIVE_LIST)
+                ctx->logTrace(TRACE_ARCHIVE_LIST, "checking path: " + fileName);
+
+            typeSeq sequence = getSequenceFromFileName(this, ent->d_name);
+
+            if (ctx->trace & TRACE_ARCHIVE_LIST)
+                ctx->logTrace(TRACE_ARCHIVE_LIST, "found seq: " + std::to_string(sequence));
+
+            if (sequence == 0 || sequence < metadata->sequence)
+                continue;
+
+            archWatchFiles[fileName] = sequence;
+        }
+        closedir(dir);
+    }
+
+    void Replicator::archWatchQueue() {
+        for (auto archWatchFilesIt = archWatchFiles.begin(); archWatchFilesIt != archWatchFiles.end(); ) {
+            // Already processed
+            if (archWatchFilesIt->second < metadata->sequence) {
+                archWatchFilesIt = archWatchFiles.erase(archWatchFilesIt);
+                continue;
+            }
+
+            auto parser = new Parser(ctx, builder, metadata, transactionBuffer, 0, archWatchFilesIt->first);
+            parser->firstScn = ZERO_SCN;
+            parser->nextScn = ZERO_SCN;
+            parser->sequence = archWatchFilesIt->second;
+            archiveRedoQueue.push(parser);
+            ++archWatchFilesIt;
+        }
+    }
+
+    void Replicator::archWait() {
+#if __linux__
+        if (archWatchDes != -1) {
+            // Wake up as soon as the expected archived redo log is created
+            time_t endTime = Timer::getTime() + static_cast<time_t>(ctx->archReadSleepUs);
+            while (!ctx->softShutdown && !archWatchRescan && archWatchDes != -1) {
+                time_t nowTime = Timer::getTime();
+                if (nowTime >= endTime)
+                    break;
+
+                struct pollfd pollDes = {archWatchDes, POLLIN, 0};
+                int retPoll = poll(&pollDes, 1, static_cast<int>((endTime - nowTime + 999) / 1000));
+                if (retPoll < 0 && errno != EINTR)
+                    break;
+
+                if (retPoll > 0 && archWatchRead()) {
+                    if (ctx->trace & TRACE_ARCHIVE_LIST)
+                        ctx->logTrace(TRACE_ARCHIVE_LIST, "archived redo log created for seq: " + std::to_string(metadata->sequence));
+                    break;
+                }
+            }
+            return;
+        }
+#endif
+        usleep(ctx->archReadSleepUs);
+    }
+
     bool parserCompare::operator()(Parser* const& p1, Parser* const& p2) {
         return p1->sequence > p2->sequence;
     }
@@ -677,7 +979,7 @@ namespace OpenLogReplicator {
                     if (ctx->trace & TRACE_ARCHIVE_LIST)
                         ctx->logTrace(TRACE_ARCHIVE_LIST, "archived redo log missing for seq: " + std::to_string(metadata->sequence) +
                                       ", sleeping");
-                    usleep(ctx->archReadSleepUs);
+                    archWait();
                 } else {
                     break;
                 }
@@ -706,36 +1008,72 @@ namespace OpenLogReplicator {
                 } else if (parser->sequence > metadata->sequence) {
                     ctx->warning(60027, "couldn't find archive log for seq: " + std::to_string(metadata->sequence) + ", found: " +
                                  std::to_string(parser->sequence) + ", sleeping " + std::to_string(ctx->archReadSleepUs) + " us");
-                    usleep(ctx->archReadSleepUs);
+                    archWait();
                     cleanArchList();
                     archGetLog(this);
                     continue;
                 }
 
                 logsProcessed = true;
-                parser->reader = archReader;
-
-                archReader->fileName = parser->path;
-                uint64_t retry = ctx->archReadTries;
+                parser->reader = nullptr;
+                parser->worker = nullptr;
+
+                auto archWorkerMapIt = archWorkerMap.find(parser->sequence);
+                if (archWorkerMapIt != archWorkerMap.end()) {
+                    // The worker decodes from the beginning of the redo log
+                    if (archWorkerMapIt->second->parser->path == parser->path && metadata->offset == 0) {
+                        if (ctx->trace & TRACE_REDO)
+                            ctx->logTrace(TRACE_REDO, "using decoded archived redo log: " + parser->path);
+                        parser->worker = archWorkerMapIt->second;
+                        parser->reader = parser->worker->parser->reader;
+                    } else
+                        archCatchupRelease(parser->sequence);
+                }
 
-                while (true) {
-                    if (archReader->checkRedoLog() && archReader->updateRedoLog()) {
-                        break;
+                auto archPrefetchMapIt = archPrefetchMap.find(parser->sequence);
+                if (archPrefetchMapIt != archPrefetchMap.end()) {
+                    if (archPrefetchMapIt->second->fileName == parser->path && parser->reader == nullptr) {
+                        if (ctx->trace & TRACE_REDO)
+                            ctx->logTrace(TRACE_REDO, "using prefetched archived redo log: " + parser->path);
+                        parser->reader = archPrefetchMapIt->second;
                     }
+                    archPrefetchMap.erase(archPrefetchMapIt);
+                }
 
-                    if (retry == 0)
-                        throw RuntimeException(10009, "file: " + parser->path + " - failed to open after " +
-                                               std::to_string(ctx->archReadTries) + " tries");
-
-                    ctx->info(0, "archived redo log " + parser->path + " is not ready for read, sleeping " +
-                              std::to_string(ctx->archReadSleepUs) + " us");
-                    usleep(ctx->archReadSleepUs);
-                    --retry;
+                if (parser->reader != nullptr) {
+                    archReader = parser->reader;
+                } else {
+                    parser->reader = archReader;
+                    archReader->fileName = parser->path;
+                    uint64_t retry = ctx->archReadTries;
+
+                    while (true) {
+                        if (archReader->checkRedoLog() && archReader->updateRedoLog()) {
+                            break;
+                        }
+
+                        if (retry == 0)
+                            throw RuntimeException(10009, "file: " + parser->path + " - failed to open after " +
+                                                   std::to_string(ctx->archReadTries) + " tries");
+
+                        ctx->info(0, "archived redo log " + parser->path + " is not ready for read, sleeping " +
+                                  std::to_string(ctx->archReadSleepUs) + " us");
+                        usleep(ctx->archReadSleepUs);
+                        --retry;
+                    }
                 }
 
+                archReader->setBufferSizeLimit(ctx->bufferSizeMax);
+                archCatchup();
+                archPrefetch();
+
                 ret = parser->parse();
                 metadata->firstScn = parser->firstScn;
                 metadata->nextScn = parser->nextScn;
+                if (parser->worker != nullptr) {
+                    parser->worker = nullptr;
+                    archCatchupRelease(parser->sequence);
+                }
 
                 if (ctx->softShutdown)
                     break;
@@ -769,9 +1107,171 @@ namespace OpenLogReplicator {
                 break;
         }
 
+        archCatchupRelease(ZERO_SEQ);
+        archPrefetchRelease(ZERO_SEQ);
         return logsProcessed;
     }
 
+    Reader* Replicator::archReaderIdle() {
+        for (Reader* reader : archReaders) {
+            bool prefetching = false;
+            for (auto archPrefetchMapIt : archPrefetchMap) {
+                if (archPrefetchMapIt.second == reader) {
+                    prefetching = true;
+                    break;
+                }
+            }
+
+            for (auto archWorkerMapIt : archWorkerMap) {
+                if (archWorkerMapIt.second->parser->reader == reader) {
+                    prefetching = true;
+                    break;
+                }
+            }
+
+            if (!prefetching && reader != archReader)
+                return reader;
+        }
+
+        // All readers are busy, the prefetch depth might have been increased
+        Reader* reader = readerSpawn(0, alias + "-reader-0-" + std::to_string(archReaders.size()));
+        archReaders.push_back(reader);
+        return reader;
+    }
+
+    void Replicator::archPrefetch() {
+        if (ctx->archPrefetch == 0)
+            return;
+
+        archPrefetchRelease(metadata->sequence);
+
+        // Prefetched and decoded redo logs use together at most half of the read buffers
+        uint64_t bufferSizeLimit = (ctx->readBufferMax / 2 / (ctx->archPrefetch + ctx->archCatchupThreads)) * ctx->memoryChunkSize;
+        if (bufferSizeLimit < ctx->memoryChunkSize)
+            bufferSizeLimit = ctx->memoryChunkSize;
+
+        std::priority_queue<Parser*, std::vector<Parser*>, parserCompare> archiveRedoQueueNext(archiveRedoQueue);
+        typeSeq sequence = metadata->sequence;
+        while (!archiveRedoQueueNext.empty() && sequence < metadata->sequence + ctx->archPrefetch && !ctx->softShutdown) {
+            Parser* parser = archiveRedoQueueNext.top();
+            archiveRedoQueueNext.pop();
+
+            if (parser->sequence <= metadata->sequence)
+                continue;
+            // Only consecutive redo logs are prefetched
+            if (parser->sequence != sequence + 1)
+                break;
+            sequence = parser->sequence;
+
+            if (archPrefetchMap.find(sequence) != archPrefetchMap.end() || archWorkerMap.find(sequence) != archWorkerMap.end())
+                continue;
+
+            Reader* reader = archReaderIdle();
+            reader->fileName = parser->path;
+            reader->setBufferSizeLimit(bufferSizeLimit);
+            if (!reader->checkRedoLog() || !reader->updateRedoLog())
+                break;
+
+            if (ctx->trace & TRACE_REDO)
+                ctx->logTrace(TRACE_REDO, "prefetching archived redo log: " + parser->path + " seq: " + std::to_string(sequence));
+            archPrefetchMap[sequence] = reader;
+            reader->setStatusRead();
+        }
+    }
+
+    void Replicator::archPrefetchRelease(typeSeq sequence) {
+        for (auto archPrefetchMapIt = archPrefetchMap.begin(); archPrefetchMapIt != archPrefetchMap.end(); ) {
+            if (sequence == ZERO_SEQ || archPrefetchMapIt->first <= sequence) {
+                // Stop reading and release the buffers
+                archPrefetchMapIt->second->updateRedoLog();
+                archPrefetchMapIt = archPrefetchMap.erase(archPrefetchMapIt);
+            } else
+                ++archPrefetchMapIt;
+        }
+    }
+
+    void Replicator::archCatchup() {
+        if (ctx->archCatchupThreads == 0 || ctx->dumpRedoLog > 0)
+            return;
+
+        archCatchupRelease(metadata->sequence - 1);
+
+        // Prefetched and decoded redo logs use together at most half of the read buffers
+        uint64_t bufferSizeLimit = (ctx->readBufferMax / 2 / (ctx->archPrefetch + ctx->archCatchupThreads)) * ctx->memoryChunkSize;
+        if (bufferSizeLimit < ctx->memoryChunkSize)
+            bufferSizeLimit = ctx->memoryChunkSize;
+        // Decoded LWNs waiting for the ordered stage use together at most as much memory as the read buffers
+        uint64_t lwnsSizeMax = (ctx->readBufferMax / ctx->archCatchupThreads) * ctx->memoryChunkSize;
+        if (lwnsSizeMax < ctx->memoryChunkSize)
+            lwnsSizeMax = ctx->memoryChunkSize;
+
+        std::priority_queue<Parser*, std::vector<Parser*>, parserCompare> archiveRedoQueueNext(archiveRedoQueue);
+        typeSeq sequence = metadata->sequence;
+        while (!archiveRedoQueueNext.empty() && sequence < metadata->sequence + ctx->archCatchupThreads && !ctx->softShutdown) {
+            Parser* parser = archiveRedoQueueNext.top();
+            archiveRedoQueueNext.pop();
+
+            if (parser->sequence <= metadata->sequence)
+                continue;
+            // Only consecutive redo logs are decoded, the ordered stage takes them in sequence order
+            if (parser->sequence != sequence + 1)
+                break;
+            sequence = parser->sequence;
+
+            if (archWorkerMap.find(sequence) != archWorkerMap.end())
+                continue;
+
+            // Redo log which is already prefetched is taken over by the worker
+            Reader* reader = nullptr;
+            auto archPrefetchMapIt = archPrefetchMap.find(sequence);
+            if (archPrefetchMapIt != archPrefetchMap.end()) {
+                if (archPrefetchMapIt->second->fileName == parser->path)
+                    reader = archPrefetchMapIt->second;
+                else
+                    archPrefetchMapIt->second->updateRedoLog();
+                archPrefetchMap.erase(archPrefetchMapIt);
+            }
+
+            if (reader == nullptr) {
+                reader = archReaderIdle();
+                reader->fileName = parser->path;
+                reader->setBufferSizeLimit(bufferSizeLimit);
+                if (!reader->checkRedoLog() || !reader->updateRedoLog())
+                    break;
+            }
+
+            if (ctx->trace & TRACE_REDO)
+                ctx->logTrace(TRACE_REDO, "decoding archived redo log: " + parser->path + " seq: " + std::to_string(sequence));
+            auto parserWorker = new Parser(ctx, builder, metadata, transactionBuffer, 0, parser->path);
+            parserWorker->sequence = parser->sequence;
+            parserWorker->firstScn = parser->firstScn;
+            parserWorker->nextScn = parser->nextScn;
+            parserWorker->reader = reader;
+            auto worker = new ParserWorker(ctx, alias + "-parser-" + std::to_string(sequence), parserWorker, lwnsSizeMax, 2, true);
+            archWorkerMap[sequence] = worker;
+            reader->setStatusRead();
+            ctx->spawnThread(worker);
+        }
+    }
+
+    void Replicator::archCatchupRelease(typeSeq sequence) {
+        for (auto archWorkerMapIt = archWorkerMap.begin(); archWorkerMapIt != archWorkerMap.end(); ) {
+            if (sequence == ZERO_SEQ || archWorkerMapIt->first <= sequence) {
+                ParserWorker* worker = archWorkerMapIt->second;
+                Reader* reader = worker->parser->reader;
+                worker->cancel();
+                ctx->finishThread(worker);
+                delete worker;
+
+                // Stop reading and release the buffers, unless the reader continues as the main archived redo log reader
+                if (reader != archReader)
+                    reader->updateRedoLog();
+                archWorkerMapIt = archWorkerMap.erase(archWorkerMapIt);
+            } else
+                ++archWorkerMapIt;
+        }
+    }
+
     bool Replicator::processOnlineRedoLogs() {
         uint64_t ret = REDO_OK;
         Parser* parser;
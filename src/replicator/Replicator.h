@@ -18,6 +18,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 <http://www.gnu.org/licenses/>.  */
 
 #include <fstream>
+#include <map>
 #include <queue>
 #include <set>
 #include <unordered_map>
@@ -33,6 +34,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 
 namespace OpenLogReplicator {
     class Parser;
+    class ParserWorker;
     class Builder;
     class Metadata;
     class Reader;
@@ -55,7 +57,18 @@ namespace OpenLogReplicator {
         std::string redoCopyPath;
         // Redo log files
         Reader* archReader;
+        std::vector<Reader*> archReaders;
+        std::map<typeSeq, Reader*> archPrefetchMap;
+        std::map<typeSeq, ParserWorker*> archWorkerMap;
         std::string lastCheckedDay;
+        // Archived redo log discovery using inotify
+        int archWatchDes;
+        int archWatchRootWd;
+        bool archWatchRescan;
+        bool archWatchDisabled;
+        std::string archWatchPath;
+        std::unordered_map<int, std::string> archWatchDirs;
+        std::map<std::string, typeSeq> archWatchFiles;
         std::priority_queue<Parser*, std::vector<Parser*>, parserCompare> archiveRedoQueue;
         std::set<Parser*> onlineRedoSet;
         std::set<Reader*> readers;
@@ -65,6 +78,19 @@ namespace OpenLogReplicator {
         void cleanArchList();
         void updateOnlineLogs();
         void readerDropAll(void);
+        Reader* readerSpawn(int64_t group, const std::string& name);
+        Reader* archReaderIdle();
+        void archPrefetch();
+        void archPrefetchRelease(typeSeq sequence);
+        void archCatchup();
+        void archCatchupRelease(typeSeq sequence);
+        bool archWatchInit(const std::string& path);
+        int archWatchAdd(const std::string& path, bool root);
+        void archWatchClose();
+        bool archWatchRead();
+        void archWatchScanDir(const std::string& path);
+        void archWatchQueue();
+        void archWait();
         static uint64_t getSequenceFromFileName(Replicator* replicator, const std::string& file);
         virtual const char* getModeName() const;
         virtual bool checkConnection();
@@ -25,6 +25,7 @@ along with OpenLogReplicator; see the file LICENSE;  If not see
 #include "../common/Ctx.h"
 #include "../common/DataException.h"
 #include "../common/NetworkException.h"
+#include "../common/PerfStats.h"
 #include "../common/RuntimeException.h"
 #include "../metadata/Metadata.h"
 #include "Writer.h"
@@ -40,6 +41,7 @@ namespace OpenLogReplicator {
             confirmedScn(ZERO_SCN),
             confirmedMessages(0),
             sentMessages(0),
+            outputHash(PERF_HASH_INIT),
             currentQueueSize(0),
             maxQueueSize(0),
             queue(nullptr),
@@ -61,6 +63,11 @@ namespace OpenLogReplicator {
 
     void Writer::createMessage(BuilderMsg* msg) {
         ++sentMessages;
+        if (ctx->perfStats != nullptr) {
+            // The message may be released by sendMessage()
+            outputHash = PerfStats::hash(outputHash, msg->data, msg->length);
+            ctx->perfStats->add(PERF_STAGE_WRITER, msg->length, 1);
+        }
 
         queue[currentQueueSize++] = msg;
         if (currentQueueSize > maxQueueSize)
@@ -181,6 +188,9 @@ namespace OpenLogReplicator {
             ctx->stopHard();
         }
 
+        if (ctx->perfStats != nullptr)
+            ctx->perfStats->addOutput(outputHash, sentMessages);
+
         ctx->info(0, "writer is stopping: " + getName() + ", max queue size: " + std::to_string(maxQueueSize));
         if (ctx->trace & TRACE_THREADS) {
             std::ostringstream ss;
@@ -256,9 +266,11 @@ namespace OpenLogReplicator {
                 oldLength += sizeof(struct BuilderMsg);
 
                 // Message in one part - send directly from buffer
-                if (oldLength + length8 <= OUTPUT_BUFFER_DATA_SIZE) {
+                if (oldLength + length8 <= builder->outputBufferDataSize()) {
                     createMessage(msg);
+                    PerfScope perfScope(ctx->perfStats, PERF_STAGE_WRITER);
                     sendMessage(msg);
+                    perfScope.stop();
                     oldLength += length8;
 
                 // Message in many parts - merge & copy
@@ -277,7 +289,7 @@ namespace OpenLogReplicator {
                             memcpy(reinterpret_cast<void*>(msg->data + copied),
                                    reinterpret_cast<const void*>(builderQueue->data + oldLength), toCopy);
                             builderQueue = builderQueue->next;
-                            newLength = OUTPUT_BUFFER_DATA_SIZE;
+                            newLength = builder->outputBufferDataSize();
                             oldLength = 0;
                         } else {
                             memcpy(reinterpret_cast<void*>(msg->data + copied),
@@ -288,7 +300,9 @@ namespace OpenLogReplicator {
                     }
 
                     createMessage(msg);
+                    PerfScope perfScope(ctx->perfStats, PERF_STAGE_WRITER);
                     sendMessage(msg);
+                    perfScope.stop();
                     pollQueue();
                     writeCheckpoint(false);
                     break;
@@ -37,6 +37,7 @@ namespace OpenLogReplicator {
         typeScn confirmedScn;
         uint64_t confirmedMessages;
         uint64_t sentMessages;
+        uint64_t outputHash;
         uint64_t currentQueueSize;
         uint64_t maxQueueSize;
         BuilderMsg** queue;
@@ -0,0 +1,41 @@
+/* Header for WriterDiscard class
+   Copyright (C) 2018-2023 Adam Leszczynski (aleszczynski@bersler.com)
+
+This file is part of OpenLogReplicator.
+
+OpenLogReplicator is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+OpenLogReplicator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OpenLogReplicator; see the file LICENSE;  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include "Writer.h"
+
+#ifndef WRITER_DISCARD_H_
+#define WRITER_DISCARD_H_
+
+namespace OpenLogReplicator {
+    // Confirms messages without sending them anywhere, used to measure the replication without the cost of the target
+    class WriterDiscard : public Writer {
+    protected:
+        void sendMessage(BuilderMsg* msg) override;
+        std::string getName() const override;
+        void pollQueue() override;
+
+    public:
+        WriterDiscard(Ctx* newCtx, const std::string& newAlias, const std::string& newDatabase, Builder* newBuilder, Metadata* newMetadata);
+        ~WriterDiscard() override;
+
+        void initialize() override;
+    };
+}
+
+#endif